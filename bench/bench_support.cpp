@@ -0,0 +1,330 @@
+#include "bench_support.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ---- Allocation counting ----
+
+namespace {
+std::atomic<uint64_t> allocCount{0};
+std::atomic<uint64_t> allocBytes{0};
+thread_local bool countAllocations = true;
+} // namespace
+
+void resetAllocationCounters() {
+    allocCount = 0;
+    allocBytes = 0;
+}
+
+uint64_t allocationCount() { return allocCount.load(); }
+uint64_t allocationBytes() { return allocBytes.load(); }
+void setCountAllocations(bool enabled) { countAllocations = enabled; }
+
+
+void* operator new(std::size_t size) {
+    if (countAllocations) {
+        allocCount.fetch_add(1, std::memory_order_relaxed);
+        allocBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return ::operator new(size, tag); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"   // free() is the match for the malloc() above
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+void operator delete[](void* p) noexcept { ::operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { ::operator delete(p); }
+
+// ---- Synthetic GGUF writer ----
+
+namespace {
+constexpr uint64_t HIDDEN = 4096;
+constexpr uint32_t ALIGNMENT = 32;
+} // namespace
+
+uint64_t writeSyntheticGGUF(const std::string& path, const SyntheticSpec& spec) {
+    // token_embd + 9 per block + output_norm / output
+    const uint64_t layers = std::max<uint64_t>(1, spec.tensors > 3 ? (spec.tensors - 3) / 9 : 0);
+
+    GGUFWriter kv;
+    auto core = [&]() {
+        kv.keyU32("llama.context_length", 4096);
+        kv.keyU32("llama.embedding_length", static_cast<uint32_t>(HIDDEN));
+        kv.keyU32("llama.feed_forward_length", 11008);
+        kv.keyU32("llama.attention.head_count", 32);
+        kv.keyU32("llama.attention.head_count_kv", 8);
+        kv.keyU32("llama.block_count", static_cast<uint32_t>(layers));
+    };
+
+    kv.keyStr("general.architecture", "llama");
+    kv.keyStr("general.name", "synthetic");
+    kv.keyU32("general.file_type", 15);
+    kv.keyU32("general.alignment", ALIGNMENT);
+    if (spec.coreFirst)
+        core();
+    for (uint64_t i = 0; i < spec.keys; ++i) {
+        char key[48];
+        std::snprintf(key, sizeof key, "synthetic.key.%06llu", static_cast<unsigned long long>(i));
+        switch (i % 4) {
+            case 0: kv.keyU32(key, static_cast<uint32_t>(i)); break;
+            case 1: kv.keyStr(key, "a moderately long string value for a filler key"); break;
+            case 2: kv.keyBool(key, i % 3 == 0); break;
+            default:
+                kv.arrayHeader(key, 6, 16);
+                for (int j = 0; j < 16; ++j)
+                    kv.f32(static_cast<float>(j));
+        }
+    }
+    kv.keyStr("tokenizer.ggml.model", "llama");
+    kv.arrayHeader("tokenizer.ggml.tokens", 8, spec.vocab);
+    for (uint64_t i = 0; i < spec.vocab; ++i)
+        kv.str("<tok_" + std::to_string(i) + ">");
+    kv.arrayHeader("tokenizer.ggml.scores", 6, spec.vocab);
+    for (uint64_t i = 0; i < spec.vocab; ++i)
+        kv.f32(-static_cast<float>(i));
+    kv.arrayHeader("tokenizer.ggml.token_type", 5, spec.vocab);
+    for (uint64_t i = 0; i < spec.vocab; ++i)
+        kv.u32(1);
+    if (!spec.coreFirst)
+        core();
+
+    static const char* const blockTensors[] = {
+        "attn_norm", "attn_q", "attn_k", "attn_v", "attn_output", "ffn_norm", "ffn_gate", "ffn_up", "ffn_down",
+    };
+    GGUFWriter info;
+    uint64_t offset = 0;
+    auto tensor = [&](const std::string& name, uint64_t ne0, uint64_t ne1) {
+        bool norm = ne1 == 1;
+        info.str(name);
+        info.u32(norm ? 1 : 2);
+        info.u64(ne0);
+        if (!norm)
+            info.u64(ne1);
+        info.u32(norm ? 0 : 12);            // F32 norms, Q4_K matrices
+        info.u64(offset);
+        uint64_t bytes = norm ? ne0 * 4 : ne0 * ne1 / 256 * 144;
+        offset += (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    };
+    uint64_t written = 0;
+    if (written++ < spec.tensors)
+        tensor("token_embd.weight", HIDDEN, std::max<uint64_t>(spec.vocab, 1));
+    for (uint64_t il = 0; written < spec.tensors && il < layers; ++il)
+        for (const char* name : blockTensors) {
+            if (written >= spec.tensors)
+                break;
+            bool norm = std::strstr(name, "norm") != nullptr;
+            tensor("blk." + std::to_string(il) + "." + name + ".weight", HIDDEN, norm ? 1 : HIDDEN);
+            ++written;
+        }
+    for (uint64_t extra = 0; written < spec.tensors; ++extra, ++written) {
+        if (extra < 2)
+            tensor(extra == 0 ? "output_norm.weight" : "output.weight", HIDDEN, extra == 0 ? 1 : HIDDEN);
+        else
+            tensor("extra." + std::to_string(extra - 2) + ".weight", HIDDEN, HIDDEN);
+    }
+
+    GGUFWriter file;
+    file.u32(0x46554747);   // "GGUF"
+    file.u32(3);
+    file.u64(spec.tensors);
+    file.u64(kv.keyCount);
+    std::string header = file.out + kv.out + info.out;
+    header.resize((header.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, '\0');
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(header.data(), static_cast<std::streamsize>(header.size()));
+        if (!out)
+            throw std::runtime_error("Failed to write " + path);
+    }
+    uint64_t fileSize = header.size() + offset;
+    std::filesystem::resize_file(path, fileSize);
+    return fileSize;
+}
+
+// ---- Range-serving HTTP stand-in ----
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void delay(double ms) {
+    if (ms > 0)
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms));
+}
+
+bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+RangeServer::RangeServer(const std::string& path, double rttMs, double bytesPerSecond)
+    : rttMs(rttMs), bytesPerSecond(bytesPerSecond) {
+    fileFd = ::open(path.c_str(), O_RDONLY);
+    if (fileFd < 0)
+        throw std::runtime_error("Failed to open " + path);
+    fileSize = static_cast<uint64_t>(::lseek(fileFd, 0, SEEK_END));
+
+    listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof addr;
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0 ||
+        ::listen(listenFd, 64) != 0 ||
+        ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+        throw std::runtime_error("Failed to listen on 127.0.0.1");
+    port = ntohs(addr.sin_port);
+    acceptThread = std::thread([this]() { acceptLoop(); });
+}
+
+RangeServer::~RangeServer() {
+    stopping = true;
+    acceptThread.join();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int fd : connections)
+            ::shutdown(fd, SHUT_RDWR);
+    }
+    for (auto& thread : threads)
+        thread.join();
+    ::close(listenFd);
+    ::close(fileFd);
+}
+
+void RangeServer::acceptLoop() {
+    countAllocations = false;
+    while (!stopping) {
+        pollfd p{listenFd, POLLIN, 0};
+        if (::poll(&p, 1, 50) <= 0)
+            continue;
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+        ++connectionsOpened;
+        std::lock_guard<std::mutex> lock(mutex);
+        connections.insert(fd);
+        threads.emplace_back([this, fd]() { serve(fd); });
+    }
+}
+
+void RangeServer::serve(int fd) {
+    countAllocations = false;
+    delay(rttMs);
+    std::string pending;
+    char buffer[16 * 1024];
+    while (!stopping) {
+        size_t headerEnd;
+        while ((headerEnd = pending.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = ::recv(fd, buffer, sizeof buffer, 0);
+            if (n <= 0)
+                goto done;
+            pending.append(buffer, static_cast<size_t>(n));
+        }
+        std::string request = pending.substr(0, headerEnd);
+        pending.erase(0, headerEnd + 4);
+        std::transform(request.begin(), request.end(), request.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        ++requests;
+        delay(rttMs);
+        if (!respond(fd, request))
+            break;
+    }
+done:
+    std::lock_guard<std::mutex> lock(mutex);
+    connections.erase(fd);
+    ::close(fd);
+}
+
+bool RangeServer::respond(int fd, const std::string& request) {
+    bool head = request.compare(0, 5, "head ") == 0;
+    uint64_t first = 0;
+    uint64_t last = fileSize ? fileSize - 1 : 0;
+    bool ranged = false;
+    size_t range = request.find("\r\nrange: bytes=");
+    if (range != std::string::npos && honourRange) {
+        const char* p = request.c_str() + range + 15;
+        char* endp = nullptr;
+        first = std::strtoull(p, &endp, 10);
+        if (*endp == '-' && endp[1] >= '0' && endp[1] <= '9')
+            last = std::min<uint64_t>(std::strtoull(endp + 1, nullptr, 10), fileSize - 1);
+        ranged = true;
+    }
+
+    std::ostringstream headers;
+    if (ranged && first >= fileSize) {
+        headers << "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" << fileSize
+                << "\r\nContent-Length: 0\r\n\r\n";
+        std::string text = headers.str();
+        return sendAll(fd, text.data(), text.size());
+    }
+    uint64_t length = fileSize ? last - first + 1 : 0;
+    headers << (ranged ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n")
+            << "Content-Length: " << length << "\r\n"
+            << "ETag: \"synthetic-" << version << "\"\r\n";
+    if (honourRange)
+        headers << "Accept-Ranges: bytes\r\n";
+    if (ranged)
+        headers << "Content-Range: bytes " << first << "-" << last << "/" << fileSize << "\r\n";
+    headers << "\r\n";
+    std::string text = headers.str();
+    if (!sendAll(fd, text.data(), text.size()) || head)
+        return true;
+
+    // Paced body
+    char chunk[16 * 1024];
+    auto start = Clock::now();
+    uint64_t sent = 0;
+    while (sent < length) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(sizeof chunk, length - sent));
+        ssize_t got = ::pread(fileFd, chunk, n, static_cast<off_t>(first + sent));
+        if (got <= 0 || !sendAll(fd, chunk, static_cast<size_t>(got)))
+            return false;
+        sent += static_cast<uint64_t>(got);
+        bytesSent += static_cast<uint64_t>(got);
+        if (bytesPerSecond > 0)
+            std::this_thread::sleep_until(start + std::chrono::duration<double>(sent / bytesPerSecond));
+    }
+    return true;
+}
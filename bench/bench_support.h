@@ -0,0 +1,151 @@
+#ifndef BENCH_SUPPORT_H
+#define BENCH_SUPPORT_H
+
+// Fixtures shared by the benchmark and the tests: a synthetic GGUF writer, a
+// range-serving HTTP stand-in and process-wide allocation counting. Linking
+// bench_support.cpp replaces the global operator new / delete.
+
+#include "gguf_reader.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// ---- Allocation counting ----
+// Every C++ heap allocation made by a counting thread since the last reset.
+// Threads count by default; the HTTP stand-in's threads opt out so only the
+// probe is measured.
+
+void resetAllocationCounters();
+uint64_t allocationCount();
+uint64_t allocationBytes();
+void setCountAllocations(bool enabled);     // For the calling thread
+
+// ---- Synthetic GGUF writer ----
+
+struct SyntheticSpec {
+    uint64_t keys = 1000;           // Filler metadata keys besides the model's own
+    uint64_t vocab = 32000;         // tokenizer.ggml.tokens / scores / token_type length
+    uint64_t tensors = 291;         // Tensor-info entries (llama-7B has 291)
+    bool coreFirst = false;         // Core llama.* keys before the filler and vocab
+};
+
+// Little-endian GGUF field encoder; keyCount counts the key* / arrayHeader calls
+class GGUFWriter {
+public:
+    void u32(uint32_t v) { raw(&v, sizeof v); }
+    void u64(uint64_t v) { raw(&v, sizeof v); }
+    void f32(float v) { raw(&v, sizeof v); }
+    void str(std::string_view s) {
+        u64(s.size());
+        out.append(s.data(), s.size());
+    }
+
+    void keyU32(std::string_view key, uint32_t v) { str(key); u32(4); u32(v); ++keyCount; }
+    void keyF32(std::string_view key, float v) { str(key); u32(6); f32(v); ++keyCount; }
+    void keyBool(std::string_view key, bool v) { str(key); u32(7); out.push_back(v ? 1 : 0); ++keyCount; }
+    void keyStr(std::string_view key, std::string_view v) { str(key); u32(8); str(v); ++keyCount; }
+    void arrayHeader(std::string_view key, uint32_t elemType, uint64_t n) {
+        str(key);
+        u32(9);
+        u32(elemType);
+        u64(n);
+        ++keyCount;
+    }
+
+    std::string out;
+    uint64_t keyCount = 0;
+
+private:
+    void raw(const void* p, size_t n) { out.append(static_cast<const char*>(p), n); }
+};
+
+// Llama-style file: 4096 hidden, 32 heads, 8 KV heads, Q4_K matrices, one
+// block per 9 tensors. Returns the file size; tensor data is left sparse.
+uint64_t writeSyntheticGGUF(const std::string& path, const SyntheticSpec& spec);
+
+// ---- Counting source ----
+
+// Forwards to a streaming source and counts what the parser pulled from it
+class CountingSource : public DataSource {
+public:
+    explicit CountingSource(DataSource& inner) : inner(inner) {}
+
+    bool read(char* buffer, size_t size) override {
+        ++calls;
+        bool ok = inner.read(buffer, size);
+        if (ok)
+            bytes += size;
+        return ok;
+    }
+    size_t readSome(char* buffer, size_t size) override {
+        ++calls;
+        size_t n = inner.readSome(buffer, size);
+        bytes += n;
+        return n;
+    }
+    bool seek(size_t position) override { return inner.seek(position); }
+    bool eof() const override { return inner.eof(); }
+    size_t tell() override { return inner.tell(); }
+    uint64_t totalSize() const override { return inner.totalSize(); }
+
+    uint64_t bytes = 0;
+    uint64_t calls = 0;
+
+private:
+    DataSource& inner;
+};
+
+// ---- Range-serving HTTP stand-in ----
+
+// HTTP/1.1 keep-alive server for one file. Each new connection costs one RTT
+// (the handshake) and each request another; bodies are paced to the
+// configured bandwidth.
+class RangeServer {
+public:
+    RangeServer(const std::string& path, double rttMs = 0, double bytesPerSecond = 0);
+    ~RangeServer();
+
+    RangeServer(const RangeServer&) = delete;
+    RangeServer& operator=(const RangeServer&) = delete;
+
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port) + "/model.gguf"; }
+
+    void resetCounters() {
+        requests = 0;
+        bytesSent = 0;
+        connectionsOpened = 0;
+    }
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> bytesSent{0};
+    std::atomic<uint64_t> connectionsOpened{0};
+
+    // Switches for the tests, safe to flip between requests
+    std::atomic<bool> honourRange{true};    // false: whole file with a 200, like a plain static server
+    std::atomic<uint32_t> version{0};       // Part of the ETag: bump it to "change" the file
+
+private:
+    void acceptLoop();
+    void serve(int fd);
+    bool respond(int fd, const std::string& request);
+
+    double rttMs;
+    double bytesPerSecond;
+    int fileFd = -1;
+    uint64_t fileSize = 0;
+    int listenFd = -1;
+    uint16_t port = 0;
+    std::atomic<bool> stopping{false};
+    std::thread acceptThread;
+    std::mutex mutex;
+    std::set<int> connections;
+    std::vector<std::thread> threads;
+};
+
+#endif // BENCH_SUPPORT_H
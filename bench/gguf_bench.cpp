@@ -0,0 +1,257 @@
+// Probe-path benchmark: writes a synthetic GGUF file and times
+// GGUFMetadataReader::readModelParams over the file source, the mmap source
+// and a local range-serving HTTP stand-in with injected latency and
+// bandwidth. Reports bytes fetched and parsed, requests, wall time and C++
+// heap allocations per probe, as a table or as JSON lines (--json).
+//
+// Native only. Build from the repository root:
+//   cmake -S . -B build && cmake --build build --target gguf_bench
+// The synthetic writer and the HTTP stand-in live in bench_support.h.
+//
+// Examples:
+//   ./gguf_bench --keys 200 --vocab 150000 --tensors 800
+//   ./gguf_bench --sources http --rtt-ms 40 --bandwidth-mbps 100 --iterations 10
+
+#include "bench_support.h"
+#include "curl_multi_loop.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// ---- Runner ----
+
+struct Sample {
+    double wallMs = 0;
+    uint64_t bytes = 0;             // Fetched from the source or the server
+    uint64_t bytesUsed = 0;         // Offset the parser stopped at (ProbeStats)
+    uint64_t requests = 0;          // Source reads (local) or HTTP requests
+    uint64_t allocs = 0;
+    uint64_t allocBytes = 0;
+};
+
+struct Options {
+    SyntheticSpec spec;
+    std::vector<std::string> sources = {"file", "mmap", "http"};
+    unsigned iterations = 20;
+    unsigned warmup = 2;
+    double rttMs = 0;
+    double bandwidthMbps = 0;       // 0: unpaced
+    bool readAhead = true;
+    bool sharedLoop = false;
+    bool json = false;
+    std::string dir = std::filesystem::temp_directory_path().string();
+};
+
+uint64_t median(std::vector<uint64_t> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+void report(const std::string& source, const Options& options, const std::vector<Sample>& samples) {
+    std::vector<double> wall;
+    std::vector<uint64_t> bytes, used, requests, allocs, allocBytesPerRun;
+    for (const auto& s : samples) {
+        wall.push_back(s.wallMs);
+        bytes.push_back(s.bytes);
+        used.push_back(s.bytesUsed);
+        requests.push_back(s.requests);
+        allocs.push_back(s.allocs);
+        allocBytesPerRun.push_back(s.allocBytes);
+    }
+    std::sort(wall.begin(), wall.end());
+    double medianMs = wall[wall.size() / 2];
+    // The mmap source is parsed in place: nothing is copied out of it
+    bool inPlace = source == "mmap";
+
+    if (options.json) {
+        std::cout << std::fixed << std::setprecision(3)
+                  << "{\"source\":\"" << source << "\""
+                  << ",\"keys\":" << options.spec.keys
+                  << ",\"vocab\":" << options.spec.vocab
+                  << ",\"tensors\":" << options.spec.tensors
+                  << ",\"core_first\":" << (options.spec.coreFirst ? "true" : "false")
+                  << ",\"rtt_ms\":" << options.rttMs
+                  << ",\"bandwidth_mbps\":" << options.bandwidthMbps
+                  << ",\"iterations\":" << samples.size()
+                  << ",\"wall_ms_median\":" << medianMs
+                  << ",\"wall_ms_min\":" << wall.front()
+                  << ",\"wall_ms_max\":" << wall.back()
+                  << ",\"bytes\":" << (inPlace ? 0 : median(bytes))
+                  << ",\"bytes_used\":" << median(used)
+                  << ",\"requests\":" << median(requests)
+                  << ",\"allocs\":" << median(allocs)
+                  << ",\"alloc_bytes\":" << median(allocBytesPerRun)
+                  << "}" << std::endl;
+        return;
+    }
+    std::cout << std::left << std::setw(6) << source << std::right << std::fixed << std::setprecision(3)
+              << std::setw(11) << medianMs << std::setw(11) << wall.front() << std::setw(11) << wall.back()
+              << std::setw(13) << (inPlace ? std::string("in place") : std::to_string(median(bytes)))
+              << std::setw(11) << median(used)
+              << std::setw(10) << median(requests)
+              << std::setw(9) << median(allocs)
+              << std::setw(12) << median(allocBytesPerRun) << std::endl;
+}
+
+template <typename Probe>
+std::vector<Sample> measure(const Options& options, Probe probe) {
+    std::vector<Sample> samples;
+    for (unsigned i = 0; i < options.warmup + options.iterations; ++i) {
+        Sample sample;
+        resetAllocationCounters();
+        auto start = Clock::now();
+        if (!probe(sample))
+            throw std::runtime_error("readModelParams failed");
+        sample.wallMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        sample.allocs = allocationCount();
+        sample.allocBytes = allocationBytes();
+        if (i >= options.warmup)
+            samples.push_back(sample);
+    }
+    return samples;
+}
+
+void usage() {
+    std::cout <<
+        "Usage: gguf_bench [options]\n"
+        "  --keys N             filler metadata keys (default 1000)\n"
+        "  --vocab N            tokenizer vocabulary size (default 32000)\n"
+        "  --tensors N          tensor-info entries (default 291)\n"
+        "  --core-first         write the llama.* keys before the filler and vocab\n"
+        "                       (default: after, so the whole metadata is scanned)\n"
+        "  --sources LIST       comma-separated: file,mmap,http (default all)\n"
+        "  --iterations N       measured runs per source (default 20)\n"
+        "  --warmup N           unmeasured runs per source (default 2)\n"
+        "  --rtt-ms X           injected round trip per connection and request (http)\n"
+        "  --bandwidth-mbps X   body bandwidth in Mbit/s, 0 for unpaced (http)\n"
+        "  --no-read-ahead      one range at a time (http)\n"
+        "  --shared-loop        reuse one curl multi loop, and its connections, across runs (http)\n"
+        "  --dir PATH           where to write the synthetic file (default: temp dir)\n"
+        "  --json               one JSON object per source instead of a table\n";
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument(arg + " needs a value");
+            return argv[++i];
+        };
+        if (arg == "--keys") options.spec.keys = std::stoull(value());
+        else if (arg == "--vocab") options.spec.vocab = std::stoull(value());
+        else if (arg == "--tensors") options.spec.tensors = std::stoull(value());
+        else if (arg == "--core-first") options.spec.coreFirst = true;
+        else if (arg == "--iterations") options.iterations = static_cast<unsigned>(std::stoul(value()));
+        else if (arg == "--warmup") options.warmup = static_cast<unsigned>(std::stoul(value()));
+        else if (arg == "--rtt-ms") options.rttMs = std::stod(value());
+        else if (arg == "--bandwidth-mbps") options.bandwidthMbps = std::stod(value());
+        else if (arg == "--no-read-ahead") options.readAhead = false;
+        else if (arg == "--shared-loop") options.sharedLoop = true;
+        else if (arg == "--dir") options.dir = value();
+        else if (arg == "--json") options.json = true;
+        else if (arg == "--sources") {
+            options.sources.clear();
+            std::stringstream list(value());
+            for (std::string name; std::getline(list, name, ',');)
+                options.sources.push_back(name);
+        } else if (arg == "--help" || arg == "-h") {
+            usage();
+            return false;
+        } else {
+            throw std::invalid_argument("Unknown option " + arg + " (see --help)");
+        }
+    }
+    if (options.iterations == 0)
+        throw std::invalid_argument("--iterations must be positive");
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        if (!parseArgs(argc, argv, options))
+            return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    std::string path = (std::filesystem::path(options.dir) / "gguf_bench_synthetic.gguf").string();
+    try {
+        uint64_t fileSize = writeSyntheticGGUF(path, options.spec);
+        if (!options.json) {
+            std::cout << "synthetic GGUF: " << options.spec.keys << " filler keys, vocab " << options.spec.vocab
+                      << ", " << options.spec.tensors << " tensors, " << fileSize << " bytes (sparse)\n"
+                      << "source  wall_ms    min_ms     max_ms          bytes       used  requests   allocs  alloc_bytes\n";
+        }
+
+        GGUFMetadataReader reader;
+        for (const std::string& source : options.sources) {
+            std::vector<Sample> samples;
+            if (source == "file") {
+                samples = measure(options, [&](Sample& sample) {
+                    FileDataSource file(path);
+                    CountingSource counting(file);
+                    ProbeStats stats;
+                    bool ok = reader.readModelParams(counting, false, &stats).has_value();
+                    sample.bytes = counting.bytes;
+                    sample.bytesUsed = stats.bytesUsed;
+                    sample.requests = counting.calls;
+                    return ok;
+                });
+            } else if (source == "mmap") {
+#ifdef GGUF_HAVE_MMAP
+                samples = measure(options, [&](Sample& sample) {
+                    MmapDataSource mapped(path);
+                    ProbeStats stats;
+                    bool ok = reader.readModelParams(mapped, false, &stats).has_value();
+                    sample.bytesUsed = stats.bytesUsed;
+                    return ok;
+                });
+#else
+                std::cerr << "mmap source not available on this platform" << std::endl;
+                continue;
+#endif
+            } else if (source == "http") {
+                RangeServer server(path, options.rttMs, options.bandwidthMbps * 1e6 / 8);
+                GGUFMetadataReader httpReader;
+                UrlReadAhead readAhead;
+                readAhead.enabled = options.readAhead;
+                httpReader.setReadAhead(readAhead);
+                if (options.sharedLoop)
+                    httpReader.setMultiLoop(std::make_shared<CurlMultiLoop>());
+                std::string url = server.url();
+                samples = measure(options, [&](Sample& sample) {
+                    server.resetCounters();
+                    ProbeStats stats;
+                    bool ok = httpReader.readModelParams(url, false, &stats).has_value();
+                    sample.bytes = server.bytesSent;
+                    sample.bytesUsed = stats.bytesUsed;
+                    sample.requests = server.requests;
+                    return ok;
+                });
+            } else {
+                std::cerr << "Unknown source: " << source << std::endl;
+                continue;
+            }
+            report(source, options, samples);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        std::filesystem::remove(path);
+        return 1;
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "cli_common.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+uint32_t parseCount(const std::string& flag, const std::string& value) {
+    size_t end = 0;
+    unsigned long n = 0;
+    try {
+        n = std::stoul(value, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != value.size() || n == 0 || n > UINT32_MAX)
+        throw std::invalid_argument(flag + " needs a positive integer, got \"" + value + "\"");
+    return static_cast<uint32_t>(n);
+}
+
+GGMLType parseCacheType(const std::string& flag, const std::string& value) {
+    auto type = parseKVCacheType(value);
+    if (!type)
+        throw std::invalid_argument(flag + ": unknown cache type \"" + value + "\"");
+    return *type;
+}
+
+std::string baseName(const std::string& input) {
+    std::string path = input.substr(0, input.find_first_of("?#"));
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+ModelFile toModelFile(const std::string& input) {
+    ModelFile file;
+    bool url = input.rfind("http://", 0) == 0 || input.rfind("https://", 0) == 0;
+    file.filename = url ? baseName(input) : input;
+    if (url)
+        file.downloadUrl = input;
+    file.quant = ModelFileUtils::detectQuantization(baseName(input));
+    return file;
+}
+
+void appendJsonString(std::ostringstream& out, const std::string& s) {
+    out << '"';
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof escaped, "\\u%04x", c);
+                    out << escaped;
+                } else {
+                    out << static_cast<char>(c);
+                }
+        }
+    }
+    out << '"';
+}
+
+std::string toJsonLine(const ModelFile& file, const MemoryUsage& usage) {
+    std::ostringstream out;
+    out << "{\"input\":";
+    appendJsonString(out, file.downloadUrl.value_or(file.filename));
+    if (!usage.hasEstimate) {
+        out << ",\"ok\":false,\"error\":\"could not read the GGUF header\"}";
+        return out.str();
+    }
+
+    const QuantizationInfo& quant = usage.headerQuant.type.empty() ? file.quant : usage.headerQuant;
+    out << ",\"ok\":true,\"quant\":";
+    appendJsonString(out, quant.type);
+    out << ",\"shards\":" << file.splitCount
+        << ",\"model_mb\":" << usage.modelSizeMB
+        << ",\"kv_cache_mb\":" << usage.kvCacheMB
+        << ",\"compute_buffer_mb\":" << usage.computeBufferMB
+        << ",\"output_buffer_mb\":" << usage.outputBufferMB
+        << ",\"expert_weights_mb\":" << usage.expertWeightsMB
+        << ",\"active_weights_mb\":" << usage.activeWeightsMB
+        << ",\"total_mb\":" << usage.totalRequiredMB;
+
+    const ProbeStats& probe = usage.probe;
+    out << ",\"probe\":{\"source\":";
+    appendJsonString(out, probe.source);
+    out << ",\"requests\":" << probe.requests
+        << ",\"bytes_received\":" << probe.bytesReceived
+        << ",\"bytes_used\":" << probe.bytesUsed
+        << ",\"ttfb_ms\":" << probe.timeToFirstByteMs
+        << ",\"wall_ms\":" << probe.wallMs << "}}";
+    return out.str();
+}
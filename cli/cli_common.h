@@ -0,0 +1,29 @@
+#ifndef CLI_COMMON_H
+#define CLI_COMMON_H
+
+#include "model_file.h"
+
+#include <sstream>
+#include <string>
+
+// Shared by the batch front end and the estimate service
+
+// "N" > 0 that fits in uint32_t; invalid_argument naming `flag` otherwise
+uint32_t parseCount(const std::string& flag, const std::string& value);
+
+// KV cache type by llama.cpp name; invalid_argument naming `flag` otherwise
+GGMLType parseCacheType(const std::string& flag, const std::string& value);
+
+// File name part of a path or URL (query and fragment dropped)
+std::string baseName(const std::string& input);
+
+// ModelFile for a local path or an http(s) URL, quant detected from the name
+ModelFile toModelFile(const std::string& input);
+
+// Appends `s` as a quoted JSON string
+void appendJsonString(std::ostringstream& out, const std::string& s);
+
+// One estimate as a single-line JSON object (no trailing newline)
+std::string toJsonLine(const ModelFile& file, const MemoryUsage& usage);
+
+#endif // CLI_COMMON_H
@@ -0,0 +1,720 @@
+#include "estimate_server.h"
+#include "cli_common.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t MAX_REQUEST_HEAD = 16 * 1024;
+
+const char* statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 422: return "Unprocessable Entity";
+        case 431: return "Request Header Fields Too Large";
+        case 503: return "Service Unavailable";
+        default:  return "Error";
+    }
+}
+
+std::string errorBody(const std::string& message) {
+    std::ostringstream out;
+    out << "{\"ok\":false,\"error\":";
+    appendJsonString(out, message);
+    out << '}';
+    return out.str();
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string lowercase(std::string s) {
+    for (char& c : s)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+std::string percentDecode(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') {
+            out += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size() && std::isxdigit(static_cast<unsigned char>(s[i + 1]))
+                   && std::isxdigit(static_cast<unsigned char>(s[i + 2]))) {
+            out += static_cast<char>(std::stoi(s.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+std::map<std::string, std::string> parseQuery(const std::string& query) {
+    std::map<std::string, std::string> params;
+    size_t pos = 0;
+    while (pos <= query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos)
+            amp = query.size();
+        std::string pair = query.substr(pos, amp - pos);
+        if (!pair.empty()) {
+            size_t eq = pair.find('=');
+            std::string key = percentDecode(pair.substr(0, eq));
+            params[key] = eq == std::string::npos ? std::string() : percentDecode(pair.substr(eq + 1));
+        }
+        pos = amp + 1;
+    }
+    return params;
+}
+
+// ---- JSON request bodies ----
+// POST bodies are one flat object whose members are the query parameters:
+// strings, numbers and booleans as their text, arrays of those joined with
+// commas ("devices":[24000,"gpu1:12000"]), null as absent. Anything else
+// is a std::invalid_argument, answered with 400.
+
+class JsonObjectParser {
+public:
+    explicit JsonObjectParser(const std::string& text) : text(text) {}
+
+    std::map<std::string, std::string> parse() {
+        std::map<std::string, std::string> members;
+        expect('{');
+        if (!consume('}')) {
+            do {
+                std::string name = string();
+                expect(':');
+                std::optional<std::string> value = member(name);
+                if (value)
+                    members[name] = *value;
+                else
+                    members.erase(name);
+            } while (consume(','));
+            expect('}');
+        }
+        skipSpace();
+        if (pos != text.size())
+            fail("unexpected data after the object");
+        return members;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::invalid_argument("invalid JSON body at offset " + std::to_string(pos) + ": " + what);
+    }
+
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+            ++pos;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c))
+            fail(std::string("expected '") + c + "'");
+    }
+
+    bool literal(const char* word) {
+        size_t n = std::strlen(word);
+        if (text.compare(pos, n, word) != 0)
+            return false;
+        pos += n;
+        return true;
+    }
+
+    // Member value as parameter text; nullopt for null
+    std::optional<std::string> member(const std::string& name) {
+        skipSpace();
+        if (pos < text.size() && text[pos] == '[') {
+            ++pos;
+            std::string joined;
+            if (!consume(']')) {
+                do {
+                    std::optional<std::string> item = scalar(name);
+                    if (!item)
+                        fail("null inside the array \"" + name + "\"");
+                    joined += (joined.empty() ? "" : ",") + *item;
+                } while (consume(','));
+                expect(']');
+            }
+            return joined;
+        }
+        return scalar(name);
+    }
+
+    std::optional<std::string> scalar(const std::string& name) {
+        skipSpace();
+        if (pos >= text.size())
+            fail("unexpected end");
+        char c = text[pos];
+        if (c == '"')
+            return string();
+        if (literal("true"))
+            return std::string("true");
+        if (literal("false"))
+            return std::string("false");
+        if (literal("null"))
+            return std::nullopt;
+        if (c == '-' || std::isdigit(static_cast<unsigned char>(c))) {
+            size_t start = pos++;
+            while (pos < text.size() && (std::isdigit(static_cast<unsigned char>(text[pos]))
+                                         || std::strchr(".eE+-", text[pos])))
+                ++pos;
+            return text.substr(start, pos - start);
+        }
+        fail("\"" + name + "\" must be a string, number, boolean, null or an array of those");
+    }
+
+    std::string string() {
+        skipSpace();
+        if (pos >= text.size() || text[pos] != '"')
+            fail("expected a string");
+        ++pos;
+        std::string out;
+        while (true) {
+            if (pos >= text.size())
+                fail("unterminated string");
+            char c = text[pos++];
+            if (c == '"')
+                return out;
+            if (static_cast<unsigned char>(c) < 0x20)
+                fail("control character in a string");
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= text.size())
+                fail("unterminated escape");
+            switch (char e = text[pos++]) {
+                case '"': case '\\': case '/': out += e; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': appendUtf8(out, codePoint()); break;
+                default: fail(std::string("unknown escape \\") + e);
+            }
+        }
+    }
+
+    uint32_t hex4() {
+        if (pos + 4 > text.size())
+            fail("short \\u escape");
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text[pos++];
+            if (!std::isxdigit(static_cast<unsigned char>(c)))
+                fail("bad \\u escape");
+            value = value * 16 + static_cast<uint32_t>(std::isdigit(static_cast<unsigned char>(c))
+                                                       ? c - '0' : std::tolower(c) - 'a' + 10);
+        }
+        return value;
+    }
+
+    uint32_t codePoint() {
+        uint32_t cp = hex4();
+        if (cp >= 0xD800 && cp < 0xDC00) {
+            if (!literal("\\u"))
+                fail("unpaired surrogate");
+            uint32_t low = hex4();
+            if (low < 0xDC00 || low >= 0xE000)
+                fail("unpaired surrogate");
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        } else if (cp >= 0xDC00 && cp < 0xE000) {
+            fail("unpaired surrogate");
+        }
+        return cp;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    const std::string& text;
+    size_t pos = 0;
+};
+
+bool parseFlag(const std::string& name, const std::string& value) {
+    std::string v = lowercase(value);
+    if (v.empty() || v == "1" || v == "true" || v == "on")
+        return true;
+    if (v == "0" || v == "false" || v == "off")
+        return false;
+    throw std::invalid_argument(name + " needs 1/0, true/false or on/off, got \"" + value + "\"");
+}
+
+std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> items;
+    std::istringstream in(s);
+    for (std::string item; std::getline(in, item, ',');)
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+uint64_t toMB(uint64_t bytes) {
+    return (bytes + 500000) / 1000000;
+}
+
+void appendPlacement(std::ostringstream& out, const DevicePlacement& p) {
+    out << "{\"name\":";
+    appendJsonString(out, p.name);
+    out << ",\"budget_mb\":" << toMB(p.budgetBytes)
+        << ",\"first_layer\":" << p.firstLayer
+        << ",\"layers\":" << p.layerCount
+        << ",\"output\":" << (p.hasOutput ? "true" : "false")
+        << ",\"weights_mb\":" << toMB(p.weightBytes)
+        << ",\"experts_mb\":" << toMB(p.expertBytes)
+        << ",\"kv_mb\":" << toMB(p.kvBytes)
+        << ",\"output_weights_mb\":" << toMB(p.outputBytes)
+        << ",\"compute_mb\":" << toMB(p.computeBytes)
+        << ",\"output_buffer_mb\":" << toMB(p.outputBufferBytes)
+        << ",\"total_mb\":" << toMB(p.totalBytes())
+        << ",\"fits\":" << (p.fits() ? "true" : "false") << '}';
+}
+
+// Listening socket for "unix:/path", "host:port", ":port" or "port"
+int bindListener(const std::string& address, std::string& socketPath) {
+    if (address.rfind("unix:", 0) == 0) {
+        socketPath = address.substr(5);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof addr.sun_path)
+            throw std::runtime_error("Unix socket path empty or too long: " + socketPath);
+        std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+        // A socket left behind by an earlier run would make bind fail
+        struct stat st{};
+        if (::stat(socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+            ::unlink(socketPath.c_str());
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0 || ::listen(fd, 128) != 0) {
+            std::string reason = std::strerror(errno);
+            if (fd >= 0)
+                ::close(fd);
+            throw std::runtime_error("Cannot listen on " + address + ": " + reason);
+        }
+        return fd;
+    }
+
+    std::string host, port = address;
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos) {
+        host = address.substr(0, colon);
+        port = address.substr(colon + 1);
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+            host = host.substr(1, host.size() - 2);
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* found = nullptr;
+    int rc = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found);
+    if (rc != 0)
+        throw std::runtime_error("Cannot resolve " + address + ": " + ::gai_strerror(rc));
+
+    int fd = -1;
+    std::string reason = "no address";
+    for (addrinfo* ai = found; ai; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+        if (::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, 128) == 0)
+            break;
+        reason = std::strerror(errno);
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(found);
+    if (fd < 0)
+        throw std::runtime_error("Cannot listen on " + address + ": " + reason);
+    return fd;
+}
+
+} // namespace
+
+EstimateServer::EstimateServer(EstimateServerOptions options) : options(std::move(options)) {}
+
+EstimateServer::~EstimateServer() {
+    if (listenFd >= 0)
+        ::close(listenFd);
+    if (!socketPath.empty())
+        ::unlink(socketPath.c_str());
+}
+
+void EstimateServer::start() {
+    listenFd = bindListener(options.listen, socketPath);
+    startedAt = std::chrono::steady_clock::now();
+
+    if (!socketPath.empty()) {
+        boundAddress = "unix:" + socketPath;
+        return;
+    }
+    sockaddr_storage addr{};
+    socklen_t len = sizeof addr;
+    char host[INET6_ADDRSTRLEN] = "";
+    char port[8] = "";
+    if (::getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len) == 0
+        && ::getnameinfo(reinterpret_cast<sockaddr*>(&addr), len, host, sizeof host, port, sizeof port,
+                         NI_NUMERICHOST | NI_NUMERICSERV) == 0)
+        boundAddress = addr.ss_family == AF_INET6 ? "[" + std::string(host) + "]:" + port : std::string(host) + ":" + port;
+    else
+        boundAddress = options.listen;
+}
+
+void EstimateServer::run() {
+    while (!stopping.load()) {
+        pollfd pfd{listenFd, POLLIN, 0};
+        // Short timeout so stop() from a signal handler is noticed promptly
+        if (::poll(&pfd, 1, 200) <= 0 || !(pfd.revents & POLLIN))
+            continue;
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (clients.size() >= options.maxConnections) {
+                std::string body = errorBody("too many connections");
+                sendAll(fd, "HTTP/1.1 503 Service Unavailable\r\nContent-Type: application/json\r\n"
+                            "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+                ::close(fd);
+                continue;
+            }
+            clients.insert(fd);
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);   // Fails harmlessly on Unix sockets
+        timeval idle{options.idleTimeoutSeconds, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof idle);
+
+        auto finish = [this, fd]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            clients.erase(fd);
+            ::close(fd);
+            drained.notify_all();
+        };
+        try {
+            std::thread([this, fd, finish]() {
+                serve(fd);
+                finish();
+            }).detach();
+        } catch (const std::system_error& e) {
+            std::cerr << "Cannot start a connection thread: " << e.what() << std::endl;
+            finish();
+        }
+    }
+
+    ::close(listenFd);
+    listenFd = -1;
+    if (!socketPath.empty()) {
+        ::unlink(socketPath.c_str());
+        socketPath.clear();
+    }
+
+    // Wake connections blocked in recv; a request being estimated finishes first
+    std::unique_lock<std::mutex> lock(mutex);
+    for (int fd : clients)
+        ::shutdown(fd, SHUT_RDWR);
+    drained.wait(lock, [this]() { return clients.empty(); });
+}
+
+void EstimateServer::serve(int fd) {
+    std::string buffer;
+    char chunk[4096];
+    auto fill = [&]() {
+        ssize_t n = ::recv(fd, chunk, sizeof chunk, 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    };
+
+    while (!stopping.load()) {
+        // The limit holds however the head arrives: in pieces or in one read
+        size_t headEnd;
+        while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos || headEnd > MAX_REQUEST_HEAD) {
+            if (std::min(headEnd, buffer.size()) > MAX_REQUEST_HEAD) {
+                std::string body = errorBody("request head too large");
+                sendAll(fd, "HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Type: application/json\r\n"
+                            "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+                return;
+            }
+            if (!fill())
+                return;
+        }
+        std::string head = buffer.substr(0, headEnd);
+        buffer.erase(0, headEnd + 4);
+
+        std::istringstream lines(head);
+        std::string requestLine;
+        std::getline(lines, requestLine);
+        if (!requestLine.empty() && requestLine.back() == '\r')
+            requestLine.pop_back();
+        std::istringstream parts(requestLine);
+        std::string method, target, version;
+        parts >> method >> target >> version;
+
+        bool keepAlive = version == "HTTP/1.1";
+        size_t contentLength = 0;
+        for (std::string line; std::getline(lines, line);) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            size_t colon = line.find(':');
+            if (colon == std::string::npos)
+                continue;
+            std::string name = lowercase(line.substr(0, colon));
+            size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+            std::string value = valueStart == std::string::npos ? std::string() : line.substr(valueStart);
+            if (name == "connection")
+                keepAlive = lowercase(value).find("close") == std::string::npos
+                            && (version == "HTTP/1.1" || lowercase(value).find("keep-alive") != std::string::npos);
+            else if (name == "content-length")
+                contentLength = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        }
+
+        // POST bodies are small JSON objects; other methods' bodies are read and ignored
+        if (contentLength > MAX_REQUEST_HEAD) {
+            std::string body = errorBody("request body too large");
+            sendAll(fd, "HTTP/1.1 413 Payload Too Large\r\nContent-Type: application/json\r\n"
+                        "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+            return;
+        }
+        while (buffer.size() < contentLength)
+            if (!fill())
+                return;
+        std::string body = buffer.substr(0, contentLength);
+        buffer.erase(0, contentLength);
+
+        auto started = std::chrono::steady_clock::now();
+        size_t question = target.find('?');
+        std::string path = target.substr(0, question);
+        Response response;
+        if (method == "POST" && (path == "/estimate" || path == "/plan")) {
+            // Body members override the same parameters in the query string
+            try {
+                Query query = question == std::string::npos ? Query() : parseQuery(target.substr(question + 1));
+                for (auto& [name, value] : JsonObjectParser(body).parse())
+                    query[name] = std::move(value);
+                response = handle(path, query);
+            } catch (const std::invalid_argument& e) {
+                response = {400, errorBody(e.what())};
+            }
+        } else if (method != "GET" && method != "HEAD") {
+            response = {405, errorBody("only GET and HEAD, and POST to /estimate and /plan, are supported")};
+        } else {
+            Query query = question == std::string::npos ? Query() : parseQuery(target.substr(question + 1));
+            response = handle(path, query);
+        }
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+        ++requests;
+        if (response.status != 200)
+            ++failures;
+
+        std::ostringstream out;
+        out << "HTTP/1.1 " << response.status << ' ' << statusText(response.status) << "\r\n"
+            << "Content-Type: application/json\r\n"
+            << "Content-Length: " << response.body.size() + 1 << "\r\n"
+            << "Server-Timing: estimate;dur=" << std::fixed << std::setprecision(3) << elapsedMs << "\r\n"
+            << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n\r\n";
+        if (method != "HEAD")
+            out << response.body << '\n';
+        if (!sendAll(fd, out.str()) || !keepAlive)
+            return;
+    }
+}
+
+EstimateServer::Response EstimateServer::handle(const std::string& path, const Query& query) {
+    try {
+        if (path == "/estimate")
+            return estimate(query);
+        if (path == "/plan")
+            return plan(query);
+        if (path == "/stats")
+            return stats();
+        if (path == "/health")
+            return {200, "{\"ok\":true}"};
+        return {404, errorBody("unknown path " + path)};
+    } catch (const std::invalid_argument& e) {
+        return {400, errorBody(e.what())};
+    } catch (const std::exception& e) {
+        return {422, errorBody(e.what())};
+    }
+}
+
+MemoryEstimateOptions EstimateServer::estimateOptions(const Query& query) const {
+    MemoryEstimateOptions estimate = options.defaults;
+    for (const auto& [name, value] : query) {
+        if (name == "c")
+            estimate.contextSize = static_cast<int>(std::min<uint32_t>(parseCount(name, value), INT32_MAX));
+        else if (name == "ctk")
+            estimate.kvCache.typeK = parseCacheType(name, value);
+        else if (name == "ctv")
+            estimate.kvCache.typeV = parseCacheType(name, value);
+        else if (name == "b")
+            estimate.batch.batchSize = parseCount(name, value);
+        else if (name == "ub")
+            estimate.batch.ubatchSize = parseCount(name, value);
+        else if (name == "np")
+            estimate.batch.parallel = parseCount(name, value);
+        else if (name == "fa")
+            estimate.batch.flashAttention = parseFlag(name, value);
+    }
+    return estimate;
+}
+
+static const std::string& requireModel(const std::map<std::string, std::string>& query) {
+    auto it = query.find("model");
+    if (it == query.end() || it->second.empty())
+        throw std::invalid_argument("model is required (a path or an http(s) URL)");
+    return it->second;
+}
+
+EstimateServer::Response EstimateServer::estimate(const Query& query) const {
+    ModelFile file = toModelFile(requireModel(query));
+    MemoryUsage usage = ModelFileUtils::calculateMemoryUsage(file, estimateOptions(query));
+    return {usage.hasEstimate ? 200 : 422, toJsonLine(file, usage)};
+}
+
+EstimateServer::Response EstimateServer::plan(const Query& query) const {
+    ModelFile file = toModelFile(requireModel(query));
+    MemoryEstimateOptions estimate = estimateOptions(query);
+
+    // "24000,gpu1:12000": budgets in decimal MB, optionally named
+    std::vector<OffloadDevice> devices;
+    auto deviceList = query.find("devices");
+    if (deviceList != query.end()) {
+        for (const std::string& item : splitList(deviceList->second)) {
+            OffloadDevice device;
+            size_t colon = item.rfind(':');
+            device.name = colon == std::string::npos ? "gpu" + std::to_string(devices.size()) : item.substr(0, colon);
+            device.budgetBytes = uint64_t(parseCount("devices", item.substr(colon + 1))) * 1000000;
+            devices.push_back(device);
+        }
+    }
+    if (devices.empty())
+        throw std::invalid_argument("devices is required, e.g. devices=24000,12000 (MB)");
+
+    auto info = ModelFileUtils::loadModelInfo(file);
+    if (!info) {
+        std::ostringstream out;
+        out << "{\"input\":";
+        appendJsonString(out, file.downloadUrl.value_or(file.filename));
+        out << ",\"ok\":false,\"error\":\"could not read the GGUF header\"}";
+        return {422, out.str()};
+    }
+
+    OffloadPlanner planner(*info, static_cast<uint64_t>(estimate.contextSize), estimate.kvCache, estimate.batch);
+    auto cpuMoe = query.find("cpu_moe");
+    if (cpuMoe != query.end())
+        planner.keepExpertsOnHost(cpuMoe->second.empty() || cpuMoe->second == "all"
+                                  ? UINT32_MAX : parseCount("cpu_moe", cpuMoe->second));
+
+    OffloadPlan result;
+    auto ngl = query.find("ngl");
+    if (ngl != query.end()) {
+        std::vector<float> split;
+        auto ts = query.find("ts");
+        if (ts != query.end())
+            for (const std::string& share : splitList(ts->second))
+                split.push_back(static_cast<float>(parseCount("ts", share)));
+        result = planner.plan(parseCount("ngl", ngl->second), devices, split);
+    } else {
+        result = planner.planForBudget(devices);
+    }
+
+    std::ostringstream out;
+    out << "{\"input\":";
+    appendJsonString(out, file.downloadUrl.value_or(file.filename));
+    out << ",\"ok\":true,\"block_count\":" << planner.blockCount()
+        << ",\"gpu_layers\":" << result.gpuLayers
+        << ",\"fits\":" << (result.fits() ? "true" : "false")
+        << ",\"tensor_split\":[";
+    for (size_t i = 0; i < result.layerSplit.size(); ++i)
+        out << (i ? "," : "") << result.layerSplit[i];
+    out << "],\"devices\":[";
+    for (size_t i = 0; i < result.devices.size(); ++i) {
+        if (i)
+            out << ',';
+        appendPlacement(out, result.devices[i]);
+    }
+    out << "],\"host\":";
+    appendPlacement(out, result.host);
+    out << '}';
+    return {200, out.str()};
+}
+
+EstimateServer::Response EstimateServer::stats() const {
+    auto profiles = ModelFileUtils::getProfileCache();
+    double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+    std::ostringstream out;
+    out << "{\"ok\":true,\"uptime_s\":" << static_cast<uint64_t>(uptime)
+        << ",\"requests\":" << requests.load()
+        << ",\"failures\":" << failures.load()
+        << ",\"cached_profiles\":" << (profiles ? profiles->size() : 0)
+        << ",\"idle_curl_handles\":" << NetworkContext::instance().idleHandles() << '}';
+    return {200, out.str()};
+}
@@ -0,0 +1,93 @@
+#ifndef ESTIMATE_SERVER_H
+#define ESTIMATE_SERVER_H
+
+#include "model_file.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+struct EstimateServerOptions {
+    std::string listen = "127.0.0.1:8088";  // "host:port", ":port", or "unix:/path/to.sock"
+    MemoryEstimateOptions defaults;         // Used for settings a request leaves out
+    size_t maxConnections = 64;             // Further clients get 503 and are closed
+    int idleTimeoutSeconds = 30;            // Keep-alive connections idle this long are closed
+};
+
+// Long-running estimate service: a small HTTP/1.1 server (keep-alive, GET and
+// HEAD only) in front of ModelFileUtils. Each connection runs on its own
+// thread and calls the synchronous estimate path, so repeat queries are
+// answered from the profile cache and URL probes reuse NetworkContext's warm
+// handles; only the first query for a model touches the network.
+//
+//   GET /estimate?model=URL&c=8192&ctk=q8_0&ctv=q8_0&b=2048&ub=512&np=1&fa=1
+//   GET /plan?model=URL&devices=24000,gpu1:12000[&ngl=N&ts=3,1&cpu_moe=N|all]
+//   GET /health
+//   GET /stats
+//   POST /estimate, POST /plan with {"model":"URL","c":8192,"devices":[24000,12000],...}
+//
+// Query values are percent-decoded; a model URL with its own query string
+// must be encoded, or sent in a POST body, whose members are the same
+// parameters (malformed JSON is a 400). Estimate settings use the batch
+// CLI's short flag names.
+// /estimate answers with the batch CLI's JSON line, /plan with an
+// OffloadPlanner placement (device budgets in decimal MB; without ngl the
+// largest n_gpu_layers that fits). Every answer carries a Server-Timing
+// header with the time spent on it.
+class EstimateServer {
+public:
+    explicit EstimateServer(EstimateServerOptions options);
+    ~EstimateServer();
+
+    EstimateServer(const EstimateServer&) = delete;
+    EstimateServer& operator=(const EstimateServer&) = delete;
+
+    // Binds the listen address; throws std::runtime_error when it cannot
+    void start();
+
+    // Where start() listens: "host:port" with the actual port (for ":0"), or "unix:/path"
+    const std::string& address() const { return boundAddress; }
+
+    // Accepts connections until stop(), then closes them and returns
+    void run();
+
+    // Safe from any thread and from a signal handler
+    void stop() { stopping.store(true); }
+
+private:
+    using Query = std::map<std::string, std::string>;
+
+    struct Response {
+        int status = 200;
+        std::string body;
+    };
+
+    void serve(int fd);
+    Response handle(const std::string& path, const Query& query);
+    Response estimate(const Query& query) const;
+    Response plan(const Query& query) const;
+    Response stats() const;
+
+    // Estimate settings from the query over the server defaults
+    MemoryEstimateOptions estimateOptions(const Query& query) const;
+
+    EstimateServerOptions options;
+    int listenFd = -1;
+    std::string socketPath;                 // Unix socket to unlink on shutdown
+    std::string boundAddress;
+    std::atomic<bool> stopping{false};
+
+    std::mutex mutex;
+    std::condition_variable drained;
+    std::set<int> clients;                  // Open connections, shut down on stop
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures{0};      // Answers other than 200
+    std::chrono::steady_clock::time_point startedAt;
+};
+
+#endif // ESTIMATE_SERVER_H
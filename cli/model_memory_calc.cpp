@@ -0,0 +1,212 @@
+// Batch estimator: probes GGUF files or URLs in parallel and writes one JSON
+// line per model to stdout as soon as that model's estimate is done. With
+// --serve it stays up instead and answers estimate and placement queries over
+// HTTP (see cli/estimate_server.h), keeping profiles and connections warm.
+//
+// Native only. Build from the repository root (needs libcurl):
+//   cmake -S . -B build && cmake --build build --target model-memory-calc
+//
+// Examples:
+//   model-memory-calc -c 8192 -ctk q8_0 -ctv q8_0 https://host/a.Q4_K_M.gguf ./b.gguf
+//   model-memory-calc -j 32 --header-cache < urls.txt > estimates.jsonl
+//   model-memory-calc --serve unix:/run/mmc.sock --profile-ttl 3600
+
+#include "cli_common.h"
+#include "estimate_server.h"
+#include "header_cache.h"
+
+#include <csignal>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct CliOptions {
+    MemoryEstimateOptions estimate;
+    size_t jobs = 8;
+    bool headerCache = false;
+    std::string headerCacheDir;         // Empty: HeaderCache::defaultDirectory()
+    bool group = true;
+    std::vector<std::string> inputs;
+
+    bool serve = false;
+    EstimateServerOptions server;       // estimate defaults are copied from `estimate`
+    int64_t profileTtlSeconds = 0;
+};
+
+void usage() {
+    std::cerr <<
+        "Usage: model-memory-calc [options] [path-or-url ...]\n"
+        "       model-memory-calc --serve [ADDR] [options]\n"
+        "Reads paths or URLs from the arguments, or one per line from stdin when\n"
+        "there are none (or the only one is \"-\"), and writes one JSON line per\n"
+        "model as each estimate completes. With --serve, answers GET /estimate,\n"
+        "/plan, /stats and /health (and JSON POSTs to /estimate and /plan) on ADDR\n"
+        "until interrupted; the estimate options become the defaults for requests\n"
+        "that leave them out.\n"
+        "\n"
+        "  -c,   --ctx-size N        context length in tokens (default 4096)\n"
+        "  -ctk, --cache-type-k T    K cache type: f16, q8_0, q4_0, ... (default f16)\n"
+        "  -ctv, --cache-type-v T    V cache type (default f16)\n"
+        "  -b,   --batch-size N      logical batch size (default 2048)\n"
+        "  -ub,  --ubatch-size N     physical batch size (default 512)\n"
+        "  -np,  --parallel N        parallel sequences (default 1)\n"
+        "  -fa,  --flash-attn        size compute buffers for flash attention\n"
+        "  -j,   --jobs N            concurrent probes (default 8)\n"
+        "        --header-cache[=DIR]  keep fetched headers on disk between runs\n"
+        "        --no-group          estimate each shard of a split model on its own line\n"
+        "        --serve [ADDR]      run as a service on host:port or unix:/path\n"
+        "                            (default 127.0.0.1:8088; port 0 picks a free one)\n"
+        "        --max-connections N concurrent service clients (default 64)\n"
+        "        --profile-ttl S     re-read cached model headers older than S seconds\n"
+        "  -h,   --help\n";
+}
+
+// false: help was printed
+bool parseArgs(int argc, char** argv, CliOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument(arg + " needs a value");
+            return argv[++i];
+        };
+        if (arg == "-c" || arg == "--ctx-size")
+            options.estimate.contextSize = static_cast<int>(std::min<uint32_t>(parseCount(arg, value()), INT32_MAX));
+        else if (arg == "-ctk" || arg == "--cache-type-k")
+            options.estimate.kvCache.typeK = parseCacheType(arg, value());
+        else if (arg == "-ctv" || arg == "--cache-type-v")
+            options.estimate.kvCache.typeV = parseCacheType(arg, value());
+        else if (arg == "-b" || arg == "--batch-size")
+            options.estimate.batch.batchSize = parseCount(arg, value());
+        else if (arg == "-ub" || arg == "--ubatch-size")
+            options.estimate.batch.ubatchSize = parseCount(arg, value());
+        else if (arg == "-np" || arg == "--parallel")
+            options.estimate.batch.parallel = parseCount(arg, value());
+        else if (arg == "-fa" || arg == "--flash-attn")
+            options.estimate.batch.flashAttention = true;
+        else if (arg == "-j" || arg == "--jobs")
+            options.jobs = parseCount(arg, value());
+        else if (arg == "--header-cache")
+            options.headerCache = true;
+        else if (arg.rfind("--header-cache=", 0) == 0) {
+            options.headerCache = true;
+            options.headerCacheDir = arg.substr(15);
+        } else if (arg == "--no-group")
+            options.group = false;
+        else if (arg == "--serve") {
+            options.serve = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                options.server.listen = argv[++i];
+        } else if (arg == "--max-connections")
+            options.server.maxConnections = parseCount(arg, value());
+        else if (arg == "--profile-ttl")
+            options.profileTtlSeconds = parseCount(arg, value());
+        else if (arg == "-h" || arg == "--help") {
+            usage();
+            return false;
+        } else if (arg.size() > 1 && arg[0] == '-')
+            throw std::invalid_argument("Unknown option " + arg + " (see --help)");
+        else
+            options.inputs.push_back(arg);
+    }
+    return true;
+}
+
+// Inputs from stdin: one per line, blank lines and "#" comments skipped
+void readInputs(std::istream& in, std::vector<std::string>& inputs) {
+    for (std::string line; std::getline(in, line);) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+        size_t last = line.find_last_not_of(" \t\r");
+        inputs.push_back(line.substr(first, last - first + 1));
+    }
+}
+
+EstimateServer* runningServer = nullptr;
+
+void stopServer(int) {
+    if (runningServer)
+        runningServer->stop();
+}
+
+int serve(CliOptions& options) {
+    if (!options.inputs.empty()) {
+        std::cerr << "--serve takes no model inputs; query /estimate?model=... instead" << std::endl;
+        return 2;
+    }
+    if (options.profileTtlSeconds > 0) {
+        ProfileCacheOptions cacheOptions;
+        cacheOptions.ttlSeconds = options.profileTtlSeconds;
+        if (auto cache = ModelFileUtils::getProfileCache())
+            cache->setOptions(cacheOptions);
+    }
+
+    options.server.defaults = options.estimate;
+    EstimateServer server(options.server);
+    try {
+        server.start();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    std::cerr << "Serving estimates on " << server.address() << std::endl;
+    server.run();
+    runningServer = nullptr;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    CliOptions options;
+    try {
+        if (!parseArgs(argc, argv, options))
+            return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+    if (options.headerCache) {
+        HeaderCacheOptions cacheOptions;
+        cacheOptions.directory = options.headerCacheDir;
+        ModelFileUtils::setHeaderCache(std::make_shared<HeaderCache>(cacheOptions));
+    }
+    if (options.serve)
+        return serve(options);
+
+    if (options.inputs.empty() || (options.inputs.size() == 1 && options.inputs[0] == "-")) {
+        options.inputs.clear();
+        readInputs(std::cin, options.inputs);
+    }
+    if (options.inputs.empty()) {
+        usage();
+        return 2;
+    }
+
+    ModelFileUtils::setMaxConcurrentProbes(options.jobs);
+
+    std::vector<ModelFile> files;
+    files.reserve(options.inputs.size());
+    for (const std::string& input : options.inputs)
+        files.push_back(toModelFile(input));
+    if (options.group)
+        ModelFileUtils::groupShards(files);
+
+    std::mutex outputMutex;
+    size_t failed = 0;
+    ModelFileUtils::calculateMemoryUsageBatch(files, options.estimate, [&](size_t index, const MemoryUsage& usage) {
+        std::string line = toJsonLine(files[index], usage);
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (!usage.hasEstimate)
+            ++failed;
+        std::cout << line << '\n' << std::flush;
+    });
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#include "compute_buffer.h"
+
+ComputeBufferEstimate estimateComputeBuffers(const GGUFModelParams& params, uint64_t contextSize,
+                                             const BatchOptions& options) {
+    ComputeBufferEstimate estimate;
+    constexpr uint64_t F32 = sizeof(float);
+
+    uint64_t batch = std::max<uint32_t>(options.batchSize, 1);
+    uint64_t ubatch = std::min<uint64_t>(std::max<uint32_t>(options.ubatchSize, 1), batch);
+    uint64_t sequences = std::max<uint32_t>(options.parallel, 1);
+    // At most one row per batch token, and never fewer than one per sequence
+    uint64_t outputs = std::min<uint64_t>(options.outputs > 0 ? options.outputs : sequences, batch);
+    outputs = std::max(outputs, sequences);
+
+    uint64_t hidden = params.hidden_size;
+    uint64_t ffn = params.feed_forward_length;
+    if (ffn == 0) {
+        ffn = 4 * hidden;
+        estimate.approximate = true;
+    }
+    uint64_t vocab = params.vocab_size;
+    if (vocab == 0)
+        estimate.approximate = true;
+
+    // Per token of the micro-batch: input, residual and normed copies of the
+    // hidden state, then whichever sub-layer is wider at its peak. Each
+    // sequence attends only within its own context.
+    uint64_t attention = options.flashAttention ? 0 : params.attention_heads * contextSize;
+    uint64_t feedForward = 2 * ffn;         // gate and up projections alive together
+    uint64_t perToken = 3 * hidden + std::max(attention, feedForward) + vocab;
+
+    estimate.computeBytes = ubatch * perToken * F32;
+    estimate.outputBytes = outputs * vocab * F32;
+    return estimate;
+}
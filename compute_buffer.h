@@ -0,0 +1,33 @@
+#ifndef COMPUTE_BUFFER_H
+#define COMPUTE_BUFFER_H
+
+#include "gguf_reader.h"
+
+#include <cstdint>
+
+// Batching settings of a llama.cpp context (-b, -ub, -np)
+struct BatchOptions {
+    uint32_t batchSize = 2048;      // n_batch: tokens per llama_decode call
+    uint32_t ubatchSize = 512;      // n_ubatch: tokens per graph evaluation (clamped to batchSize)
+    uint32_t parallel = 1;          // n_parallel: sequences, each with its own context
+    uint32_t outputs = 0;           // Logit rows kept per batch; 0: one per sequence
+    bool flashAttention = false;    // Fused attention: no ubatch x context score matrix
+};
+
+struct ComputeBufferEstimate {
+    uint64_t computeBytes = 0;      // Scratch for one graph evaluation
+    uint64_t outputBytes = 0;       // f32 logits returned to the caller
+    bool approximate = false;       // feed_forward_length or vocab size missing
+};
+
+// Compute buffer: the peak of live f32 activations for one micro-batch,
+// sized like llama.cpp's worst-case graph reservation (every token an
+// output): the residual stream, the larger of the attention scores
+// (heads x context per token, unless flash attention) and the FFN
+// intermediates, and the vocab-wide logits. Output buffer: vocab x outputs
+// f32 logits. Missing feed_forward_length assumes 4 x hidden; a missing
+// vocab size leaves the logit terms out.
+ComputeBufferEstimate estimateComputeBuffers(const GGUFModelParams& params, uint64_t contextSize,
+                                             const BatchOptions& options = BatchOptions());
+
+#endif // COMPUTE_BUFFER_H
@@ -0,0 +1,153 @@
+#include "curl_multi_loop.h"
+
+#ifndef __EMSCRIPTEN__
+
+#include "network_context.h"
+
+#include <stdexcept>
+
+CurlMultiLoop::CurlMultiLoop(long maxHostConnections) {
+    NetworkContext::instance();
+
+    multi = curl_multi_init();
+    if (!multi)
+        throw std::runtime_error("Failed to initialize curl multi loop");
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, maxHostConnections);
+
+    thread = std::thread(&CurlMultiLoop::run, this);
+}
+
+CurlMultiLoop::~CurlMultiLoop() {
+    stop();
+    curl_multi_cleanup(multi);
+}
+
+void CurlMultiLoop::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    curl_multi_wakeup(multi);
+    // Later and concurrent callers block here until the first has joined
+    std::call_once(joined, [this]() {
+        if (thread.joinable())
+            thread.join();
+    });
+    exited.wait();
+}
+
+std::future<CURLcode> CurlMultiLoop::start(CURL* easy) {
+    std::promise<CURLcode> promise;
+    std::future<CURLcode> future = promise.get_future();
+    curl_easy_setopt(easy, CURLOPT_SHARE, NetworkContext::instance().share());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            promise.set_value(CURLE_ABORTED_BY_CALLBACK);
+            return future;
+        }
+        toStart.emplace_back(easy, std::move(promise));
+    }
+    curl_multi_wakeup(multi);
+    return future;
+}
+
+void CurlMultiLoop::stop(CURL* easy) {
+    std::future<void> stopped;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Not picked up yet: drop it without a round trip through the loop
+        for (auto it = toStart.begin(); it != toStart.end(); ++it) {
+            if (it->first == easy) {
+                it->second.set_value(CURLE_ABORTED_BY_CALLBACK);
+                toStart.erase(it);
+                return;
+            }
+        }
+        if (stopping) {
+            // The exiting loop aborts `easy` itself; it is ours once the thread is gone
+            lock.unlock();
+            exited.wait();
+            return;
+        }
+        toStop.push_back(StopRequest{easy, std::promise<void>()});
+        stopped = toStop.back().stopped.get_future();
+    }
+    curl_multi_wakeup(multi);
+    stopped.wait();
+}
+
+void CurlMultiLoop::run() {
+    std::vector<std::pair<CURL*, std::promise<CURLcode>>> starting;
+    std::vector<StopRequest> stoppingNow;
+
+    while (true) {
+        bool exiting;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            starting.swap(toStart);
+            stoppingNow.swap(toStop);
+            exiting = stopping;
+        }
+
+        for (auto& [easy, promise] : starting) {
+            if (curl_multi_add_handle(multi, easy) == CURLM_OK)
+                running.emplace(easy, std::move(promise));
+            else
+                promise.set_value(CURLE_FAILED_INIT);
+        }
+        starting.clear();
+        for (StopRequest& request : stoppingNow) {
+            if (running.count(request.easy)) {
+                curl_multi_remove_handle(multi, request.easy);
+                finish(request.easy, CURLE_ABORTED_BY_CALLBACK);
+            }
+            request.stopped.set_value();
+        }
+        stoppingNow.clear();
+
+        if (exiting)
+            break;
+
+        int active = 0;
+        curl_multi_perform(multi, &active);
+
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+            CURL* easy = msg->easy_handle;
+            CURLcode result = msg->data.result;
+            curl_multi_remove_handle(multi, easy);
+            finish(easy, result);
+        }
+
+        // Woken early by start() and both stop()s
+        curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+
+    // Shutting down: abort whatever is still in flight
+    for (auto& [easy, promise] : running) {
+        curl_multi_remove_handle(multi, easy);
+        promise.set_value(CURLE_ABORTED_BY_CALLBACK);
+    }
+    running.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& [easy, promise] : toStart)
+        promise.set_value(CURLE_ABORTED_BY_CALLBACK);
+    toStart.clear();
+    for (StopRequest& request : toStop)
+        request.stopped.set_value();
+    toStop.clear();
+    exitedPromise.set_value();
+}
+
+void CurlMultiLoop::finish(CURL* easy, CURLcode result) {
+    auto it = running.find(easy);
+    if (it == running.end())
+        return;
+    it->second.set_value(result);
+    running.erase(it);
+}
+
+#endif // __EMSCRIPTEN__
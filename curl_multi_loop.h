@@ -0,0 +1,70 @@
+#ifndef CURL_MULTI_LOOP_H
+#define CURL_MULTI_LOOP_H
+
+#ifndef __EMSCRIPTEN__
+
+#include <curl/curl.h>
+
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// One curl multi handle driven by one thread. Transfers started on it share
+// the multi's connection cache, and DNS answers and TLS sessions with every
+// other handle through the NetworkContext share object.
+// Callers keep ownership of their easy handles; a handle's callbacks run on
+// the loop thread while it is started.
+class CurlMultiLoop {
+public:
+    explicit CurlMultiLoop(long maxHostConnections = 8);
+    ~CurlMultiLoop();
+
+    CurlMultiLoop(const CurlMultiLoop&) = delete;
+    CurlMultiLoop& operator=(const CurlMultiLoop&) = delete;
+
+    // Attaches `easy` to the shared caches and runs it; the future carries the
+    // transfer result. The handle must not be touched until the future is
+    // ready or stop() has returned.
+    std::future<CURLcode> start(CURL* easy);
+
+    // Removes `easy` if it is still running (its future reports
+    // CURLE_ABORTED_BY_CALLBACK). Returns once the loop no longer uses it,
+    // which during shutdown means once the loop thread has exited.
+    void stop(CURL* easy);
+
+    // Aborts every transfer and ends the loop thread; later start() calls
+    // fail with CURLE_ABORTED_BY_CALLBACK. Idempotent and safe from several
+    // threads at once: every call returns only after the thread has exited.
+    // Not from a transfer callback. The destructor calls it.
+    void stop();
+
+private:
+    struct StopRequest {
+        CURL* easy;
+        std::promise<void> stopped;
+    };
+
+    void run();
+    void finish(CURL* easy, CURLcode result);
+
+    CURLM* multi = nullptr;
+
+    std::mutex mutex;           // Guards the queues below and `stopping`
+    std::vector<std::pair<CURL*, std::promise<CURLcode>>> toStart;
+    std::vector<StopRequest> toStop;
+    bool stopping = false;
+
+    // Loop thread only
+    std::unordered_map<CURL*, std::promise<CURLcode>> running;
+    std::thread thread;
+
+    std::once_flag joined;
+    std::promise<void> exitedPromise;   // Set by the loop thread as its last step
+    std::shared_future<void> exited = exitedPromise.get_future().share();
+};
+
+#endif // __EMSCRIPTEN__
+
+#endif // CURL_MULTI_LOOP_H
@@ -0,0 +1,57 @@
+#include "gguf_key_schema.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+GGUFKeySchema::GGUFKeySchema() : nodes(2) {}
+
+size_t GGUFKeySchema::add(std::string_view pattern, Need need) {
+    std::string_view path = pattern;
+    uint32_t root = ABSOLUTE_ROOT;
+    if (path.substr(0, 2) == "*.") {
+        root = RELATIVE_ROOT;
+        path.remove_prefix(2);
+    }
+    bool isPrefix = path.size() >= 2 && path.substr(path.size() - 2) == ".*";
+    if (isPrefix)
+        path.remove_suffix(1);      // Keep the dot: "rope." must not cover "rope_scale"
+
+    if (path.empty() || path == "." || path.find('*') != std::string_view::npos)
+        throw std::invalid_argument("Invalid metadata key pattern: " + std::string(pattern));
+
+    uint32_t id = static_cast<uint32_t>(patterns.size());
+    uint32_t node = insert(root, path);
+    (isPrefix ? nodes[node].prefix : nodes[node].exact).push_back(id);
+    hasRelative |= root == RELATIVE_ROOT;
+
+    patterns.push_back(Pattern{std::string(pattern), need});
+    if (need == Need::Required)
+        ++required;
+    return id;
+}
+
+uint32_t GGUFKeySchema::child(uint32_t node, char c) const {
+    const auto& children = nodes[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), c,
+        [](const std::pair<char, uint32_t>& edge, char ch) { return edge.first < ch; });
+    if (it == children.end() || it->first != c)
+        return NONE;
+    return it->second;
+}
+
+uint32_t GGUFKeySchema::insert(uint32_t root, std::string_view path) {
+    uint32_t node = root;
+    for (char c : path) {
+        uint32_t next = child(node, c);
+        if (next == NONE) {
+            next = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+            auto& children = nodes[node].children;
+            auto it = std::lower_bound(children.begin(), children.end(), c,
+                [](const std::pair<char, uint32_t>& edge, char ch) { return edge.first < ch; });
+            children.insert(it, {c, next});
+        }
+        node = next;
+    }
+    return node;
+}
@@ -0,0 +1,91 @@
+#ifndef GGUF_KEY_SCHEMA_H
+#define GGUF_KEY_SCHEMA_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// The set of metadata keys a caller needs, compiled into one matcher so each
+// header key is classified in a single pass over its characters.
+//
+// Patterns:
+//   "general.alignment"   the exact key
+//   "*.block_count"       the key under any architecture prefix ("llama.block_count",
+//                         "qwen2moe.block_count"); `*` stands for exactly one segment
+//   "*.rope.*"            every key below "<arch>.rope."; "general.*" works the same way
+//
+// A Required pattern holds the header scan open until some key matches it;
+// an Optional one is captured if seen before every Required pattern is
+// satisfied, but never extends the scan. A trailing `*` is satisfied by its
+// first match, so register the individual keys when each of them matters.
+class GGUFKeySchema {
+public:
+    enum class Need { Required, Optional };
+
+    GGUFKeySchema();
+
+    // Returns the pattern id (ids are assigned 0, 1, 2, ...). Throws
+    // std::invalid_argument for a malformed pattern.
+    size_t add(std::string_view pattern, Need need = Need::Required);
+
+    size_t size() const { return patterns.size(); }
+    size_t requiredCount() const { return required; }
+    const std::string& pattern(size_t id) const { return patterns[id].text; }
+    Need need(size_t id) const { return patterns[id].need; }
+
+    // Calls onMatch(id) for every pattern `key` matches
+    template <typename F>
+    void match(std::string_view key, F&& onMatch) const {
+        walk(ABSOLUTE_ROOT, key, onMatch);
+        size_t dot = key.find('.');
+        if (dot != std::string_view::npos && dot > 0 && hasRelative)
+            walk(RELATIVE_ROOT, key.substr(dot + 1), onMatch);
+    }
+
+    bool matches(std::string_view key) const {
+        bool any = false;
+        match(key, [&any](size_t) { any = true; });
+        return any;
+    }
+
+private:
+    struct Pattern {
+        std::string text;
+        Need need;
+    };
+
+    struct Node {
+        std::vector<std::pair<char, uint32_t>> children;   // Sorted by character
+        std::vector<uint32_t> exact;                        // Patterns ending here
+        std::vector<uint32_t> prefix;                       // Patterns covering anything below
+    };
+
+    static constexpr uint32_t ABSOLUTE_ROOT = 0;
+    static constexpr uint32_t RELATIVE_ROOT = 1;
+    static constexpr uint32_t NONE = 0;                     // The absolute root is never a child
+
+    uint32_t child(uint32_t node, char c) const;
+    uint32_t insert(uint32_t root, std::string_view path);
+
+    template <typename F>
+    void walk(uint32_t node, std::string_view key, F& onMatch) const {
+        for (size_t i = 0; i < key.size(); ++i) {
+            for (uint32_t id : nodes[node].prefix)
+                onMatch(static_cast<size_t>(id));
+            node = child(node, key[i]);
+            if (node == NONE)
+                return;
+        }
+        for (uint32_t id : nodes[node].exact)
+            onMatch(static_cast<size_t>(id));
+    }
+
+    std::vector<Pattern> patterns;
+    std::vector<Node> nodes;
+    size_t required = 0;
+    bool hasRelative = false;
+};
+
+#endif // GGUF_KEY_SCHEMA_H
@@ -0,0 +1,352 @@
+#include "gguf_metadata.h"
+
+#include <limits>
+#include <numeric>
+
+namespace {
+
+using Type = GGUFMetadataReader::GGUFType;
+
+template <typename T>
+T load(const char* p) {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+std::optional<int64_t> decodeInt(Type type, const char* p) {
+    switch (type) {
+    case Type::UINT8:  return load<uint8_t>(p);
+    case Type::INT8:   return load<int8_t>(p);
+    case Type::UINT16: return load<uint16_t>(p);
+    case Type::INT16:  return load<int16_t>(p);
+    case Type::UINT32: return load<uint32_t>(p);
+    case Type::INT32:  return load<int32_t>(p);
+    case Type::INT64:  return load<int64_t>(p);
+    case Type::BOOL:   return load<uint8_t>(p) != 0;
+    case Type::UINT64: {
+        uint64_t value = load<uint64_t>(p);
+        if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+            return std::nullopt;
+        return static_cast<int64_t>(value);
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<uint64_t> decodeUInt(Type type, const char* p) {
+    if (type == Type::UINT64)
+        return load<uint64_t>(p);
+    auto value = decodeInt(type, p);
+    if (!value || *value < 0)
+        return std::nullopt;
+    return static_cast<uint64_t>(*value);
+}
+
+std::optional<double> decodeFloat(Type type, const char* p) {
+    switch (type) {
+    case Type::FLOAT32: return load<float>(p);
+    case Type::FLOAT64: return load<double>(p);
+    case Type::UINT64:  return static_cast<double>(load<uint64_t>(p));
+    default:
+        if (auto value = decodeInt(type, p))
+            return static_cast<double>(*value);
+        return std::nullopt;
+    }
+}
+
+} // namespace
+
+// ----------------------- GGUFArrayView -----------------------
+std::string_view GGUFArrayView::StringIterator::operator*() const {
+    uint64_t length = load<uint64_t>(pos);
+    return std::string_view(pos + sizeof(uint64_t), static_cast<size_t>(length));
+}
+
+GGUFArrayView::StringIterator& GGUFArrayView::StringIterator::operator++() {
+    pos += sizeof(uint64_t) + static_cast<size_t>(load<uint64_t>(pos));
+    return *this;
+}
+
+const char* GGUFArrayView::element(size_t i) const {
+    size_t size = GGUFMetadataReader::fixedTypeSize(type);
+    if (size == 0 || i >= count)
+        return nullptr;
+    return data + i * size;
+}
+
+std::optional<int64_t> GGUFArrayView::intAt(size_t i) const {
+    const char* p = element(i);
+    return p ? decodeInt(type, p) : std::nullopt;
+}
+
+std::optional<uint64_t> GGUFArrayView::uintAt(size_t i) const {
+    const char* p = element(i);
+    return p ? decodeUInt(type, p) : std::nullopt;
+}
+
+std::optional<double> GGUFArrayView::floatAt(size_t i) const {
+    const char* p = element(i);
+    return p ? decodeFloat(type, p) : std::nullopt;
+}
+
+GGUFArrayView::StringIterator GGUFArrayView::begin() const {
+    return StringIterator(type == Type::STRING ? data : limit);
+}
+
+GGUFArrayView::StringIterator GGUFArrayView::end() const {
+    return StringIterator(limit);
+}
+
+std::optional<std::string_view> GGUFArrayView::stringAt(size_t i) const {
+    if (type != Type::STRING || i >= count)
+        return std::nullopt;
+    StringIterator it = begin();
+    for (size_t n = 0; n < i; ++n)
+        ++it;
+    return *it;
+}
+
+// ----------------------- GGUFMetadata -----------------------
+std::string_view GGUFMetadata::keyAt(size_t i) const {
+    return keyOf(entries[i]);
+}
+
+std::string_view GGUFMetadata::keyOf(const Entry& entry) const {
+    return std::string_view(arena.data() + entry.keyOffset, entry.keyLength);
+}
+
+const GGUFMetadata::Entry* GGUFMetadata::find(std::string_view key) const {
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), key,
+        [this](uint32_t index, std::string_view k) { return keyOf(entries[index]) < k; });
+    if (it == sorted.end() || keyOf(entries[*it]) != key)
+        return nullptr;
+    return &entries[*it];
+}
+
+void GGUFMetadata::buildIndex() {
+    sorted.resize(entries.size());
+    std::iota(sorted.begin(), sorted.end(), 0u);
+    // Stable, so a duplicated key resolves to its first occurrence like a sequential scan
+    std::stable_sort(sorted.begin(), sorted.end(), [this](uint32_t a, uint32_t b) {
+        return keyOf(entries[a]) < keyOf(entries[b]);
+    });
+}
+
+std::optional<GGUFMetadata::Type> GGUFMetadata::typeOf(std::string_view key) const {
+    const Entry* entry = find(key);
+    if (!entry)
+        return std::nullopt;
+    return entry->type;
+}
+
+std::optional<int64_t> GGUFMetadata::getInt(std::string_view key) const {
+    const Entry* entry = find(key);
+    return entry ? decodeInt(entry->type, valueOf(*entry)) : std::nullopt;
+}
+
+std::optional<uint64_t> GGUFMetadata::getUInt(std::string_view key) const {
+    const Entry* entry = find(key);
+    return entry ? decodeUInt(entry->type, valueOf(*entry)) : std::nullopt;
+}
+
+std::optional<double> GGUFMetadata::getFloat(std::string_view key) const {
+    const Entry* entry = find(key);
+    return entry ? decodeFloat(entry->type, valueOf(*entry)) : std::nullopt;
+}
+
+std::optional<bool> GGUFMetadata::getBool(std::string_view key) const {
+    const Entry* entry = find(key);
+    if (!entry || entry->type != Type::BOOL)
+        return std::nullopt;
+    return load<uint8_t>(valueOf(*entry)) != 0;
+}
+
+std::optional<std::string_view> GGUFMetadata::getString(std::string_view key) const {
+    const Entry* entry = find(key);
+    if (!entry || entry->type != Type::STRING)
+        return std::nullopt;
+    const char* p = valueOf(*entry);
+    return std::string_view(p + sizeof(uint64_t), static_cast<size_t>(load<uint64_t>(p)));
+}
+
+std::optional<GGUFArrayView> GGUFMetadata::getArray(std::string_view key) const {
+    const Entry* entry = find(key);
+    if (!entry || entry->type != Type::ARRAY)
+        return std::nullopt;
+    return arrayOf(*entry);
+}
+
+GGUFArrayView GGUFMetadata::arrayOf(const Entry& entry) const {
+    // Encoded as element type, count, elements; the value ends where the next one starts
+    const char* p = valueOf(entry);
+    size_t index = static_cast<size_t>(&entry - entries.data());
+    size_t endOffset = index + 1 < entries.size() ? entries[index + 1].keyOffset : arena.size();
+    Type elementType = static_cast<Type>(load<uint32_t>(p));
+    uint64_t count = load<uint64_t>(p + sizeof(uint32_t));
+    return GGUFArrayView(elementType, count, p + sizeof(uint32_t) + sizeof(uint64_t),
+                         arena.data() + endOffset);
+}
+
+const GGUFKeySchema& GGUFMetadata::modelParamsSchema() {
+    static const GGUFKeySchema schema = []() {
+        using Need = GGUFKeySchema::Need;
+        GGUFKeySchema s;
+        s.add("*.attention.head_count");                            // HEAD_COUNT
+        s.add("*.attention.head_count_kv", Need::Optional);         // HEAD_COUNT_KV
+        s.add("*.block_count");                                     // BLOCK_COUNT
+        s.add("*.embedding_length");                                // EMBEDDING_LENGTH
+        s.add("general.alignment", Need::Optional);                 // ALIGNMENT
+        s.add("general.architecture", Need::Optional);              // ARCHITECTURE
+        s.add("*.attention.key_length", Need::Optional);            // KEY_LENGTH
+        s.add("*.attention.value_length", Need::Optional);          // VALUE_LENGTH
+        s.add("*.attention.sliding_window", Need::Optional);        // SLIDING_WINDOW
+        s.add("*.attention.sliding_window_pattern", Need::Optional);  // SLIDING_WINDOW_PATTERN
+        s.add("*.feed_forward_length", Need::Optional);             // FEED_FORWARD_LENGTH
+        s.add("*.vocab_size", Need::Optional);                      // VOCAB_SIZE
+        s.add("*.expert_count", Need::Optional);                    // EXPERT_COUNT
+        s.add("*.expert_used_count", Need::Optional);               // EXPERT_USED_COUNT
+        s.add("*.expert_shared_count", Need::Optional);             // EXPERT_SHARED_COUNT
+        s.add("split.no", Need::Optional);                          // SPLIT_NO
+        s.add("split.count", Need::Optional);                       // SPLIT_COUNT
+        s.add("general.file_type", Need::Optional);                 // FILE_TYPE
+        return s;
+    }();
+    return schema;
+}
+
+std::optional<std::string_view> GGUFMetadata::matchedKey(size_t id) const {
+    if (id >= patternMatches.size() || patternMatches[id] == NO_MATCH)
+        return std::nullopt;
+    return keyOf(entries[patternMatches[id]]);
+}
+
+namespace {
+
+// Every n-th layer attends globally, the rest within the window (llama.cpp's
+// swa pattern; 0: every layer is windowed)
+std::vector<bool> periodicSlidingLayers(uint32_t layers, uint64_t period) {
+    std::vector<bool> sliding(layers);
+    for (uint32_t il = 0; il < layers; ++il)
+        sliding[il] = period == 0 || il % period < period - 1;
+    return sliding;
+}
+
+// Interleaved local/global attention that the converter does not record in the header
+std::optional<uint32_t> defaultSlidingPeriod(std::string_view architecture) {
+    static const std::pair<std::string_view, uint32_t> periods[] = {
+        {"gemma2", 2}, {"gemma3", 6}, {"gemma3n", 5}, {"cohere2", 4}, {"exaone4", 4}, {"gpt-oss", 2},
+    };
+    for (const auto& [name, period] : periods)
+        if (name == architecture)
+            return period;
+    return std::nullopt;
+}
+
+} // namespace
+
+std::optional<GGUFModelParams> GGUFMetadata::modelParams() const {
+    const GGUFKeySchema& schema = modelParamsSchema();
+    const Entry* found[PARAM_KEY_COUNT] = {};
+
+    // First occurrence per key wins, as in the reader's scan
+    for (const Entry& entry : entries)
+        schema.match(keyOf(entry), [&](size_t id) {
+            if (!found[id])
+                found[id] = &entry;
+        });
+
+    auto scalar = [&](ParamKey id) -> std::optional<uint64_t> {
+        const Entry* entry = found[id];
+        if (!entry || entry->type == Type::BOOL || entry->type == Type::ARRAY)
+            return std::nullopt;
+        return decodeUInt(entry->type, valueOf(*entry));
+    };
+    // Per-layer values stored as an array (hybrid and variable-width models)
+    auto perLayer = [&](ParamKey id) {
+        std::vector<uint32_t> values;
+        const Entry* entry = found[id];
+        if (!entry || entry->type != Type::ARRAY)
+            return values;
+        GGUFArrayView array = arrayOf(*entry);
+        values.reserve(array.size());
+        for (size_t i = 0; i < array.size(); ++i) {
+            auto value = array.uintAt(i);
+            if (!value) {
+                values.clear();
+                break;
+            }
+            values.push_back(static_cast<uint32_t>(*value));
+        }
+        return values;
+    };
+
+    std::vector<uint32_t> layerHeads = perLayer(HEAD_COUNT);
+    std::vector<uint32_t> layerKvHeads = perLayer(HEAD_COUNT_KV);
+    std::optional<uint64_t> heads = scalar(HEAD_COUNT);
+    if (!heads && !layerHeads.empty())
+        heads = *std::max_element(layerHeads.begin(), layerHeads.end());
+    auto layers = scalar(BLOCK_COUNT);
+    auto hidden = scalar(EMBEDDING_LENGTH);
+    if (!heads || !layers || !hidden)
+        return std::nullopt;
+
+    GGUFModelParams params;
+    params.attention_heads = static_cast<uint32_t>(*heads);
+    params.hidden_layers = static_cast<uint32_t>(*layers);
+    params.hidden_size = *hidden;
+    if (auto kvHeads = scalar(HEAD_COUNT_KV))
+        params.kv_heads = static_cast<uint32_t>(*kvHeads);
+    else if (!layerKvHeads.empty())
+        params.kv_heads = *std::max_element(layerKvHeads.begin(), layerKvHeads.end());
+    else
+        params.kv_heads = params.attention_heads;
+
+    // Without head_count_kv every layer has as many KV heads as query heads
+    if (layerKvHeads.empty() && !found[HEAD_COUNT_KV])
+        layerKvHeads = std::move(layerHeads);
+    if (layerKvHeads.size() == params.hidden_layers)
+        params.layer_kv_heads = std::move(layerKvHeads);
+
+    if (found[ARCHITECTURE] && found[ARCHITECTURE]->type == Type::STRING) {
+        const char* p = valueOf(*found[ARCHITECTURE]);
+        params.architecture.assign(p + sizeof(uint64_t), static_cast<size_t>(load<uint64_t>(p)));
+    }
+    params.key_length = static_cast<uint32_t>(scalar(KEY_LENGTH).value_or(0));
+    params.value_length = static_cast<uint32_t>(scalar(VALUE_LENGTH).value_or(0));
+    params.sliding_window = static_cast<uint32_t>(scalar(SLIDING_WINDOW).value_or(0));
+    params.vocab_size = static_cast<uint32_t>(scalar(VOCAB_SIZE).value_or(0));
+    params.expert_count = static_cast<uint32_t>(scalar(EXPERT_COUNT).value_or(0));
+    params.expert_used_count = static_cast<uint32_t>(scalar(EXPERT_USED_COUNT).value_or(0));
+    params.expert_shared_count = static_cast<uint32_t>(scalar(EXPERT_SHARED_COUNT).value_or(0));
+    if (auto fileType = scalar(FILE_TYPE))
+        params.file_type = static_cast<uint32_t>(*fileType);
+    if (auto ffn = scalar(FEED_FORWARD_LENGTH)) {
+        params.feed_forward_length = *ffn;
+    } else {
+        std::vector<uint32_t> layerFfn = perLayer(FEED_FORWARD_LENGTH);
+        if (!layerFfn.empty())
+            params.feed_forward_length = *std::max_element(layerFfn.begin(), layerFfn.end());
+    }
+
+    // Which layers use the window: a per-layer flag array, a period, or the
+    // architecture's fixed interleave. Otherwise the window is not trusted and
+    // every layer is costed as full attention, which never underestimates.
+    if (params.sliding_window > 0) {
+        const Entry* pattern = found[SLIDING_WINDOW_PATTERN];
+        if (pattern && pattern->type == Type::ARRAY) {
+            GGUFArrayView flags = arrayOf(*pattern);
+            if (flags.size() == params.hidden_layers) {
+                params.layer_sliding.resize(flags.size());
+                for (size_t il = 0; il < flags.size(); ++il)
+                    params.layer_sliding[il] = flags.intAt(il).value_or(0) != 0;
+            }
+        } else if (auto period = scalar(SLIDING_WINDOW_PATTERN)) {
+            params.layer_sliding = periodicSlidingLayers(params.hidden_layers, *period);
+        } else if (auto period = defaultSlidingPeriod(params.architecture)) {
+            params.layer_sliding = periodicSlidingLayers(params.hidden_layers, *period);
+        }
+    }
+    return params;
+}
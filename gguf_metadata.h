@@ -0,0 +1,141 @@
+#ifndef GGUF_METADATA_H
+#define GGUF_METADATA_H
+
+#include "gguf_reader.h"
+#include "gguf_key_schema.h"
+
+#include <iterator>
+
+// Lazy view of one metadata array inside a GGUFMetadata arena. Elements are
+// decoded only when read and nothing is allocated; the view is valid while
+// the GGUFMetadata it came from is alive and not moved.
+class GGUFArrayView {
+public:
+    using Type = GGUFMetadataReader::GGUFType;
+
+    // Walks STRING elements in order, yielding views into the arena
+    class StringIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = std::string_view;
+
+        StringIterator() = default;
+        std::string_view operator*() const;
+        StringIterator& operator++();
+        StringIterator operator++(int) { StringIterator old = *this; ++*this; return old; }
+        bool operator==(const StringIterator& other) const { return pos == other.pos; }
+        bool operator!=(const StringIterator& other) const { return pos != other.pos; }
+
+    private:
+        friend class GGUFArrayView;
+        explicit StringIterator(const char* pos) : pos(pos) {}
+        const char* pos = nullptr;
+    };
+
+    GGUFArrayView() = default;
+
+    Type elementType() const { return type; }
+    size_t size() const { return static_cast<size_t>(count); }
+    bool empty() const { return count == 0; }
+
+    // Numeric and BOOL elements, converted like the GGUFMetadata getters;
+    // nullopt past the end, for other element types, or when out of range
+    std::optional<int64_t> intAt(size_t i) const;
+    std::optional<uint64_t> uintAt(size_t i) const;
+    std::optional<double> floatAt(size_t i) const;
+
+    // STRING elements; stringAt() walks from the start, so iterate for bulk access
+    StringIterator begin() const;
+    StringIterator end() const;
+    std::optional<std::string_view> stringAt(size_t i) const;
+
+private:
+    friend class GGUFMetadata;
+    GGUFArrayView(Type type, uint64_t count, const char* data, const char* limit)
+        : type(type), count(count), data(data), limit(limit) {}
+
+    const char* element(size_t i) const;
+
+    Type type = Type::UINT8;
+    uint64_t count = 0;
+    const char* data = nullptr;     // First element
+    const char* limit = nullptr;    // One past the last element
+};
+
+// Every metadata key of a GGUF header, indexed in one pass. Keys and raw
+// values are kept in a single arena with a flat table of (key, type, value
+// offset); scalars are decoded on demand and arrays are returned as lazy
+// views, so one parse serves any number of lookups.
+class GGUFMetadata {
+public:
+    using Type = GGUFMetadataReader::GGUFType;
+
+    uint32_t version() const { return fileVersion; }
+    uint64_t tensorCount() const { return tensors; }
+
+    // Keys in file order
+    size_t size() const { return entries.size(); }
+    std::string_view keyAt(size_t i) const;
+    Type typeAt(size_t i) const { return entries[i].type; }
+
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+    std::optional<Type> typeOf(std::string_view key) const;
+
+    // Integer and BOOL values of any width; nullopt if the key is missing,
+    // holds another type, or the value does not fit
+    std::optional<int64_t> getInt(std::string_view key) const;
+    std::optional<uint64_t> getUInt(std::string_view key) const;
+    // FLOAT32/FLOAT64, or any integer
+    std::optional<double> getFloat(std::string_view key) const;
+    std::optional<bool> getBool(std::string_view key) const;
+    // View into the arena
+    std::optional<std::string_view> getString(std::string_view key) const;
+    std::optional<GGUFArrayView> getArray(std::string_view key) const;
+
+    // The parameters readModelParams() extracts, from the indexed keys
+    std::optional<GGUFModelParams> modelParams() const;
+
+    // Keys behind modelParams(); pattern ids follow ParamKey
+    enum ParamKey : size_t {
+        HEAD_COUNT, HEAD_COUNT_KV, BLOCK_COUNT, EMBEDDING_LENGTH, ALIGNMENT,
+        ARCHITECTURE, KEY_LENGTH, VALUE_LENGTH, SLIDING_WINDOW, SLIDING_WINDOW_PATTERN,
+        FEED_FORWARD_LENGTH, VOCAB_SIZE, EXPERT_COUNT, EXPERT_USED_COUNT, EXPERT_SHARED_COUNT,
+        SPLIT_NO, SPLIT_COUNT, FILE_TYPE,
+        PARAM_KEY_COUNT
+    };
+    static const GGUFKeySchema& modelParamsSchema();
+
+    // First key that matched pattern `id` of the schema this index was read
+    // with; nullopt without a schema or when nothing matched
+    std::optional<std::string_view> matchedKey(size_t id) const;
+
+private:
+    friend class GGUFMetadataReader;
+
+    struct Entry {
+        uint32_t keyOffset;
+        uint32_t keyLength;
+        Type type;
+        uint64_t valueOffset;       // Raw GGUF encoding of the value in `arena`
+    };
+
+    const Entry* find(std::string_view key) const;
+    std::string_view keyOf(const Entry& entry) const;
+    const char* valueOf(const Entry& entry) const { return arena.data() + entry.valueOffset; }
+    GGUFArrayView arrayOf(const Entry& entry) const;
+    void buildIndex();
+
+    static constexpr uint32_t NO_MATCH = UINT32_MAX;
+
+    uint32_t fileVersion = 0;
+    uint64_t tensors = 0;
+    std::string arena;
+    std::vector<Entry> entries;     // File order
+    std::vector<uint32_t> sorted;   // Entry indices ordered by key, for binary search
+    std::vector<uint32_t> patternMatches;   // Per schema pattern: first matching entry, or NO_MATCH
+};
+
+#endif // GGUF_METADATA_H
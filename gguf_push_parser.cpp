@@ -0,0 +1,136 @@
+#include "gguf_push_parser.h"
+
+GGUFPushParser::GGUFPushParser(const UrlReadAhead& sizing, bool requireParams)
+    : sizing(sizing), requireParams(requireParams), chunk(sizing.initialChunk),
+      started(std::chrono::steady_clock::now()) {
+    probe.source = "push";
+}
+
+GGUFPushParser::State GGUFPushParser::push(const char* data, size_t size) {
+    if (current != State::NeedMore)
+        return current;
+    source.append(data, size);
+    ++probe.requests;
+    probe.bytesReceived += size;
+    chunk = std::min(chunk * 2, std::max(sizing.maxChunk, sizing.initialChunk));
+    if (size == 0)
+        return finish();
+    return parse();
+}
+
+GGUFPushParser::State GGUFPushParser::finish() {
+    if (current != State::NeedMore)
+        return current;
+    finished = true;
+    return parse();
+}
+
+void GGUFPushParser::setTotalSize(uint64_t size) {
+    source.setTotalSize(size);
+}
+
+uint64_t GGUFPushParser::nextFetchSize() const {
+    if (current != State::NeedMore)
+        return 0;
+    uint64_t buffered = source.size();
+    uint64_t size = std::max<uint64_t>(chunk, wanted > buffered ? wanted - buffered : 0);
+    if (source.totalSize() > buffered)
+        size = std::min(size, source.totalSize() - buffered);
+    return size;
+}
+
+GGUFPushParser::State GGUFPushParser::fail(std::string reason) {
+    message = std::move(reason);
+    current = State::Failed;
+    return current;
+}
+
+GGUFPushParser::State GGUFPushParser::parse() {
+    if (source.size() == 0)
+        return finished ? fail("No data") : current;
+
+    double cpuStarted = threadCpuMs();
+    GGUFModelInfo info;
+    source.seek(0);
+    GGUFCursor cursor(&source);
+    bool ok = false;
+    bool truncated = false;
+    std::string reason;
+    try {
+        ok = reader.parseHeader(cursor, info, true, requireParams, false, &probe);
+        if (!ok)
+            reason = requireParams ? "Not a GGUF model header" : "Not a GGUF header";
+    } catch (const std::exception& e) {
+        truncated = cursor.wantedEnd() > source.size();
+        reason = e.what();
+    }
+    probe.parseCpuMs += threadCpuMs() - cpuStarted;
+    probe.bytesUsed = cursor.tell();
+    probe.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    if (ok) {
+        info.file_size = source.totalSize();
+        parsed = std::move(info);
+        probe.files = 1;
+        current = State::Done;
+        return current;
+    }
+
+    uint64_t total = source.totalSize();
+    bool atEnd = finished || (total > 0 && source.size() >= total);
+    if (!truncated || atEnd)
+        return fail(reason);
+    if (cursor.wantedEnd() > MAX_HEADER_BYTES || (total > 0 && cursor.wantedEnd() > total))
+        return fail(reason + " (header would end at byte " + std::to_string(cursor.wantedEnd()) + ")");
+    wanted = cursor.wantedEnd();
+    return current;
+}
+
+#ifdef __EMSCRIPTEN__
+// ----------------------- Embind -----------------------
+// Sizes cross as doubles, exact up to 2^53 bytes.
+static GGUFPushParser::State pushBytes(GGUFPushParser& parser, const emscripten::val& bytes) {
+    std::vector<char> chunk(bytes["length"].as<size_t>());
+    emscripten::val view(emscripten::typed_memory_view(chunk.size(), reinterpret_cast<unsigned char*>(chunk.data())));
+    view.call<void>("set", bytes);
+    return parser.push(chunk.data(), chunk.size());
+}
+
+static void setTotalSizeJS(GGUFPushParser& parser, double size) {
+    parser.setTotalSize(size > 0 ? static_cast<uint64_t>(size) : 0);
+}
+
+static double bytesBufferedJS(const GGUFPushParser& parser) {
+    return static_cast<double>(parser.bytesBuffered());
+}
+
+static double totalSizeJS(const GGUFPushParser& parser) {
+    return static_cast<double>(parser.totalSize());
+}
+
+static double nextFetchSizeJS(const GGUFPushParser& parser) {
+    return static_cast<double>(parser.nextFetchSize());
+}
+
+static std::string errorJS(const GGUFPushParser& parser) {
+    return parser.error();
+}
+
+EMSCRIPTEN_BINDINGS(gguf_push_bindings) {
+    emscripten::enum_<GGUFPushParser::State>("GGUFPushState")
+        .value("NeedMore", GGUFPushParser::State::NeedMore)
+        .value("Done",     GGUFPushParser::State::Done)
+        .value("Failed",   GGUFPushParser::State::Failed);
+
+    emscripten::class_<GGUFPushParser>("GGUFPushParser")
+        .constructor<>()
+        .function("push",          &pushBytes)
+        .function("finish",        &GGUFPushParser::finish)
+        .function("setTotalSize",  &setTotalSizeJS)
+        .function("state",         &GGUFPushParser::state)
+        .function("bytesBuffered", &bytesBufferedJS)
+        .function("totalSize",     &totalSizeJS)
+        .function("nextFetchSize", &nextFetchSizeJS)
+        .function("error",         &errorJS);
+}
+#endif
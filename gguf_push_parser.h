@@ -0,0 +1,74 @@
+#ifndef GGUF_PUSH_PARSER_H
+#define GGUF_PUSH_PARSER_H
+
+#include "gguf_reader.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Header parser driven by the caller's I/O, for the browser: JavaScript
+// fetches ranges itself and pushes each one in file order until the state
+// leaves NeedMore, so no C++ frame ever waits on a fetch and the module
+// needs neither ASYNCIFY nor JSPI.
+//
+// Each push re-parses the buffered prefix in place (GGUFCursor over a
+// BufferDataSource). Fetch sizes from nextFetchSize() double per request up
+// to maxChunk, so there are few attempts, and re-parsing a few MB of header
+// costs milliseconds, less than the round trip it waits for anyway.
+//
+// Browser build (from the repository root):
+//   emcc -std=c++17 -O2 --bind -sMODULARIZE -sEXPORT_NAME=createGGUF -sALLOW_MEMORY_GROWTH
+//        -I. $(ls *.cpp) -o public/gguf_reader.js
+// Adding -DGGUF_WASM_ASYNC_FETCH together with -sJSPI or -sASYNCIFY also
+// builds the blocking URL entry points (calcMemoryFromUrl, readParamsFromUrl).
+class GGUFPushParser {
+public:
+    enum class State { NeedMore, Done, Failed };
+
+    // `sizing` bounds the fetch sizes (initialChunk growing to maxChunk)
+    explicit GGUFPushParser(const UrlReadAhead& sizing = UrlReadAhead(), bool requireParams = true);
+
+    // Appends the next `size` bytes of the file, which start at bytesBuffered()
+    State push(const char* data, size_t size);
+
+    // No more bytes will come (end of file, or the fetch failed)
+    State finish();
+
+    // Whole-file size (Content-Range), reported as GGUFModelInfo::file_size;
+    // also keeps nextFetchSize() inside the file
+    void setTotalSize(uint64_t size);
+
+    State state() const { return current; }
+    uint64_t bytesBuffered() const { return source.size(); }
+    uint64_t totalSize() const { return source.totalSize(); }  // 0 until setTotalSize()
+
+    // Bytes to fetch next, starting at bytesBuffered(); 0 unless NeedMore
+    uint64_t nextFetchSize() const;
+
+    const GGUFModelInfo& info() const { return parsed; }   // Valid once Done
+    const std::string& error() const { return message; }   // Set once Failed
+    const ProbeStats& stats() const { return probe; }
+
+private:
+    State parse();
+    State fail(std::string reason);
+
+    GGUFMetadataReader reader;
+    BufferDataSource source;
+    UrlReadAhead sizing;
+    bool requireParams;
+    bool finished = false;
+    State current = State::NeedMore;
+    GGUFModelInfo parsed;
+    std::string message;
+    ProbeStats probe;
+    uint64_t wanted = 0;            // Offset the last attempt ran out at
+    size_t chunk;                   // Next fetch size before `wanted` is considered
+    std::chrono::steady_clock::time_point started;
+
+    // No real header comes close; a corrupt length must not make the page fetch the model
+    static constexpr uint64_t MAX_HEADER_BYTES = 256ull * 1024 * 1024;
+};
+
+#endif // GGUF_PUSH_PARSER_H
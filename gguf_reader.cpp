@@ -1,19 +1,40 @@
 #include "gguf_reader.h"
+#include "gguf_metadata.h"
+#include "gguf_key_schema.h"
+#include "header_cache.h"
+#include "curl_multi_loop.h"
+#include "network_context.h"
 
-#ifdef __EMSCRIPTEN__
-// Async Range fetch: writes up to `len` bytes into `out`, returns #bytes or negative on error.
-EM_ASYNC_JS(int, wasm_range_fetch, (const char* url, size_t start, size_t len, char* out), {
+#include <chrono>
+#include <limits>
+
+#ifdef GGUF_HAVE_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#if defined(__EMSCRIPTEN__) && defined(GGUF_WASM_ASYNC_FETCH)
+// Async Range fetch (needs -sJSPI or -sASYNCIFY): writes up to `len` bytes into `out`, returns #bytes or negative on error.
+// The total file size from Content-Range (or Content-Length of a 200) is stored in `*total`.
+EM_ASYNC_JS(int, wasm_range_fetch, (const char* url, size_t start, size_t len, char* out, double* total), {
   const u = UTF8ToString(url);
   const end = start + len - 1;
   try {
     const resp = await fetch(u, { headers: { 'Range': 'bytes=' + start + '-' + end } });
     // Some servers may ignore Range and return 200; still usable if small
     if (!resp.ok) return -resp.status;
+    const cr = resp.headers.get('content-range');
+    const m = cr ? cr.match(/\/(\d+)\s*$/) : null;
+    const cl = resp.status === 200 ? resp.headers.get('content-length') : null;
+    const n = m ? Number(m[1]) : (cl ? Number(cl) : 0);
+    if (Number.isFinite(n) && n > 0) HEAPF64[total >> 3] = n;
     const ab = await resp.arrayBuffer();
     const arr = new Uint8Array(ab);
-    const n = Math.min(arr.length, len);
-    HEAPU8.set(arr.subarray(0, n), out);
-    return n;
+    const got = Math.min(arr.length, len);
+    HEAPU8.set(arr.subarray(0, got), out);
+    return got;
   } catch (e) {
     return -1;
   }
@@ -22,9 +43,11 @@ EM_ASYNC_JS(int, wasm_range_fetch, (const char* url, size_t start, size_t len, c
 
 // ----------------------- FileDataSource -----------------------
 FileDataSource::FileDataSource(const std::string& filename) {
-    file.open(filename, std::ios::binary);
+    file.open(filename, std::ios::binary | std::ios::ate);
     if (!file)
         throw std::runtime_error("Failed to open file: " + filename);
+    fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
 }
 
 FileDataSource::~FileDataSource() {
@@ -34,10 +57,19 @@ FileDataSource::~FileDataSource() {
 
 bool FileDataSource::read(char* buffer, size_t size) {
     file.read(buffer, size);
+    if (stats) {
+        ++stats->requests;
+        stats->bytesRequested += size;
+        stats->bytesReceived += static_cast<uint64_t>(file.gcount());
+    }
     return file.good() || (file.eof() && file.gcount() > 0);
 }
 
 bool FileDataSource::seek(size_t position) {
+    // seekg drops the stream buffer whenever the position moves
+    if (stats && position != tell())
+        ++stats->discardingSeeks;
+    file.clear();
     file.seekg(position);
     return file.good();
 }
@@ -50,22 +82,130 @@ size_t FileDataSource::tell() {
     return static_cast<size_t>(file.tellg());
 }
 
+size_t FileDataSource::readSome(char* buffer, size_t size) {
+    file.read(buffer, size);
+    if (stats) {
+        ++stats->requests;
+        stats->bytesRequested += size;
+        stats->bytesReceived += static_cast<uint64_t>(file.gcount());
+    }
+    return static_cast<size_t>(file.gcount());
+}
+
+#ifdef GGUF_HAVE_MMAP
+// ----------------------- MmapDataSource -----------------------
+MmapDataSource::MmapDataSource(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("Failed to open file: " + filename);
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat file: " + filename);
+    }
+    length = static_cast<size_t>(st.st_size);
+
+    if (length > 0) {
+        void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to mmap file: " + filename);
+        }
+        // The header is consumed front to back exactly once
+        ::madvise(p, length, MADV_SEQUENTIAL);
+        mapping = static_cast<const char*>(p);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MmapDataSource::~MmapDataSource() {
+    if (mapping)
+        ::munmap(const_cast<char*>(mapping), length);
+}
+
+bool MmapDataSource::read(char* buffer, size_t size) {
+    if (size > length - pos) {
+        _eof = true;
+        return false;
+    }
+    memcpy(buffer, mapping + pos, size);
+    pos += size;
+    return true;
+}
+
+bool MmapDataSource::seek(size_t position) {
+    if (position > length) {
+        _eof = true;
+        return false;
+    }
+    pos = position;
+    _eof = false;
+    return true;
+}
+
+bool MmapDataSource::eof() const {
+    return _eof;
+}
+
+size_t MmapDataSource::tell() {
+    return pos;
+}
+
+size_t MmapDataSource::readSome(char* buffer, size_t size) {
+    size_t n = std::min(size, length - pos);
+    if (n == 0)
+        _eof = true;
+    memcpy(buffer, mapping + pos, n);
+    pos += n;
+    return n;
+}
+#endif
+
+// ----------------------- BufferDataSource -----------------------
+bool BufferDataSource::read(char* buffer, size_t size) {
+    return readSome(buffer, size) == size;
+}
+
+bool BufferDataSource::seek(size_t position) {
+    pos = std::min(position, bytes.size());
+    return position <= bytes.size();
+}
+
+size_t BufferDataSource::readSome(char* buffer, size_t size) {
+    size_t n = std::min(size, bytes.size() - pos);
+    memcpy(buffer, bytes.data() + pos, n);
+    pos += n;
+    return n;
+}
+
 // ----------------------- UrlDataSource -----------------------
-UrlDataSource::UrlDataSource(const std::string& url) : url(url) {
+UrlDataSource::UrlDataSource(const std::string& url, const UrlReadAhead& readAhead) : url(url) {
 #ifdef __EMSCRIPTEN__
+    (void)readAhead;
     downloadedData.resize(BUFFER_SIZE);
 #else
-    curl = curl_easy_init();
-    if (!curl)
-        throw std::runtime_error("Failed to initialize curl");
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &writeData);
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &abortDownload);
+    this->readAhead = readAhead;
+    if (readAhead.enabled) {
+        multi = curl_multi_init();
+        if (!multi)
+            throw std::runtime_error("Failed to initialize curl multi handle");
+        // Ranges of one file share the host; let them reuse and pipeline connections
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(readAhead.maxRequests));
+    } else {
+        // Sequential ranges on one borrowed handle, which keeps its connection warm
+        curl = NetworkContext::instance().acquire(url);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &writeData);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &easyHeaders);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &abortDownload);
+    }
 
     downloadedData.resize(BUFFER_SIZE);
 #endif
@@ -76,10 +216,26 @@ UrlDataSource::UrlDataSource(const std::string& url) : url(url) {
     _eof = false;
 }
 
+#ifndef __EMSCRIPTEN__
+UrlDataSource::UrlDataSource(const std::string& url, const UrlReadAhead& readAhead,
+                             std::shared_ptr<CurlMultiLoop> loop)
+    : url(url), loop(std::move(loop)) {
+    this->readAhead = readAhead;
+    // Every range goes through the loop, so no private easy or multi handle is needed
+    downloadedData.resize(BUFFER_SIZE);
+}
+#endif
+
 UrlDataSource::~UrlDataSource() {
 #ifndef __EMSCRIPTEN__
+    cancelAhead();
+    NetworkContext& network = NetworkContext::instance();
+    for (CURL* easy : idleHandles)
+        network.release(url, easy);
+    if (multi)
+        curl_multi_cleanup(multi);
     if (curl)
-        curl_easy_cleanup(curl);
+        network.release(url, curl);
 #endif
 }
 
@@ -96,40 +252,8 @@ bool UrlDataSource::read(char* buffer, size_t size) {
             bufferPos = 0;
         }
 
-#ifdef __EMSCRIPTEN__
-        // Fill more via fetch range
-        int got = wasm_range_fetch(
-            url.c_str(),
-            currentPos + bufferSize,
-            CHUNK_SIZE,
-            &downloadedData[bufferSize]
-        );
-        if (got <= 0) {
-            _eof = true;
+        if (!fetchMore())
             return false;
-        }
-        bufferSize += static_cast<size_t>(got);
-#else
-        // Native path via libcurl
-        writeData.buffer = &downloadedData[bufferSize];
-        writeData.size = downloadedData.size() - bufferSize;
-        writeData.pos = 0;
-        writeData.abort_download = &abortDownload;
-
-        std::string range = std::to_string(currentPos + bufferSize) + "-" +
-                            std::to_string(currentPos + bufferSize + CHUNK_SIZE - 1);
-        curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
-
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK && res != CURLE_WRITE_ERROR) {
-            return false;
-        }
-        if (writeData.pos == 0) {
-            _eof = true;
-            return false;
-        }
-        bufferSize += writeData.pos;
-#endif
     }
 
     size_t copySize = std::min<size_t>(size, bufferSize - bufferPos);
@@ -140,12 +264,114 @@ bool UrlDataSource::read(char* buffer, size_t size) {
     return copySize == size;
 }
 
+size_t UrlDataSource::readSome(char* buffer, size_t size) {
+    if (bufferPos >= bufferSize) {
+        bufferSize = 0;
+        bufferPos = 0;
+        if (!fetchMore())
+            return 0;
+    }
+
+    size_t copySize = std::min<size_t>(size, bufferSize - bufferPos);
+    memcpy(buffer, &downloadedData[bufferPos], copySize);
+    bufferPos += copySize;
+    currentPos += copySize;
+    return copySize;
+}
+
+// Appends the next range to the buffer; false on error or end of data
+bool UrlDataSource::fetchMore() {
+    size_t fetchPos = currentPos - bufferPos + bufferSize;
+    size_t room = std::min(CHUNK_SIZE, downloadedData.size() - bufferSize);
+    if (room == 0)
+        return false;
+
+#ifndef __EMSCRIPTEN__
+    if (multi || loop)
+        return fetchAhead(fetchPos);
+#endif
+
+#ifdef __EMSCRIPTEN__
+#ifndef GGUF_WASM_ASYNC_FETCH
+    // Pages feed a GGUFPushParser instead; openSource() does not get here
+    (void)fetchPos;
+    _eof = true;
+    return false;
+#else
+    // Fill more via fetch range
+    double total = 0;
+    auto started = std::chrono::steady_clock::now();
+    int got = wasm_range_fetch(
+        url.c_str(),
+        fetchPos,
+        room,
+        &downloadedData[bufferSize],
+        &total
+    );
+    if (stats) {
+        ++stats->requests;
+        stats->bytesRequested += room;
+        stats->bytesReceived += got > 0 ? static_cast<uint64_t>(got) : 0;
+        stats->requestMs.push_back(
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count());
+    }
+    if (total > 0 && totalBytes == 0)
+        totalBytes = static_cast<uint64_t>(total);
+    if (got <= 0) {
+        _eof = true;
+        return false;
+    }
+    bufferSize += static_cast<size_t>(got);
+#endif
+#else
+    // Native path via libcurl
+    writeData.buffer = &downloadedData[bufferSize];
+    writeData.size = room;
+    writeData.pos = 0;
+    writeData.abort_download = &abortDownload;
+
+    std::string range = std::to_string(fetchPos) + "-" +
+                        std::to_string(fetchPos + room - 1);
+    curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+
+    CURLcode res = curl_easy_perform(curl);
+    adoptHeaders(easyHeaders);
+    if (stats) {
+        ++stats->requests;
+        stats->bytesRequested += room;
+        stats->bytesReceived += writeData.pos;
+        recordTransfer(curl);
+    }
+    if (res != CURLE_OK && res != CURLE_WRITE_ERROR) {
+        return false;
+    }
+    if (totalBytes == 0) {
+        // Server ignored the range: a 200 carries the whole file, so its length is the total
+        long status = 0;
+        curl_off_t length = -1;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+        if (status == 200 &&
+            curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK &&
+            length > 0)
+            totalBytes = static_cast<uint64_t>(length);
+    }
+    if (writeData.pos == 0) {
+        _eof = true;
+        return false;
+    }
+    bufferSize += writeData.pos;
+#endif
+    return true;
+}
+
 bool UrlDataSource::seek(size_t position) {
     if (position >= currentPos - bufferPos && position < currentPos + (bufferSize - bufferPos)) {
         bufferPos = position - (currentPos - bufferPos);
         currentPos = position;
         return true;
     }
+    if (stats && bufferSize > 0)
+        ++stats->discardingSeeks;
     bufferSize = 0;
     bufferPos = 0;
     currentPos = position;
@@ -179,291 +405,950 @@ size_t UrlDataSource::WriteCallback(char* ptr, size_t size, size_t nmemb, void*
     return bytes;
 }
 
+// Serves the range at `fetchPos` from the read-ahead pipeline, realigning it
+// after seeks and topping it up once the front range has been consumed.
+bool UrlDataSource::fetchAhead(size_t fetchPos) {
+    while (!ahead.empty() && ahead.front()->start + ahead.front()->length <= fetchPos)
+        popAhead();
+    if (!ahead.empty() && ahead.front()->start > fetchPos)
+        cancelAhead();
+    if (ahead.empty()) {
+        nextAheadStart = fetchPos;
+        if (nextAheadLength == 0)
+            nextAheadLength = readAhead.enabled ? readAhead.initialChunk : CHUNK_SIZE;
+    }
+    scheduleAhead();
+    if (ahead.empty()) {
+        _eof = true;
+        return false;
+    }
+
+    RangeRequest& front = *ahead.front();
+    if (loop) {
+        if (!front.done)
+            finishRange(front, front.completion.get());
+    } else {
+        while (!front.done)
+            pumpAhead(true);
+    }
+
+    if (abortDownload || (front.result != CURLE_OK && front.result != CURLE_WRITE_ERROR)) {
+        cancelAhead();
+        return false;
+    }
+
+    size_t offset = static_cast<size_t>(fetchPos - front.start);
+    if (offset >= front.data.size()) {
+        // Short or rejected range: past the end of the file
+        _eof = true;
+        cancelAhead();
+        return false;
+    }
+
+    size_t n = std::min(front.data.size() - offset, downloadedData.size() - bufferSize);
+    memcpy(&downloadedData[bufferSize], front.data.data() + offset, n);
+    bufferSize += n;
+    if (offset + n == front.data.size()) {
+        popAhead();
+        // The pipeline is topped up only once the parser has asked for bytes past
+        // the first range; until then a header that fits in it costs one request
+        if (++rangesConsumed > 1) {
+            scheduleAhead();
+            if (multi)
+                pumpAhead(false);
+        }
+    }
+    return true;
+}
+
+void UrlDataSource::scheduleAhead() {
+    // A single range until the header proves larger than one, so small headers cost one request
+    size_t maxRequests = rangesConsumed == 0 || !readAhead.enabled
+                       ? 1 : std::max<size_t>(1, readAhead.maxRequests);
+    while (ahead.size() < maxRequests &&
+           (ahead.empty() || bytesAhead + nextAheadLength <= readAhead.maxBytesInFlight)) {
+        if (totalBytes > 0 && nextAheadStart >= totalBytes)
+            break;
+
+        size_t length = nextAheadLength;
+        if (totalBytes > 0)
+            length = static_cast<size_t>(std::min<uint64_t>(length, totalBytes - nextAheadStart));
+
+        auto req = std::make_unique<RangeRequest>();
+        req->start = nextAheadStart;
+        req->length = length;
+        req->data.reserve(length);
+        req->abort_download = &abortDownload;
+
+        if (!idleHandles.empty()) {
+            req->easy = idleHandles.back();
+            idleHandles.pop_back();
+        } else {
+            req->easy = NetworkContext::instance().acquire(url);
+            curl_easy_setopt(req->easy, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(req->easy, CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(req->easy, CURLOPT_WRITEFUNCTION, RangeWriteCallback);
+            curl_easy_setopt(req->easy, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        }
+        curl_easy_setopt(req->easy, CURLOPT_WRITEDATA, req.get());
+        curl_easy_setopt(req->easy, CURLOPT_HEADERDATA, &req->headers);
+        curl_easy_setopt(req->easy, CURLOPT_PRIVATE, req.get());
+        std::string range = std::to_string(req->start) + "-" +
+                            std::to_string(req->start + length - 1);
+        curl_easy_setopt(req->easy, CURLOPT_RANGE, range.c_str());
+        if (loop)
+            req->completion = loop->start(req->easy);
+        else
+            curl_multi_add_handle(multi, req->easy);
+        if (stats) {
+            ++stats->requests;
+            stats->bytesRequested += length;
+        }
+
+        bytesAhead += length;
+        nextAheadStart += length;
+        if (readAhead.enabled)
+            nextAheadLength = std::min(nextAheadLength * 2, readAhead.maxChunk);
+        ahead.push_back(std::move(req));
+    }
+}
+
+void UrlDataSource::pumpAhead(bool wait) {
+    int running = 0;
+    curl_multi_perform(multi, &running);
+
+    int queued = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        RangeRequest* req = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&req));
+        if (req)
+            finishRange(*req, msg->data.result);
+    }
+
+    if (wait && running > 0)
+        curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+}
+
+// Runs on the reading thread once a range has completed, however it was driven
+void UrlDataSource::finishRange(RangeRequest& req, CURLcode result) {
+    req.done = true;
+    req.result = result;
+    adoptHeaders(req.headers);
+
+    // Only 206, or a 200 that starts at byte 0, carries the bytes we asked for
+    long status = 0;
+    curl_easy_getinfo(req.easy, CURLINFO_RESPONSE_CODE, &status);
+    if (status != 206 && !(status == 200 && req.start == 0))
+        req.data.clear();
+    if (stats) {
+        stats->bytesReceived += req.data.size();
+        recordTransfer(req.easy);
+    }
+    if (status == 200 && totalBytes == 0) {
+        curl_off_t length = -1;
+        if (curl_easy_getinfo(req.easy, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK &&
+            length > 0)
+            totalBytes = static_cast<uint64_t>(length);
+    }
+}
+
+// Request time and, for the first request, time to first byte as curl measured them
+void UrlDataSource::recordTransfer(CURL* easy) {
+    curl_off_t total = 0;
+    curl_off_t firstByte = 0;
+    if (curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total) == CURLE_OK)
+        stats->requestMs.push_back(static_cast<double>(total) / 1e3);
+    if (stats->timeToFirstByteMs < 0 &&
+        curl_easy_getinfo(easy, CURLINFO_STARTTRANSFER_TIME_T, &firstByte) == CURLE_OK && firstByte > 0)
+        stats->timeToFirstByteMs = static_cast<double>(firstByte) / 1e3;
+}
+
+void UrlDataSource::adoptHeaders(const ResponseHeaders& headers) {
+    if (headers.totalBytes > 0)
+        totalBytes = headers.totalBytes;
+    if (!headers.etag.empty())
+        etagValue = headers.etag;
+    if (!headers.lastModified.empty())
+        lastModifiedValue = headers.lastModified;
+}
+
+void UrlDataSource::popAhead() {
+    std::unique_ptr<RangeRequest> req = std::move(ahead.front());
+    ahead.pop_front();
+    bytesAhead -= req->length;
+    if (!loop)
+        curl_multi_remove_handle(multi, req->easy);
+    else if (!req->done)
+        loop->stop(req->easy);
+    idleHandles.push_back(req->easy);
+}
+
+void UrlDataSource::cancelAhead() {
+    while (!ahead.empty())
+        popAhead();
+}
+
+size_t UrlDataSource::RangeWriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    RangeRequest* req = static_cast<RangeRequest*>(userdata);
+    if (*(req->abort_download))
+        return 0;
+    size_t bytes = size * nmemb;
+    size_t available = req->length - req->data.size();
+    if (bytes > available)
+        bytes = available;     // A server ignoring Range: stop once our slice is filled
+    req->data.insert(req->data.end(), ptr, ptr + bytes);
+    return bytes;
+}
+
+// Matches "<name>: <value>" case-insensitively and returns the trimmed value
+bool httpHeaderValue(std::string_view line, std::string_view name, std::string_view& value) {
+    if (line.size() <= name.size() || line[name.size()] != ':')
+        return false;
+    for (size_t i = 0; i < name.size(); ++i)
+        if (std::tolower(static_cast<unsigned char>(line[i])) != name[i])
+            return false;
+    value = line.substr(name.size() + 1);
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    while (!value.empty() && (value.back() == '\r' || value.back() == '\n' || value.back() == ' '))
+        value.remove_suffix(1);
+    return true;
+}
+
+// Records the total size from "Content-Range: bytes <first>-<last>/<total>"
+// and the validators a header cache needs (ETag, Last-Modified)
+size_t UrlDataSource::HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    ResponseHeaders* headers = static_cast<ResponseHeaders*>(userdata);
+    size_t bytes = size * nitems;
+    std::string_view line(buffer, bytes);
+    std::string_view value;
+
+    if (httpHeaderValue(line, "content-range", value)) {
+        size_t slash = value.rfind('/');
+        if (slash != std::string_view::npos) {
+            uint64_t total = 0;
+            bool digits = false;
+            for (size_t i = slash + 1; i < value.size() && value[i] >= '0' && value[i] <= '9'; ++i) {
+                total = total * 10 + static_cast<uint64_t>(value[i] - '0');
+                digits = true;
+            }
+            if (digits && total > 0)
+                headers->totalBytes = total;
+        }
+    } else if (httpHeaderValue(line, "etag", value)) {
+        headers->etag.assign(value);
+    } else if (httpHeaderValue(line, "last-modified", value)) {
+        headers->lastModified.assign(value);
+    }
+    return bytes;
+}
+
 int UrlDataSource::ProgressCallback(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
     bool* abort_flag = static_cast<bool*>(clientp);
     return (*abort_flag) ? 1 : 0;
 }
 #endif
 
+// ----------------------- GGUFCursor -----------------------
+GGUFCursor::GGUFCursor(DataSource* source, size_t windowSize) : source(source) {
+    std::string_view mapped = source->contents();
+    if (!mapped.empty()) {
+        borrowed = true;
+        begin = mapped.data();
+        cur = begin + std::min(source->tell(), mapped.size());
+        end = begin + mapped.size();
+        exhausted = true;
+        return;
+    }
+    window.resize(windowSize);
+    windowStart = source->tell();
+    begin = cur = end = window.data();
+}
+
+// Makes at least `need` bytes available at `cur`; grows the window only for
+// oversized strings, so steady-state parsing never allocates.
+bool GGUFCursor::fill(size_t need) {
+    if (borrowed) {
+        wanted = std::max<uint64_t>(wanted, tell() + need);
+        return false;
+    }
+
+    size_t have = static_cast<size_t>(end - cur);
+    size_t start = tell();
+    if (need > window.size()) {
+        std::vector<char> grown(std::max(need, window.size() * 2));
+        memcpy(grown.data(), cur, have);
+        window.swap(grown);
+    } else if (have > 0) {
+        memmove(window.data(), cur, have);
+    }
+    windowStart = start;
+    begin = cur = window.data();
+    end = begin + have;
+
+    while (have < need) {
+        size_t n = source->readSome(window.data() + have, window.size() - have);
+        if (n == 0) {
+            exhausted = true;
+            break;
+        }
+        have += n;
+        end = begin + have;
+    }
+    if (have < need)
+        wanted = std::max<uint64_t>(wanted, start + need);
+    return have >= need;
+}
+
+bool GGUFCursor::append(uint64_t size, std::string& out) {
+    while (size > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(size, WINDOW_SIZE / 2));
+        std::string_view chunk;
+        if (!readView(n, chunk))
+            return false;
+        out.append(chunk);
+        size -= n;
+    }
+    return true;
+}
+
+bool GGUFCursor::skipSlow(uint64_t size) {
+    if (borrowed) {
+        wanted = std::max<uint64_t>(wanted, tell() + size);
+        cur = end;
+        return false;
+    }
+    size_t target = tell() + static_cast<size_t>(size);
+    windowStart = target;
+    begin = cur = end = window.data();
+    exhausted = false;
+    return source->seek(target);
+}
+
+// ----------------------- ggml type traits -----------------------
+const GGMLTypeTraits* ggmlTypeTraits(uint32_t type) {
+    // Indexed by ggml type id; entries with blockSize 0 are removed/unused ids
+    static const GGMLTypeTraits traits[static_cast<uint32_t>(GGMLType::COUNT)] = {
+        {"F32",       1,   4},  // 0
+        {"F16",       1,   2},  // 1
+        {"Q4_0",     32,  18},  // 2
+        {"Q4_1",     32,  20},  // 3
+        {nullptr,     0,   0},  // 4  (Q4_2, removed)
+        {nullptr,     0,   0},  // 5  (Q4_3, removed)
+        {"Q5_0",     32,  22},  // 6
+        {"Q5_1",     32,  24},  // 7
+        {"Q8_0",     32,  34},  // 8
+        {"Q8_1",     32,  36},  // 9
+        {"Q2_K",    256,  84},  // 10
+        {"Q3_K",    256, 110},  // 11
+        {"Q4_K",    256, 144},  // 12
+        {"Q5_K",    256, 176},  // 13
+        {"Q6_K",    256, 210},  // 14
+        {"Q8_K",    256, 292},  // 15
+        {"IQ2_XXS", 256,  66},  // 16
+        {"IQ2_XS",  256,  74},  // 17
+        {"IQ3_XXS", 256,  98},  // 18
+        {"IQ1_S",   256,  50},  // 19
+        {"IQ4_NL",   32,  18},  // 20
+        {"IQ3_S",   256, 110},  // 21
+        {"IQ2_S",   256,  82},  // 22
+        {"IQ4_XS",  256, 136},  // 23
+        {"I8",        1,   1},  // 24
+        {"I16",       1,   2},  // 25
+        {"I32",       1,   4},  // 26
+        {"I64",       1,   8},  // 27
+        {"F64",       1,   8},  // 28
+        {"IQ1_M",   256,  56},  // 29
+        {"BF16",      1,   2},  // 30
+        {"Q4_0_4_4", 32,  18},  // 31 (repacked Q4_0, removed but still found in old files)
+        {"Q4_0_4_8", 32,  18},  // 32
+        {"Q4_0_8_8", 32,  18},  // 33
+        {"TQ1_0",   256,  54},  // 34
+        {"TQ2_0",   256,  66},  // 35
+        {nullptr,     0,   0},  // 36 (IQ4_NL_4_4, removed)
+        {nullptr,     0,   0},  // 37 (IQ4_NL_4_8, removed)
+        {nullptr,     0,   0},  // 38 (IQ4_NL_8_8, removed)
+        {"MXFP4",    32,  17},  // 39
+    };
+    if (type >= static_cast<uint32_t>(GGMLType::COUNT) || traits[type].blockSize == 0)
+        return nullptr;
+    return &traits[type];
+}
+
 // ----------------------- GGUFMetadataReader -----------------------
 GGUFMetadataReader::GGUFMetadataReader() {
 #ifndef __EMSCRIPTEN__
-    curl_global_init(CURL_GLOBAL_ALL);
+    // libcurl is initialized once per process, never per reader
+    NetworkContext::instance();
 #endif
 }
 
-GGUFMetadataReader::~GGUFMetadataReader() {
+bool GGUFMetadataReader::isUrl(const std::string& path) {
+    return path.rfind("http://", 0) == 0 || path.rfind("https://", 0) == 0;
+}
+
 #ifndef __EMSCRIPTEN__
-    curl_global_cleanup();
+std::unique_ptr<UrlDataSource> GGUFMetadataReader::openUrl(const std::string& url) {
+    if (multiLoop)
+        return std::make_unique<UrlDataSource>(url, readAhead, multiLoop);
+    return std::make_unique<UrlDataSource>(url, readAhead);
+}
+#endif
+
+std::unique_ptr<DataSource> GGUFMetadataReader::openSource(const std::string& path, bool verbose,
+                                                           ProbeStats* stats) {
+    auto label = [stats](const char* source) {
+        if (stats)
+            stats->source = source;
+    };
+    if (isUrl(path)) {
+#ifndef __EMSCRIPTEN__
+        if (headerCache) {
+            if (auto cached = headerCache->lookup(path)) {
+                if (verbose) std::cout << "Reading cached header for URL: " << path << std::endl;
+                label("header-cache");
+                return cached;
+            }
+            if (verbose) std::cout << "Reading from URL (recording header): " << path << std::endl;
+            label("url");
+            return std::make_unique<RecordingUrlDataSource>(openUrl(path));
+        }
+        if (verbose) std::cout << "Reading from URL: " << path << std::endl;
+        label("url");
+        return openUrl(path);
+#elif defined(GGUF_WASM_ASYNC_FETCH)
+        if (verbose) std::cout << "Reading from URL: " << path << std::endl;
+        label("url");
+        return std::make_unique<UrlDataSource>(path, readAhead);
+#else
+        throw std::runtime_error("URL reads need a GGUF_WASM_ASYNC_FETCH build; "
+                                 "fetch the header into a GGUFPushParser instead: " + path);
+#endif
+    }
+    if (verbose) std::cout << "Reading from file: " << path << std::endl;
+#ifdef GGUF_HAVE_MMAP
+    label("mmap");
+    return std::make_unique<MmapDataSource>(path);
+#else
+    label("file");
+    return std::make_unique<FileDataSource>(path);
 #endif
 }
 
-bool GGUFMetadataReader::isUrl(const std::string& path) {
-    return path.rfind("http://", 0) == 0 || path.rfind("https://", 0) == 0;
+namespace {
+
+// Attaches `stats` to a source for one parse and records its wall and CPU
+// time and how far the parser got. Detaches on every exit path, so the
+// source never writes to stats it outlives.
+class ProbeRecorder {
+public:
+    ProbeRecorder(DataSource& source, ProbeStats* stats)
+        : source(source), stats(stats), started(std::chrono::steady_clock::now()),
+          cpuStarted(stats ? threadCpuMs() : 0.0) {
+        source.setStats(stats);
+    }
+    ~ProbeRecorder() { source.setStats(nullptr); }
+
+    void finish(const GGUFCursor& cursor) {
+        if (!stats)
+            return;
+        if (stats->source.empty())
+            stats->source = dynamic_cast<UrlDataSource*>(&source) ? "url" : "file";
+        stats->bytesUsed = cursor.tell();
+        stats->parseCpuMs = threadCpuMs() - cpuStarted;
+        stats->wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        stats->files = 1;
+    }
+
+private:
+    DataSource& source;
+    ProbeStats* stats;
+    std::chrono::steady_clock::time_point started;
+    double cpuStarted;
+};
+
+// Tensor sizes and offsets come straight from the file: reject a header
+// whose arithmetic would wrap instead of reporting a wrapped size
+uint64_t checkedMul(uint64_t a, uint64_t b, const std::string& tensor) {
+    if (a != 0 && b > std::numeric_limits<uint64_t>::max() / a)
+        throw std::runtime_error("Size of tensor " + tensor + " overflows 64 bits");
+    return a * b;
+}
+
+uint64_t checkedAdd(uint64_t a, uint64_t b, const std::string& tensor) {
+    if (b > std::numeric_limits<uint64_t>::max() - a)
+        throw std::runtime_error("Extent of tensor " + tensor + " overflows 64 bits");
+    return a + b;
 }
 
-std::optional<GGUFModelParams> GGUFMetadataReader::readModelParams(const std::string& path, bool verbose) {
-    std::unique_ptr<DataSource> source;
+} // namespace
+
+std::optional<GGUFModelParams> GGUFMetadataReader::readModelParams(const std::string& path, bool verbose,
+                                                                   ProbeStats* stats) {
     try {
-        if (isUrl(path)) {
-            if (verbose) std::cout << "Reading from URL: " << path << std::endl;
-            source = std::make_unique<UrlDataSource>(path);
-        } else {
-            if (verbose) std::cout << "Reading from file: " << path << std::endl;
-            source = std::make_unique<FileDataSource>(path);
-        }
+        auto source = openSource(path, verbose, stats);
+        return readModelParams(*source, verbose, stats);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error reading GGUF file/URL: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
 
-        uint32_t magic;
-        if (!source->read(reinterpret_cast<char*>(&magic), sizeof(magic)))
-            throw std::runtime_error("Failed to read magic number");
-        if (magic != 0x46554747) {
-            std::cerr << "Invalid GGUF file format. Magic number: "
-                      << std::hex << magic << std::dec << std::endl;
+std::optional<GGUFModelParams> GGUFMetadataReader::readModelParams(DataSource& source, bool verbose,
+                                                                   ProbeStats* stats) {
+    try {
+        ProbeRecorder recorder(source, stats);
+        GGUFCursor cursor(&source);
+        GGUFModelInfo info;
+        bool parsed = parseHeader(cursor, info, false, true, verbose, stats);
+        recorder.finish(cursor);
+        if (!parsed)
             return std::nullopt;
-        }
+        return info.params;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error reading GGUF file/URL: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
 
-        uint32_t version;
-        if (!source->read(reinterpret_cast<char*>(&version), sizeof(version)))
-            throw std::runtime_error("Failed to read version");
-        if (version > 3) {
-            std::cerr << "Unsupported GGUF version: " << version << std::endl;
+std::optional<GGUFModelInfo> GGUFMetadataReader::readModelInfo(const std::string& path, bool verbose,
+                                                               ProbeStats* stats) {
+    return readModelInfo(path, true, verbose, stats);
+}
+
+std::optional<GGUFModelInfo> GGUFMetadataReader::readShardInfo(const std::string& path, bool verbose,
+                                                               ProbeStats* stats) {
+    return readModelInfo(path, false, verbose, stats);
+}
+
+std::optional<GGUFModelInfo> GGUFMetadataReader::readModelInfo(const std::string& path, bool requireParams,
+                                                               bool verbose, ProbeStats* stats) {
+    try {
+        auto source = openSource(path, verbose, stats);
+        ProbeRecorder recorder(*source, stats);
+
+        GGUFModelInfo info;
+        GGUFCursor cursor(source.get());
+        bool parsed = parseHeader(cursor, info, true, requireParams, verbose, stats);
+        recorder.finish(cursor);
+        if (!parsed)
             return std::nullopt;
-        }
-        if (verbose) std::cout << "GGUF version: " << version << std::endl;
+        info.file_size = source->totalSize();
 
-        uint64_t tensorCount = 0;
-        if (version >= 1) {
-            if (!source->read(reinterpret_cast<char*>(&tensorCount), sizeof(tensorCount)))
-                throw std::runtime_error("Failed to read tensor count");
-            if (verbose) std::cout << "Tensor count: " << tensorCount << std::endl;
-        }
+#ifndef __EMSCRIPTEN__
+        if (auto* recording = dynamic_cast<RecordingUrlDataSource*>(source.get()))
+            headerCache->store(*recording, info.tensorTable.data_offset);
+#endif
+        return info;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error reading GGUF file/URL: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+std::optional<GGUFMetadata> GGUFMetadataReader::readMetadata(const std::string& path, bool verbose) {
+    return readMetadata(path, nullptr, verbose);
+}
 
+std::optional<GGUFMetadata> GGUFMetadataReader::readMetadata(const std::string& path, const GGUFKeySchema& schema,
+                                                             bool verbose) {
+    return readMetadata(path, &schema, verbose);
+}
+
+std::optional<GGUFMetadata> GGUFMetadataReader::readMetadata(const std::string& path, const GGUFKeySchema* schema,
+                                                             bool verbose) {
+    try {
+        auto source = openSource(path, verbose);
+        GGUFCursor cursor(source.get());
+
+        GGUFMetadata metadata;
         uint64_t metadataCount;
-        if (!source->read(reinterpret_cast<char*>(&metadataCount), sizeof(metadataCount)))
-            throw std::runtime_error("Failed to read metadata count");
-        if (verbose) std::cout << "Metadata count: " << metadataCount << std::endl;
-
-        const std::vector<std::string> suffixes = {
-            ".attention.head_count",
-            ".attention.head_count_kv",
-            ".block_count",
-            ".embedding_length"
-        };
-
-        GGUFModelParams params;
-        std::unordered_map<std::string, bool> foundParams;
-        std::vector<std::string> allKeys;
-
-        for (uint64_t i = 0; i < metadataCount && !source->eof(); ++i) {
-            std::string key;
-            try {
-                key = readString(source.get());
-                allKeys.push_back(key);
-            } catch (const std::exception& e) {
-                throw std::runtime_error(std::string("Failed to read key: ") + e.what());
-            }
+        if (!readPreamble(cursor, metadata.fileVersion, metadata.tensors, metadataCount, verbose))
+            return std::nullopt;
+        scanMetadata(cursor, metadataCount, schema, true, metadata, verbose);
+        return metadata;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error reading GGUF file/URL: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
 
-            uint32_t typeVal;
-            if (!source->read(reinterpret_cast<char*>(&typeVal), sizeof(typeVal)))
-                throw std::runtime_error("Failed to read metadata type for key: " + key);
-            if (typeVal >= static_cast<uint32_t>(GGUFType::MAX_TYPE))
-                throw std::runtime_error("Invalid metadata type: " + std::to_string(typeVal) + " for key: " + key);
-            GGUFType type = static_cast<GGUFType>(typeVal);
+// Magic, version and counts; false (with a message) for files that are not
+// GGUF or too new, exceptions for truncated input
+bool GGUFMetadataReader::readPreamble(GGUFCursor& cursor, uint32_t& version, uint64_t& tensorCount,
+                                      uint64_t& metadataCount, bool verbose) {
+    uint32_t magic;
+    if (!cursor.read(magic))
+        throw std::runtime_error("Failed to read magic number");
+    if (magic != 0x46554747) {
+        std::cerr << "Invalid GGUF file format. Magic number: "
+                  << std::hex << magic << std::dec << std::endl;
+        return false;
+    }
 
-            if (verbose)
-                std::cout << "Key: " << key << ", Type: " << static_cast<int>(type) << std::endl;
-
-            bool keyMatched = false;
-            std::string matchedSuffix;
-            for (const auto& suffix : suffixes) {
-                if (endsWith(key, suffix)) {
-                    keyMatched = true;
-                    matchedSuffix = suffix;
-                    break;
-                }
-            }
+    if (!cursor.read(version))
+        throw std::runtime_error("Failed to read version");
+    if (version > 3) {
+        std::cerr << "Unsupported GGUF version: " << version << std::endl;
+        return false;
+    }
+    if (verbose) std::cout << "GGUF version: " << version << std::endl;
 
-            if (keyMatched) {
-                if (matchedSuffix == ".attention.head_count" && (type == GGUFType::UINT32 || type == GGUFType::INT32)) {
-                    uint32_t value;
-                    if (!source->read(reinterpret_cast<char*>(&value), sizeof(value)))
-                        throw std::runtime_error("Failed to read attention_heads value");
-                    params.attention_heads = value;
-                    foundParams["attention_heads"] = true;
-                    if (verbose)
-                        std::cout << "  Found attention_heads: " << value << " (from key: " << key << ")" << std::endl;
-                }
-                else if (matchedSuffix == ".attention.head_count_kv" && (type == GGUFType::UINT32 || type == GGUFType::INT32)) {
-                    uint32_t value;
-                    if (!source->read(reinterpret_cast<char*>(&value), sizeof(value)))
-                        throw std::runtime_error("Failed to read kv_heads value");
-                    params.kv_heads = value;
-                    foundParams["kv_heads"] = true;
-                    if (verbose)
-                        std::cout << "  Found kv_heads: " << value << " (from key: " << key << ")" << std::endl;
-                }
-                else if (matchedSuffix == ".block_count" && (type == GGUFType::UINT32 || type == GGUFType::INT32)) {
-                    uint32_t value;
-                    if (!source->read(reinterpret_cast<char*>(&value), sizeof(value)))
-                        throw std::runtime_error("Failed to read hidden_layers value");
-                    params.hidden_layers = value;
-                    foundParams["hidden_layers"] = true;
-                    if (verbose)
-                        std::cout << "  Found hidden_layers: " << value << " (from key: " << key << ")" << std::endl;
-                }
-                else if (matchedSuffix == ".embedding_length") {
-                    if (type == GGUFType::UINT64 || type == GGUFType::INT64) {
-                        uint64_t value;
-                        if (!source->read(reinterpret_cast<char*>(&value), sizeof(value)))
-                            throw std::runtime_error("Failed to read hidden_size value (64-bit)");
-                        params.hidden_size = value;
-                        foundParams["hidden_size"] = true;
-                        if (verbose)
-                            std::cout << "  Found hidden_size: " << value << " (from key: " << key << ")" << std::endl;
-                    }
-                    else if (type == GGUFType::UINT32 || type == GGUFType::INT32) {
-                        uint32_t value;
-                        if (!source->read(reinterpret_cast<char*>(&value), sizeof(value)))
-                            throw std::runtime_error("Failed to read hidden_size value (32-bit)");
-                        params.hidden_size = value;
-                        foundParams["hidden_size"] = true;
-                        if (verbose)
-                            std::cout << "  Found hidden_size: " << value << " (from key: " << key << ")" << std::endl;
-                    }
-                    else {
-                        skipValue(source.get(), type);
-                    }
-                }
-                else {
-                    skipValue(source.get(), type);
-                }
-            }
-            else {
-                skipValue(source.get(), type);
-            }
+    tensorCount = 0;
+    if (version >= 1) {
+        if (!cursor.read(tensorCount))
+            throw std::runtime_error("Failed to read tensor count");
+        if (verbose) std::cout << "Tensor count: " << tensorCount << std::endl;
+    }
+
+    if (!cursor.read(metadataCount))
+        throw std::runtime_error("Failed to read metadata count");
+    if (verbose) std::cout << "Metadata count: " << metadataCount << std::endl;
+    return true;
+}
+
+bool GGUFMetadataReader::parseHeader(GGUFCursor& cursor, GGUFModelInfo& info, bool withTensors,
+                                     bool requireParams, bool verbose, ProbeStats* stats) {
+    uint32_t version;
+    uint64_t tensorCount;
+    uint64_t metadataCount;
+    if (!readPreamble(cursor, version, tensorCount, metadataCount, verbose))
+        return false;
+
+    // No early stop: GGUF does not order its keys, so head_count_kv and the
+    // other Optional attention keys can follow the last Required one anywhere
+    const GGUFKeySchema& schema = GGUFMetadata::modelParamsSchema();
+    GGUFMetadata metadata;
+    scanMetadata(cursor, metadataCount, &schema, false, metadata, verbose, stats);
+
+    auto params = metadata.modelParams();
+    if (!params && requireParams) {
+        std::cerr << "Failed to find all required model parameters:" << std::endl;
+        for (size_t id = 0; id < schema.size(); ++id)
+            if (schema.need(id) == GGUFKeySchema::Need::Required && !metadata.matchedKey(id))
+                std::cerr << "  Missing: " << schema.pattern(id) << std::endl;
+        return false;
+    }
+    if (params) {
+        if (verbose)
+            std::cout << "hidden_size: " << params->hidden_size
+                      << ", attention_heads: " << params->attention_heads
+                      << ", hidden_layers: " << params->hidden_layers
+                      << ", kv_heads: " << params->kv_heads << std::endl;
+        info.params = std::move(*params);
+    }
+    if (!withTensors)
+        return true;
+
+    info.split_no = static_cast<uint32_t>(metadata.getUInt("split.no").value_or(0));
+    info.split_count = static_cast<uint32_t>(metadata.getUInt("split.count").value_or(0));
+    if (info.split_count > 0 && info.split_no >= info.split_count)
+        throw std::runtime_error("Invalid split.no " + std::to_string(info.split_no) +
+                                 " of " + std::to_string(info.split_count));
+
+    GGUFTensorTable& tensorTable = info.tensorTable;
+    if (auto alignment = metadata.getUInt("general.alignment")) {
+        if (*alignment == 0 || *alignment > UINT32_MAX || (*alignment & (*alignment - 1)) != 0)
+            throw std::runtime_error("Invalid general.alignment: " + std::to_string(*alignment));
+        tensorTable.alignment = static_cast<uint32_t>(*alignment);
+    }
+    readTensorTable(cursor, tensorCount, tensorTable, verbose);
 
-            if (foundParams["attention_heads"] &&
-                foundParams["hidden_layers"] &&
-                foundParams["hidden_size"] &&
-                (foundParams["kv_heads"] || foundParams["attention_heads"])) {
-                if (isUrl(path)) {
-                    // In WASM we can't cancel an in-flight fetch, but we simply stop requesting more.
-                    if (verbose)
-                        std::cout << "All required metadata found (early stop)." << std::endl;
-                }
+    // Most converters do not write vocab_size; the embedding matrix has one row per token
+    if (info.params.vocab_size == 0) {
+        for (const auto& tensor : tensorTable.tensors) {
+            if (tensor.name == "token_embd.weight" && tensor.n_dims >= 2) {
+                info.params.vocab_size = static_cast<uint32_t>(tensor.dims[1]);
                 break;
             }
         }
+    }
+    return true;
+}
 
-        if (!foundParams["kv_heads"] && foundParams["attention_heads"]) {
-            params.kv_heads = params.attention_heads;
-            foundParams["kv_heads"] = true;
-            if (verbose)
-                std::cout << "  Using attention_heads as kv_heads: " << params.kv_heads << std::endl;
+// Indexes the metadata keys `schema` selects (all of them without a schema).
+// With `stopEarly`, returns as soon as every Required pattern has matched,
+// leaving the cursor at the next key.
+void GGUFMetadataReader::scanMetadata(GGUFCursor& cursor, uint64_t metadataCount, const GGUFKeySchema* schema,
+                                      bool stopEarly, GGUFMetadata& metadata, bool verbose, ProbeStats* stats) {
+    if (metadataCount > 1000000)
+        throw std::runtime_error("Metadata count too large: " + std::to_string(metadataCount));
+
+    size_t remaining = schema ? schema->requiredCount() : 0;
+    stopEarly = stopEarly && remaining > 0;
+    if (schema)
+        metadata.patternMatches.assign(schema->size(), GGUFMetadata::NO_MATCH);
+    else
+        metadata.entries.reserve(static_cast<size_t>(metadataCount));
+
+    if (stats) {
+        stats->keyCount = metadataCount;
+        stats->keysScanned = 0;
+        stats->stoppedEarly = false;
+        stats->stopKey.clear();
+    }
+
+    std::string verboseKey;
+    for (uint64_t i = 0; i < metadataCount; ++i) {
+        if (stats)
+            stats->keysScanned = i + 1;
+        // The key is a view into the cursor window: classify and copy it before reading on
+        std::string_view key = readKey(cursor);
+        if (verbose)
+            verboseKey.assign(key);
+
+        bool wanted = !schema;
+        uint32_t index = static_cast<uint32_t>(metadata.entries.size());
+        if (schema) {
+            schema->match(key, [&](size_t id) {
+                wanted = true;
+                if (metadata.patternMatches[id] != GGUFMetadata::NO_MATCH)
+                    return;
+                metadata.patternMatches[id] = index;
+                if (schema->need(id) == GGUFKeySchema::Need::Required)
+                    --remaining;
+            });
         }
 
-        bool allFound = foundParams["attention_heads"] &&
-                        foundParams["hidden_layers"] &&
-                        foundParams["hidden_size"];
+        GGUFMetadata::Entry entry{};
+        if (wanted) {
+            entry.keyOffset = static_cast<uint32_t>(metadata.arena.size());
+            entry.keyLength = static_cast<uint32_t>(key.size());
+            metadata.arena.append(key);
+        }
 
-        if (!allFound) {
-            std::cerr << "Failed to find all required model parameters:" << std::endl;
-            if (!foundParams["attention_heads"]) std::cerr << "  Missing: attention_heads (suffix: .attention.head_count)" << std::endl;
-            if (!foundParams["hidden_layers"]) std::cerr << "  Missing: hidden_layers (suffix: .block_count)" << std::endl;
-            if (!foundParams["hidden_size"]) std::cerr << "  Missing: hidden_size (suffix: .embedding_length)" << std::endl;
-            return std::nullopt;
+        uint32_t typeVal;
+        if (!cursor.read(typeVal))
+            throw std::runtime_error("Failed to read metadata type" +
+                                     (wanted ? " for key: " + std::string(metadata.keyOf(entry)) : std::string()));
+        if (typeVal >= static_cast<uint32_t>(GGUFType::MAX_TYPE))
+            throw std::runtime_error("Invalid metadata type: " + std::to_string(typeVal) +
+                                     (wanted ? " for key: " + std::string(metadata.keyOf(entry)) : std::string()));
+        GGUFType type = static_cast<GGUFType>(typeVal);
+
+        if (verbose)
+            std::cout << "Key: " << verboseKey << ", Type: " << typeVal << (wanted ? "" : " (skipped)") << std::endl;
+
+        if (wanted) {
+            entry.type = type;
+            entry.valueOffset = metadata.arena.size();
+            copyValue(cursor, type, metadata.arena);
+            if (metadata.arena.size() > std::numeric_limits<uint32_t>::max())
+                throw std::runtime_error("Metadata section too large");
+            metadata.entries.push_back(entry);
+        } else {
+            skipValue(cursor, type);
         }
 
-        return params;
+        if (stopEarly && remaining == 0) {
+            if (verbose)
+                std::cout << "All required metadata found (early stop)." << std::endl;
+            if (stats) {
+                stats->stoppedEarly = true;
+                stats->stopKey.assign(metadata.keyOf(entry));
+            }
+            break;
+        }
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error reading GGUF file/URL: " << e.what() << std::endl;
-        return std::nullopt;
+    metadata.buildIndex();
+}
+
+void GGUFMetadataReader::readTensorTable(GGUFCursor& cursor, uint64_t tensorCount,
+                                         GGUFTensorTable& table, bool verbose) {
+    if (tensorCount > 1000000)
+        throw std::runtime_error("Tensor count too large: " + std::to_string(tensorCount));
+
+    const uint64_t align = table.alignment;
+    auto padTo = [align](uint64_t n) { return (n + align - 1) / align * align; };
+
+    table.tensors.clear();
+    table.tensors.reserve(static_cast<size_t>(tensorCount));
+    table.weight_bytes = 0;
+    uint64_t dataEnd = 0;
+
+    for (uint64_t i = 0; i < tensorCount; ++i) {
+        GGUFTensorInfo t;
+        t.name = readString(cursor);
+
+        if (!cursor.read(t.n_dims))
+            throw std::runtime_error("Failed to read n_dims for tensor: " + t.name);
+        if (t.n_dims == 0 || t.n_dims > 4)
+            throw std::runtime_error("Invalid n_dims " + std::to_string(t.n_dims) + " for tensor: " + t.name);
+        for (uint32_t d = 0; d < t.n_dims; ++d)
+            if (!cursor.read(t.dims[d]))
+                throw std::runtime_error("Failed to read dims for tensor: " + t.name);
+
+        if (!cursor.read(t.type))
+            throw std::runtime_error("Failed to read type for tensor: " + t.name);
+        if (!cursor.read(t.offset))
+            throw std::runtime_error("Failed to read offset for tensor: " + t.name);
+
+        const GGMLTypeTraits* traits = ggmlTypeTraits(t.type);
+        if (!traits)
+            throw std::runtime_error("Unknown ggml type " + std::to_string(t.type) + " for tensor: " + t.name);
+        if (t.dims[0] % traits->blockSize != 0)
+            throw std::runtime_error("Row size of tensor " + t.name + " is not a multiple of the " +
+                                     traits->name + " block size");
+
+        uint64_t rows = checkedMul(checkedMul(t.dims[1], t.dims[2], t.name), t.dims[3], t.name);
+        t.size_bytes = checkedMul(checkedMul(t.dims[0] / traits->blockSize, traits->typeSize, t.name),
+                                  rows, t.name);
+
+        if (verbose)
+            std::cout << "Tensor: " << t.name << ", Type: " << traits->name
+                      << ", Bytes: " << t.size_bytes << std::endl;
+
+        table.weight_bytes = checkedAdd(table.weight_bytes, t.size_bytes, t.name);
+        uint64_t padded = checkedAdd(t.size_bytes, align - 1, t.name) / align * align;
+        dataEnd = std::max(dataEnd, checkedAdd(t.offset, padded, t.name));
+        table.tensors.push_back(std::move(t));
     }
+
+    table.data_offset = padTo(cursor.tell());
+    if (dataEnd > std::numeric_limits<uint64_t>::max() - table.data_offset)
+        throw std::runtime_error("Tensor data extends past 64-bit offsets");
+    table.file_size = table.data_offset + dataEnd;
+
+    if (verbose)
+        std::cout << "Tensor data offset: " << table.data_offset
+                  << ", weight bytes: " << table.weight_bytes << std::endl;
 }
 
-bool GGUFMetadataReader::endsWith(const std::string& str, const std::string& suffix) {
-    return str.size() >= suffix.size() &&
-        str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+std::string GGUFMetadataReader::readString(GGUFCursor& cursor) {
+    std::string_view view = readKey(cursor);
+    return std::string(view);
 }
 
-std::string GGUFMetadataReader::readString(DataSource* source) {
+// Borrowed view into the cursor window; valid until the next cursor call
+std::string_view GGUFMetadataReader::readKey(GGUFCursor& cursor) {
     uint64_t length;
-    if (!source->read(reinterpret_cast<char*>(&length), sizeof(length)))
+    if (!cursor.read(length))
         throw std::runtime_error("Failed to read string length");
     if (length > 1024 * 1024)
         throw std::runtime_error("String too long: " + std::to_string(length));
-    std::string str(length, '\0');
-    if (length > 0)
-        if (!source->read(&str[0], length))
-            throw std::runtime_error("Failed to read string data");
+    std::string_view str;
+    if (!cursor.readView(static_cast<size_t>(length), str))
+        throw std::runtime_error("Failed to read string data");
     return str;
 }
 
-void GGUFMetadataReader::skipArray(DataSource* source, GGUFType elemType) {
+size_t GGUFMetadataReader::fixedTypeSize(GGUFType type) {
+    using T = GGUFType;
+    switch (type) {
+    case T::UINT8:
+    case T::INT8:
+    case T::BOOL:
+        return 1;
+    case T::UINT16:
+    case T::INT16:
+        return 2;
+    case T::UINT32:
+    case T::INT32:
+    case T::FLOAT32:
+        return 4;
+    case T::UINT64:
+    case T::INT64:
+    case T::FLOAT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+void GGUFMetadataReader::skipArray(GGUFCursor& cursor, GGUFType elemType) {
     uint64_t count;
-    if (!source->read(reinterpret_cast<char*>(&count), sizeof(count)))
+    if (!cursor.read(count))
         throw std::runtime_error("Failed to read array count");
     if (count > 1000000)
         throw std::runtime_error("Array count too large: " + std::to_string(count));
+
+    // Fixed-size elements: one skip for the whole array
+    if (size_t elemSize = fixedTypeSize(elemType)) {
+        if (!cursor.skip(count * elemSize))
+            throw std::runtime_error("Failed to skip array data");
+        return;
+    }
     for (uint64_t i = 0; i < count; ++i)
-        skipValue(source, elemType);
+        skipValue(cursor, elemType);
 }
 
-void GGUFMetadataReader::skipValue(DataSource* source, GGUFType type) {
+void GGUFMetadataReader::skipValue(GGUFCursor& cursor, GGUFType type) {
+    if (size_t size = fixedTypeSize(type)) {
+        if (!cursor.skip(size))
+            throw std::runtime_error("Failed to skip value");
+        return;
+    }
     switch (type) {
-    case GGUFType::UINT8:
-        source->seek(source->tell() + sizeof(uint8_t));
-        break;
-    case GGUFType::INT8:
-        source->seek(source->tell() + sizeof(int8_t));
-        break;
-    case GGUFType::UINT16:
-        source->seek(source->tell() + sizeof(uint16_t));
-        break;
-    case GGUFType::INT16:
-        source->seek(source->tell() + sizeof(int16_t));
-        break;
-    case GGUFType::UINT32:
-        source->seek(source->tell() + sizeof(uint32_t));
-        break;
-    case GGUFType::INT32:
-        source->seek(source->tell() + sizeof(int32_t));
-        break;
-    case GGUFType::FLOAT32:
-        source->seek(source->tell() + sizeof(float));
-        break;
-    case GGUFType::BOOL:
-        source->seek(source->tell() + sizeof(uint8_t));
-        break;
     case GGUFType::STRING: {
         uint64_t length;
-        if (!source->read(reinterpret_cast<char*>(&length), sizeof(length)))
+        if (!cursor.read(length))
             throw std::runtime_error("Failed to read string length for skipping");
         if (length > 1024 * 1024)
             throw std::runtime_error("String too long: " + std::to_string(length));
-        source->seek(source->tell() + length);
+        if (!cursor.skip(length))
+            throw std::runtime_error("Failed to skip string data");
         break;
     }
     case GGUFType::ARRAY: {
         uint32_t elemTypeVal;
-        if (!source->read(reinterpret_cast<char*>(&elemTypeVal), sizeof(elemTypeVal)))
+        if (!cursor.read(elemTypeVal))
             throw std::runtime_error("Failed to read array element type");
         if (elemTypeVal >= static_cast<uint32_t>(GGUFType::MAX_TYPE))
             throw std::runtime_error("Invalid array element type: " + std::to_string(elemTypeVal));
         GGUFType elemType = static_cast<GGUFType>(elemTypeVal);
-        skipArray(source, elemType);
+        skipArray(cursor, elemType);
         break;
     }
-    case GGUFType::UINT64:
-        source->seek(source->tell() + sizeof(uint64_t));
-        break;
-    case GGUFType::INT64:
-        source->seek(source->tell() + sizeof(int64_t));
+    default:
+        throw std::runtime_error("Unknown GGUF type: " + std::to_string(static_cast<int>(type)));
+    }
+}
+
+// Like skipValue, but appends the value's raw encoding to `out`
+void GGUFMetadataReader::copyValue(GGUFCursor& cursor, GGUFType type, std::string& out) {
+    if (size_t size = fixedTypeSize(type)) {
+        if (!cursor.append(size, out))
+            throw std::runtime_error("Failed to read value");
+        return;
+    }
+    switch (type) {
+    case GGUFType::STRING: {
+        std::string_view str = readKey(cursor);
+        uint64_t length = str.size();
+        out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.append(str);
         break;
-    case GGUFType::FLOAT64:
-        source->seek(source->tell() + sizeof(double));
+    }
+    case GGUFType::ARRAY: {
+        uint32_t elemTypeVal;
+        uint64_t count;
+        if (!cursor.read(elemTypeVal))
+            throw std::runtime_error("Failed to read array element type");
+        if (elemTypeVal >= static_cast<uint32_t>(GGUFType::MAX_TYPE))
+            throw std::runtime_error("Invalid array element type: " + std::to_string(elemTypeVal));
+        if (!cursor.read(count))
+            throw std::runtime_error("Failed to read array count");
+        if (count > 1000000)
+            throw std::runtime_error("Array count too large: " + std::to_string(count));
+        out.append(reinterpret_cast<const char*>(&elemTypeVal), sizeof(elemTypeVal));
+        out.append(reinterpret_cast<const char*>(&count), sizeof(count));
+
+        GGUFType elemType = static_cast<GGUFType>(elemTypeVal);
+        if (size_t elemSize = fixedTypeSize(elemType)) {
+            if (!cursor.append(count * elemSize, out))
+                throw std::runtime_error("Failed to read array data");
+            break;
+        }
+        for (uint64_t i = 0; i < count; ++i)
+            copyValue(cursor, elemType, out);
         break;
+    }
     default:
         throw std::runtime_error("Unknown GGUF type: " + std::to_string(static_cast<int>(type)));
     }
@@ -471,6 +1356,7 @@ void GGUFMetadataReader::skipValue(DataSource* source, GGUFType type) {
 
 #ifdef __EMSCRIPTEN__
 // ----------------------- Embind helpers -----------------------
+#ifdef GGUF_WASM_ASYNC_FETCH
 emscripten::val readParamsFromUrl(const std::string& url, bool verbose) {
     GGUFMetadataReader r;
     auto res = r.readModelParams(url, verbose);
@@ -482,6 +1368,7 @@ emscripten::val readParamsFromUrl(const std::string& url, bool verbose) {
     o.set("kv_heads",        emscripten::val(res->kv_heads));
     return o;
 }
+#endif
 
 emscripten::val readParamsFromFile(const std::string& path, bool verbose) {
     GGUFMetadataReader r;
@@ -496,7 +1383,9 @@ emscripten::val readParamsFromFile(const std::string& path, bool verbose) {
 }
 
 EMSCRIPTEN_BINDINGS(gguf_bindings) {
+#ifdef GGUF_WASM_ASYNC_FETCH
     emscripten::function("readParamsFromUrl",  &readParamsFromUrl);
+#endif
     emscripten::function("readParamsFromFile", &readParamsFromFile);
 }
 #endif
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <vector>
 #include <unordered_map>
@@ -13,6 +14,11 @@
 #include <sstream>
 #include <cstring>
 #include <algorithm>
+#include <deque>
+#include <type_traits>
+#include <limits>
+
+#include "probe_stats.h"
 
 #ifdef __EMSCRIPTEN__
   #include <emscripten.h>
@@ -21,6 +27,12 @@
 
 #ifndef __EMSCRIPTEN__
   #include <curl/curl.h>
+  #include <future>
+#endif
+
+// Local files are memory-mapped where POSIX mmap is available
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+  #define GGUF_HAVE_MMAP 1
 #endif
 
 // Structure to hold the extracted model parameters
@@ -29,6 +41,101 @@ struct GGUFModelParams {
     uint32_t attention_heads = 0;   // Mapped from attention.head_count
     uint32_t hidden_layers = 0;     // Mapped from block_count
     uint32_t kv_heads = 0;          // Mapped from attention.head_count_kv or head_count
+
+    // Attention geometry for the KV cache; 0 / empty when the header does not say
+    std::string architecture;       // general.architecture
+    uint32_t key_length = 0;        // attention.key_length (per-head K width)
+    uint32_t value_length = 0;      // attention.value_length (per-head V width)
+    uint32_t sliding_window = 0;    // attention.sliding_window, in tokens
+    std::vector<uint32_t> layer_kv_heads;   // Per-layer KV heads when head_count(_kv) is an array; 0: no KV
+    std::vector<bool> layer_sliding;        // Per layer: attends only within sliding_window
+
+    // Activation sizes for the compute and output buffers
+    uint64_t feed_forward_length = 0;   // feed_forward_length (largest layer when per-layer)
+    uint32_t vocab_size = 0;            // vocab_size, else rows of token_embd.weight (readModelInfo)
+
+    // Mixture of experts; 0 for dense models
+    uint32_t expert_count = 0;          // expert_count: routed experts per MoE block
+    uint32_t expert_used_count = 0;     // expert_used_count: routed experts active per token
+    uint32_t expert_shared_count = 0;   // expert_shared_count: always-active shared experts
+
+    std::optional<uint32_t> file_type;  // general.file_type (llama_ftype), see quantization.h
+};
+
+// ggml tensor types as stored in the GGUF tensor-info table
+enum class GGMLType : uint32_t {
+    F32 = 0,
+    F16 = 1,
+    Q4_0 = 2,
+    Q4_1 = 3,
+    Q5_0 = 6,
+    Q5_1 = 7,
+    Q8_0 = 8,
+    Q8_1 = 9,
+    Q2_K = 10,
+    Q3_K = 11,
+    Q4_K = 12,
+    Q5_K = 13,
+    Q6_K = 14,
+    Q8_K = 15,
+    IQ2_XXS = 16,
+    IQ2_XS = 17,
+    IQ3_XXS = 18,
+    IQ1_S = 19,
+    IQ4_NL = 20,
+    IQ3_S = 21,
+    IQ2_S = 22,
+    IQ4_XS = 23,
+    I8 = 24,
+    I16 = 25,
+    I32 = 26,
+    I64 = 27,
+    F64 = 28,
+    IQ1_M = 29,
+    BF16 = 30,
+    TQ1_0 = 34,
+    TQ2_0 = 35,
+    MXFP4 = 39,
+    COUNT = 40
+};
+
+// Storage layout of a ggml type: `blockSize` elements are packed into `typeSize` bytes
+struct GGMLTypeTraits {
+    const char* name = nullptr;
+    uint32_t blockSize = 0;
+    uint32_t typeSize = 0;
+};
+
+// Returns nullptr for unknown/removed type ids
+const GGMLTypeTraits* ggmlTypeTraits(uint32_t type);
+
+// One entry of the GGUF tensor-info table
+struct GGUFTensorInfo {
+    std::string name;
+    uint32_t n_dims = 0;
+    uint64_t dims[4] = {1, 1, 1, 1};
+    uint32_t type = 0;              // ggml type id (see GGMLType)
+    uint64_t offset = 0;            // Relative to the start of the tensor data section
+    uint64_t size_bytes = 0;        // Exact bytes from the ggml block layout
+};
+
+// Tensor-info table plus the layout of the data section that follows it
+struct GGUFTensorTable {
+    uint32_t alignment = 32;        // general.alignment (GGUF default: 32)
+    uint64_t data_offset = 0;       // Absolute file offset of the tensor data section
+    uint64_t weight_bytes = 0;      // Sum of tensor sizes (no alignment padding)
+    uint64_t file_size = 0;         // data_offset + padded end of the last tensor
+    std::vector<GGUFTensorInfo> tensors;
+};
+
+// Everything one probe learns: model parameters, the tensor table and the
+// total file size reported alongside the header bytes
+struct GGUFModelInfo {
+    GGUFModelParams params;
+    GGUFTensorTable tensorTable;
+    uint64_t file_size = 0;         // From Content-Range / the file itself; 0 if not reported
+    uint32_t split_no = 0;          // split.no of a gguf-split shard (0-based)
+    uint32_t split_count = 0;       // split.count; 0 when the model is a single file
 };
 
 // Abstract base class for data sources
@@ -39,6 +146,22 @@ public:
     virtual bool seek(size_t position) = 0;
     virtual bool eof() const = 0;
     virtual size_t tell() = 0;
+
+    // Reads up to `size` bytes; returns how many were read (0 at end of data or on error)
+    virtual size_t readSome(char* buffer, size_t size) = 0;
+
+    // Whole content for sources backed by contiguous memory, so callers can
+    // parse in place; empty for streaming sources.
+    virtual std::string_view contents() const { return {}; }
+
+    // Total size of the underlying file, 0 while unknown
+    virtual uint64_t totalSize() const { return 0; }
+
+    // Counters of the probe in progress; nullptr (the default) records nothing
+    virtual void setStats(ProbeStats* probeStats) { stats = probeStats; }
+
+protected:
+    ProbeStats* stats = nullptr;
 };
 
 // File-based data source
@@ -51,9 +174,76 @@ public:
     bool seek(size_t position) override;
     bool eof() const override;
     size_t tell() override;
+    size_t readSome(char* buffer, size_t size) override;
+    uint64_t totalSize() const override { return fileSize; }
 
 private:
     std::ifstream file;
+    uint64_t fileSize = 0;
+};
+
+#ifdef GGUF_HAVE_MMAP
+// Memory-mapped file data source: reads are memcpy, skips are pointer bumps
+// and contents() exposes the mapping so the parser can borrow from it.
+class MmapDataSource : public DataSource {
+public:
+    MmapDataSource(const std::string& filename);
+    ~MmapDataSource() override;
+
+    MmapDataSource(const MmapDataSource&) = delete;
+    MmapDataSource& operator=(const MmapDataSource&) = delete;
+
+    bool read(char* buffer, size_t size) override;
+    bool seek(size_t position) override;
+    bool eof() const override;
+    size_t tell() override;
+    size_t readSome(char* buffer, size_t size) override;
+    std::string_view contents() const override { return std::string_view(mapping, length); }
+    uint64_t totalSize() const override { return length; }
+
+    const char* data() const { return mapping; }
+    size_t size() const { return length; }
+
+private:
+    const char* mapping = nullptr;
+    size_t length = 0;
+    size_t pos = 0;
+    bool _eof = false;
+};
+#endif
+
+// Bytes of a file's prefix held in memory, appended by the caller as they
+// arrive (see GGUFPushParser). contents() exposes them for in-place parsing.
+class BufferDataSource : public DataSource {
+public:
+    void append(const char* data, size_t size) { bytes.append(data, size); }
+    void setTotalSize(uint64_t size) { fileSize = size; }
+    size_t size() const { return bytes.size(); }
+
+    bool read(char* buffer, size_t size) override;
+    bool seek(size_t position) override;
+    bool eof() const override { return pos >= bytes.size(); }
+    size_t tell() override { return pos; }
+    size_t readSome(char* buffer, size_t size) override;
+    std::string_view contents() const override { return bytes; }
+    uint64_t totalSize() const override { return fileSize; }
+
+private:
+    std::string bytes;
+    size_t pos = 0;
+    uint64_t fileSize = 0;
+};
+
+// Adaptive read-ahead for UrlDataSource (native only). Range sizes grow
+// geometrically from `initialChunk` to `maxChunk`, and up to `maxRequests`
+// ranges stay in flight on a curl multi handle while the parser consumes the
+// current one. Read-ahead only starts once the header outgrows the first range.
+struct UrlReadAhead {
+    bool enabled = true;
+    size_t initialChunk = 64 * 1024;
+    size_t maxChunk = 2 * 1024 * 1024;
+    size_t maxBytesInFlight = 4 * 1024 * 1024;
+    size_t maxRequests = 4;
 };
 
 #ifndef __EMSCRIPTEN__
@@ -64,27 +254,85 @@ struct CurlBuffer {
     size_t pos;
     bool* abort_download;
 };
+
+// Matches a raw "<name>: <value>" header line; `name` must be lower case
+bool httpHeaderValue(std::string_view line, std::string_view name, std::string_view& value);
+
+class CurlMultiLoop;
 #endif
 
 // URL-based data source (libcurl on native, fetch() on WebAssembly)
 class UrlDataSource : public DataSource {
 public:
-    UrlDataSource(const std::string& url);
+    UrlDataSource(const std::string& url, const UrlReadAhead& readAhead = UrlReadAhead());
+#ifndef __EMSCRIPTEN__
+    // Runs every range on a shared multi loop (connections, DNS and TLS
+    // sessions reused across sources) instead of a private handle
+    UrlDataSource(const std::string& url, const UrlReadAhead& readAhead,
+                  std::shared_ptr<CurlMultiLoop> loop);
+#endif
     ~UrlDataSource() override;
 
+    UrlDataSource(const UrlDataSource&) = delete;
+    UrlDataSource& operator=(const UrlDataSource&) = delete;
+
     bool read(char* buffer, size_t size) override;
     bool seek(size_t position) override;
     bool eof() const override;
     size_t tell() override;
+    size_t readSome(char* buffer, size_t size) override;
+    // Learned from the Content-Range of the first ranged GET, so no HEAD is needed
+    uint64_t totalSize() const override { return totalBytes; }
     void setAbortFlag();
 
+    const std::string& getUrl() const { return url; }
+    // Validators from the last response, empty if the server sent none
+    const std::string& etag() const { return etagValue; }
+    const std::string& lastModified() const { return lastModifiedValue; }
+
 private:
+    bool fetchMore();
+
 #ifndef __EMSCRIPTEN__
+    // Size and validators seen in one response
+    struct ResponseHeaders {
+        uint64_t totalBytes = 0;
+        std::string etag;
+        std::string lastModified;
+    };
+
+    // One range of the read-ahead pipeline
+    struct RangeRequest {
+        CURL* easy = nullptr;
+        uint64_t start = 0;
+        size_t length = 0;
+        std::vector<char> data;
+        ResponseHeaders headers;
+        std::future<CURLcode> completion;   // Set when running on a shared loop
+        bool done = false;
+        CURLcode result = CURLE_OK;
+        bool* abort_download = nullptr;
+    };
+
+    bool fetchAhead(size_t fetchPos);
+    void scheduleAhead();
+    void pumpAhead(bool wait);
+    void finishRange(RangeRequest& req, CURLcode result);
+    void adoptHeaders(const ResponseHeaders& headers);
+    void recordTransfer(CURL* easy);
+    void popAhead();
+    void cancelAhead();
+
     static size_t WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static size_t RangeWriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata);
     static int ProgressCallback(void* clientp, curl_off_t, curl_off_t dlnow, curl_off_t, curl_off_t);
 #endif
 
     std::string url;
+    uint64_t totalBytes = 0;
+    std::string etagValue;
+    std::string lastModifiedValue;
 
 #ifdef __EMSCRIPTEN__
     std::vector<char> downloadedData;
@@ -96,6 +344,16 @@ private:
 #else
     CURL* curl = nullptr;
     CurlBuffer writeData{};
+    ResponseHeaders easyHeaders;
+    UrlReadAhead readAhead;
+    CURLM* multi = nullptr;
+    std::shared_ptr<CurlMultiLoop> loop;
+    std::deque<std::unique_ptr<RangeRequest>> ahead;
+    std::vector<CURL*> idleHandles;
+    uint64_t nextAheadStart = 0;
+    size_t nextAheadLength = 0;
+    size_t bytesAhead = 0;          // Scheduled but not yet consumed
+    size_t rangesConsumed = 0;
     std::vector<char> downloadedData;
     size_t bufferSize = 0;
     size_t bufferPos = 0;
@@ -108,7 +366,80 @@ private:
     static constexpr size_t CHUNK_SIZE  = 256 * 1024;    // 256KB chunk size
 };
 
+// Buffered parse cursor over a DataSource. Primitive reads, borrowed string
+// views and skips are inline pointer arithmetic on a window of bytes; the
+// virtual source is only called to refill the window. Sources that expose
+// contents() are parsed in place with no window at all.
+class GGUFCursor {
+public:
+    explicit GGUFCursor(DataSource* source, size_t windowSize = WINDOW_SIZE);
+
+    GGUFCursor(const GGUFCursor&) = delete;
+    GGUFCursor& operator=(const GGUFCursor&) = delete;
+
+    template <typename T>
+    bool read(T& out) {
+        static_assert(std::is_trivially_copyable<T>::value, "GGUFCursor::read needs a trivially copyable type");
+        if (static_cast<size_t>(end - cur) < sizeof(T) && !fill(sizeof(T)))
+            return false;
+        memcpy(&out, cur, sizeof(T));
+        cur += sizeof(T);
+        return true;
+    }
+
+    // Points `out` at the next `size` bytes; valid until the next cursor call
+    bool readView(size_t size, std::string_view& out) {
+        if (static_cast<size_t>(end - cur) < size && !fill(size))
+            return false;
+        out = std::string_view(cur, size);
+        cur += size;
+        return true;
+    }
+
+    // Appends the next `size` bytes to `out`, a window at a time
+    bool append(uint64_t size, std::string& out);
+
+    bool skip(uint64_t size) {
+        if (size <= static_cast<uint64_t>(end - cur)) {
+            cur += size;
+            return true;
+        }
+        return skipSlow(size);
+    }
+
+    size_t tell() const { return windowStart + static_cast<size_t>(cur - begin); }
+    bool eof() const { return exhausted && cur == end; }
+
+    // Offset a read or skip that ran out of data needed to reach; 0 if none did
+    uint64_t wantedEnd() const { return wanted; }
+
+private:
+    bool fill(size_t need);
+    bool skipSlow(uint64_t size);
+
+    DataSource* source;
+    std::vector<char> window;
+    const char* begin = nullptr;
+    const char* cur = nullptr;
+    const char* end = nullptr;
+    size_t windowStart = 0;     // Absolute offset of `begin`
+    bool borrowed = false;      // Parsing in place from source->contents()
+    bool exhausted = false;
+    uint64_t wanted = 0;
+
+    static constexpr size_t WINDOW_SIZE = 64 * 1024;
+};
+
+#ifndef __EMSCRIPTEN__
+class HeaderCache;
+#endif
+
+class GGUFMetadata;
+class GGUFKeySchema;
+
 class GGUFMetadataReader {
+    friend class GGUFPushParser;
+
 public:
     // GGUF metadata types
     enum class GGUFType : uint32_t {
@@ -129,21 +460,86 @@ public:
     };
 
     GGUFMetadataReader();
-    ~GGUFMetadataReader();
 
     bool isUrl(const std::string& path);
-    std::optional<GGUFModelParams> readModelParams(const std::string& path, bool verbose = false);
+
+    // Read-ahead settings for URL sources opened by this reader
+    void setReadAhead(const UrlReadAhead& options) { readAhead = options; }
+
+#ifndef __EMSCRIPTEN__
+    // Shared event loop for URL sources; nullptr gives each source its own handles
+    void setMultiLoop(std::shared_ptr<CurlMultiLoop> loop) { multiLoop = std::move(loop); }
+
+    // On-disk header cache for URL sources: hits are parsed with no network
+    // I/O and every complete readModelInfo() over the network is stored.
+    void setHeaderCache(std::shared_ptr<HeaderCache> cache) { headerCache = std::move(cache); }
+#endif
+    // Scans every metadata key (the optional attention-geometry keys may come
+    // last) and stops before the tensor-info table; readModelInfo() reads it too.
+    // `stats`, if given, receives the probe's I/O and timing.
+    std::optional<GGUFModelParams> readModelParams(const std::string& path, bool verbose = false,
+                                                   ProbeStats* stats = nullptr);
+
+    // Same, over an already open source positioned at the start of the file
+    std::optional<GGUFModelParams> readModelParams(DataSource& source, bool verbose = false,
+                                                   ProbeStats* stats = nullptr);
+
+    // Reads the whole header including the tensor-info table (no early stop),
+    // so exact weight bytes are known without fetching any tensor data.
+    std::optional<GGUFModelInfo> readModelInfo(const std::string& path, bool verbose = false,
+                                               ProbeStats* stats = nullptr);
+
+    // readModelInfo() for any shard of a split model: only the first shard
+    // carries the model parameters, so they are not required (left zero when
+    // absent). Merge a whole set with mergeSplitInfos() (gguf_split.h).
+    std::optional<GGUFModelInfo> readShardInfo(const std::string& path, bool verbose = false,
+                                               ProbeStats* stats = nullptr);
+
+    // Indexes every metadata key in one pass (see gguf_metadata.h); stops
+    // before the tensor-info table
+    std::optional<GGUFMetadata> readMetadata(const std::string& path, bool verbose = false);
+
+    // Indexes only the keys `schema` selects and stops reading as soon as all
+    // of its Required patterns have matched (see gguf_key_schema.h)
+    std::optional<GGUFMetadata> readMetadata(const std::string& path, const GGUFKeySchema& schema,
+                                             bool verbose = false);
+
+    // Encoded size of fixed-size GGUF types; 0 for STRING/ARRAY
+    static size_t fixedTypeSize(GGUFType type);
 
 private:
-    bool endsWith(const std::string& str, const std::string& suffix);
-    std::string readString(DataSource* source);
-    void skipArray(DataSource* source, GGUFType elemType);
-    void skipValue(DataSource* source, GGUFType type);
+    UrlReadAhead readAhead;
+#ifndef __EMSCRIPTEN__
+    std::shared_ptr<HeaderCache> headerCache;
+    std::shared_ptr<CurlMultiLoop> multiLoop;
+#endif
+
+    std::unique_ptr<DataSource> openSource(const std::string& path, bool verbose, ProbeStats* stats = nullptr);
+#ifndef __EMSCRIPTEN__
+    std::unique_ptr<UrlDataSource> openUrl(const std::string& url);
+#endif
+    bool readPreamble(GGUFCursor& cursor, uint32_t& version, uint64_t& tensorCount,
+                      uint64_t& metadataCount, bool verbose);
+    std::optional<GGUFMetadata> readMetadata(const std::string& path, const GGUFKeySchema* schema, bool verbose);
+    std::optional<GGUFModelInfo> readModelInfo(const std::string& path, bool requireParams, bool verbose,
+                                               ProbeStats* stats);
+    bool parseHeader(GGUFCursor& cursor, GGUFModelInfo& info, bool withTensors, bool requireParams, bool verbose,
+                     ProbeStats* stats);
+    void scanMetadata(GGUFCursor& cursor, uint64_t metadataCount, const GGUFKeySchema* schema,
+                      bool stopEarly, GGUFMetadata& metadata, bool verbose, ProbeStats* stats = nullptr);
+    void readTensorTable(GGUFCursor& cursor, uint64_t tensorCount, GGUFTensorTable& table, bool verbose);
+    std::string readString(GGUFCursor& cursor);
+    std::string_view readKey(GGUFCursor& cursor);
+    void skipArray(GGUFCursor& cursor, GGUFType elemType);
+    void skipValue(GGUFCursor& cursor, GGUFType type);
+    void copyValue(GGUFCursor& cursor, GGUFType type, std::string& out);
 };
 
 #ifdef __EMSCRIPTEN__
 // Simple JS-facing helpers (via Embind)
+#ifdef GGUF_WASM_ASYNC_FETCH
 emscripten::val readParamsFromUrl(const std::string& url, bool verbose);
+#endif
 emscripten::val readParamsFromFile(const std::string& path, bool verbose);
 #endif
 
@@ -0,0 +1,97 @@
+#include "gguf_split.h"
+
+#include <cstdio>
+
+namespace {
+
+constexpr std::string_view EXTENSION = ".gguf";
+
+// Exactly five digits, like llama.cpp's "%s-%05d-of-%05d.gguf"
+bool readNumber(std::string_view digits, uint32_t& value) {
+    if (digits.size() != 5)
+        return false;
+    value = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9')
+            return false;
+        value = value * 10 + static_cast<uint32_t>(c - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+std::string GGUFSplitName::shardPath(uint32_t shard) const {
+    char tail[32];
+    std::snprintf(tail, sizeof(tail), "-%05u-of-%05u.gguf", shard, count);
+    return prefix + tail + suffix;
+}
+
+std::optional<GGUFSplitName> parseSplitName(std::string_view path) {
+    GGUFSplitName name;
+    size_t end = path.find_first_of("?#");
+    if (end != std::string_view::npos) {
+        name.suffix = std::string(path.substr(end));
+        path = path.substr(0, end);
+    }
+
+    // "-NNNNN-of-NNNNN.gguf"
+    constexpr size_t TAIL = 1 + 5 + 4 + 5;
+    if (path.size() < TAIL + EXTENSION.size() || path.substr(path.size() - EXTENSION.size()) != EXTENSION)
+        return std::nullopt;
+    std::string_view tail = path.substr(path.size() - EXTENSION.size() - TAIL, TAIL);
+    if (tail[0] != '-' || tail.substr(6, 4) != "-of-" ||
+        !readNumber(tail.substr(1, 5), name.index) || !readNumber(tail.substr(10, 5), name.count))
+        return std::nullopt;
+    if (name.index == 0 || name.count == 0 || name.index > name.count)
+        return std::nullopt;
+
+    name.prefix = std::string(path.substr(0, path.size() - EXTENSION.size() - TAIL));
+    return name;
+}
+
+std::optional<GGUFModelInfo> mergeSplitInfos(const std::vector<GGUFModelInfo>& shards) {
+    if (shards.empty())
+        return std::nullopt;
+    const uint32_t count = std::max<uint32_t>(shards.front().split_count, 1);
+    if (shards.size() != count)
+        return std::nullopt;
+
+    // Index by split.no so the set can arrive in any order
+    std::vector<const GGUFModelInfo*> ordered(count, nullptr);
+    for (const auto& shard : shards) {
+        if (std::max<uint32_t>(shard.split_count, 1) != count || shard.split_no >= count || ordered[shard.split_no])
+            return std::nullopt;
+        ordered[shard.split_no] = &shard;
+    }
+    if (ordered[0]->params.hidden_layers == 0)
+        return std::nullopt;
+
+    GGUFModelInfo merged;
+    merged.params = ordered[0]->params;
+    merged.split_count = count;
+    merged.tensorTable.alignment = ordered[0]->tensorTable.alignment;
+    merged.tensorTable.data_offset = ordered[0]->tensorTable.data_offset;
+    for (const GGUFModelInfo* shard : ordered) {
+        const GGUFTensorTable& table = shard->tensorTable;
+        merged.tensorTable.tensors.insert(merged.tensorTable.tensors.end(), table.tensors.begin(), table.tensors.end());
+        merged.tensorTable.weight_bytes += table.weight_bytes;
+        merged.tensorTable.file_size += table.file_size;
+        merged.file_size += shard->file_size;
+    }
+    // A size is only meaningful when every shard reported one
+    for (const GGUFModelInfo* shard : ordered)
+        if (shard->file_size == 0)
+            merged.file_size = 0;
+
+    // The embedding matrix may live in a later shard than the parameters
+    if (merged.params.vocab_size == 0) {
+        for (const auto& tensor : merged.tensorTable.tensors) {
+            if (tensor.name == "token_embd.weight" && tensor.n_dims >= 2) {
+                merged.params.vocab_size = static_cast<uint32_t>(tensor.dims[1]);
+                break;
+            }
+        }
+    }
+    return merged;
+}
@@ -0,0 +1,33 @@
+#ifndef GGUF_SPLIT_H
+#define GGUF_SPLIT_H
+
+#include "gguf_reader.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A shard name in gguf-split's "<prefix>-00001-of-00005.gguf" scheme. For
+// URLs the query and fragment are kept aside so sibling URLs keep them.
+struct GGUFSplitName {
+    std::string prefix;             // Everything before "-NNNNN-of-NNNNN.gguf"
+    std::string suffix;             // "?..." / "#..." of a URL; empty for paths
+    uint32_t index = 0;             // 1-based shard number
+    uint32_t count = 0;
+
+    // Path or URL of shard `index` (1-based) of the same set
+    std::string shardPath(uint32_t index) const;
+};
+
+std::optional<GGUFSplitName> parseSplitName(std::string_view path);
+
+// One model from the per-shard profiles of a complete set (any order):
+// parameters from the first shard, tensor tables concatenated (offsets stay
+// relative to each shard's data section), weight and file sizes summed.
+// Returns nullopt when shards are missing, duplicated or disagree on
+// split.count.
+std::optional<GGUFModelInfo> mergeSplitInfos(const std::vector<GGUFModelInfo>& shards);
+
+#endif // GGUF_SPLIT_H
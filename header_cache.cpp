@@ -0,0 +1,370 @@
+#include "header_cache.h"
+#include "network_context.h"
+
+#ifndef __EMSCRIPTEN__
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+  #include <process.h>
+  #define getpid _getpid
+#else
+  #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// FNV-1a: stable across runs and platforms, good enough to name cache files
+uint64_t hashUrl(const std::string& url) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : url) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// The same over 8-byte words: fast enough to check a whole cached header on every hit
+uint64_t hashContents(std::string_view bytes) {
+    uint64_t h = 0xcbf29ce484222325ull ^ bytes.size();
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i, 8);
+        h = (h ^ word) * 0x100000001b3ull;
+        h ^= h >> 29;
+    }
+    for (; i < bytes.size(); ++i)
+        h = (h ^ static_cast<unsigned char>(bytes[i])) * 0x100000001b3ull;
+    return h;
+}
+
+std::string hexHash(uint64_t h) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(h));
+    return text;
+}
+
+// Next to `path` and unique to this process and call, so concurrent writers
+// never share a temporary; rename() then publishes it whole
+std::string tempPath(const std::string& path) {
+    static std::atomic<uint64_t> counter{0};
+    return path + "." + std::to_string(getpid()) + "-" + std::to_string(++counter) + ".tmp";
+}
+
+bool writeFileAtomically(const std::string& path, std::string_view bytes) {
+    std::string tmp = tempPath(path);
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec)
+        fs::remove(tmp, ec);
+    return !ec;
+}
+
+// Cached header bytes, reporting the size of the remote file rather than of the cache entry
+class CachedHeaderDataSource : public DataSource {
+public:
+    CachedHeaderDataSource(std::unique_ptr<DataSource> inner, uint64_t fileSize)
+        : inner(std::move(inner)), fileSize(fileSize) {}
+
+    bool read(char* buffer, size_t size) override { return inner->read(buffer, size); }
+    bool seek(size_t position) override { return inner->seek(position); }
+    bool eof() const override { return inner->eof(); }
+    size_t tell() override { return inner->tell(); }
+    size_t readSome(char* buffer, size_t size) override { return inner->readSome(buffer, size); }
+    std::string_view contents() const override { return inner->contents(); }
+    uint64_t totalSize() const override { return fileSize; }
+
+private:
+    std::unique_ptr<DataSource> inner;
+    uint64_t fileSize;
+};
+
+struct ValidatorResponse {
+    std::string etag;
+    std::string lastModified;
+};
+
+// The status line and headers are all revalidation needs: refusing the first
+// body byte ends the transfer (CURLE_WRITE_ERROR), so a server that ignores
+// Range cannot stream the whole model at us
+size_t refuseBody(char*, size_t, size_t, void*) {
+    return 0;
+}
+
+size_t captureValidators(char* buffer, size_t size, size_t nitems, void* userdata) {
+    ValidatorResponse* response = static_cast<ValidatorResponse*>(userdata);
+    std::string_view line(buffer, size * nitems);
+    std::string_view value;
+    if (httpHeaderValue(line, "etag", value))
+        response->etag.assign(value);
+    else if (httpHeaderValue(line, "last-modified", value))
+        response->lastModified.assign(value);
+    return size * nitems;
+}
+
+} // namespace
+
+// ----------------------- RecordingUrlDataSource -----------------------
+RecordingUrlDataSource::RecordingUrlDataSource(std::unique_ptr<UrlDataSource> inner)
+    : inner(std::move(inner)) {}
+
+bool RecordingUrlDataSource::read(char* buffer, size_t size) {
+    size_t position = inner->tell();
+    if (!inner->read(buffer, size))
+        return false;
+    record(position, buffer, size);
+    return true;
+}
+
+bool RecordingUrlDataSource::seek(size_t position) {
+    if (position <= bytes.size() || inner->tell() != bytes.size())
+        return inner->seek(position);
+
+    // Read through the skipped range so the recorded header has no holes
+    char chunk[64 * 1024];
+    while (bytes.size() < position) {
+        size_t want = std::min(sizeof(chunk), position - bytes.size());
+        size_t n = readSome(chunk, want);
+        if (n == 0)
+            return false;
+    }
+    return true;
+}
+
+bool RecordingUrlDataSource::eof() const {
+    return inner->eof();
+}
+
+size_t RecordingUrlDataSource::tell() {
+    return inner->tell();
+}
+
+size_t RecordingUrlDataSource::readSome(char* buffer, size_t size) {
+    size_t position = inner->tell();
+    size_t n = inner->readSome(buffer, size);
+    record(position, buffer, n);
+    return n;
+}
+
+uint64_t RecordingUrlDataSource::totalSize() const {
+    return inner->totalSize();
+}
+
+void RecordingUrlDataSource::record(size_t position, const char* data, size_t size) {
+    if (position > bytes.size() || position + size <= bytes.size())
+        return;
+    size_t skip = bytes.size() - position;
+    bytes.append(data + skip, size - skip);
+}
+
+// ----------------------- HeaderCache -----------------------
+HeaderCache::HeaderCache(HeaderCacheOptions options) : options(std::move(options)) {
+    if (this->options.directory.empty())
+        this->options.directory = defaultDirectory();
+    std::error_code ec;
+    fs::create_directories(this->options.directory, ec);
+}
+
+std::string HeaderCache::defaultDirectory() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        return (fs::path(xdg) / "model-memory-calc").string();
+    if (const char* home = std::getenv("HOME"); home && *home)
+        return (fs::path(home) / ".cache" / "model-memory-calc").string();
+    return (fs::temp_directory_path() / "model-memory-calc").string();
+}
+
+std::unique_ptr<DataSource> HeaderCache::lookup(const std::string& url) {
+    Entry entry;
+    if (!readEntry(url, entry))
+        return nullptr;
+
+    if (nowSeconds() - entry.storedAt > options.maxAgeSeconds) {
+        if (!options.revalidate || !revalidate(entry)) {
+            remove(url);
+            return nullptr;
+        }
+        entry.storedAt = nowSeconds();
+        writeEntry(entry);
+    }
+
+    std::string path = entryPath(url, ".header");
+    std::error_code ec;
+    if (fs::file_size(path, ec) != entry.headerBytes || ec) {
+        remove(url);
+        return nullptr;
+    }
+
+    std::unique_ptr<DataSource> inner;
+    try {
+#ifdef GGUF_HAVE_MMAP
+        inner = std::make_unique<MmapDataSource>(path);
+#else
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        auto buffer = std::make_unique<BufferDataSource>();
+        buffer->append(bytes.data(), bytes.size());
+        inner = std::move(buffer);
+#endif
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+    // A .header from a different store than this .meta (concurrent writers
+    // interleaved, or a crash between the two renames): evict the pair
+    std::string_view bytes = inner->contents();
+    if (bytes.size() != entry.headerBytes || hexHash(hashContents(bytes)) != entry.headerHash) {
+        inner.reset();
+        remove(url);
+        return nullptr;
+    }
+    return std::make_unique<CachedHeaderDataSource>(std::move(inner), entry.fileSize);
+}
+
+bool HeaderCache::store(const RecordingUrlDataSource& source, uint64_t headerBytes) {
+    const std::string& url = source.source().getUrl();
+    const std::string& recorded = source.recorded();
+    if (headerBytes == 0 || headerBytes > recorded.size() + 4096)
+        return false; // Never reached the tensor data: nothing trustworthy to store
+
+    // Only alignment padding can be missing at the end; it is zero in the file too
+    std::string header = recorded.substr(0, static_cast<size_t>(headerBytes));
+    header.resize(static_cast<size_t>(headerBytes), '\0');
+
+    Entry entry;
+    entry.url = url;
+    entry.etag = source.source().etag();
+    entry.lastModified = source.source().lastModified();
+    entry.fileSize = source.totalSize();
+    entry.headerBytes = headerBytes;
+    entry.headerHash = hexHash(hashContents(header));
+    entry.storedAt = nowSeconds();
+
+    // Each file is renamed into place whole, the .meta last: a reader pairing
+    // it with another writer's .header sees the hash differ
+    if (!writeFileAtomically(entryPath(url, ".header"), header))
+        return false;
+    return writeEntry(entry);
+}
+
+void HeaderCache::remove(const std::string& url) {
+    std::error_code ec;
+    fs::remove(entryPath(url, ".meta"), ec);
+    fs::remove(entryPath(url, ".header"), ec);
+}
+
+std::string HeaderCache::entryPath(const std::string& url, const char* extension) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hashUrl(url)));
+    return (fs::path(options.directory) / (std::string(name) + extension)).string();
+}
+
+bool HeaderCache::readEntry(const std::string& url, Entry& entry) const {
+    std::ifstream in(entryPath(url, ".meta"));
+    if (!in)
+        return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t sep = line.find(": ");
+        if (sep == std::string::npos)
+            continue;
+        std::string key = line.substr(0, sep);
+        std::string value = line.substr(sep + 2);
+        if (key == "url") entry.url = value;
+        else if (key == "etag") entry.etag = value;
+        else if (key == "last-modified") entry.lastModified = value;
+        else if (key == "file-size") entry.fileSize = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "header-bytes") entry.headerBytes = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "header-hash") entry.headerHash = value;
+        else if (key == "stored-at") entry.storedAt = std::strtoll(value.c_str(), nullptr, 10);
+    }
+    // A hash collision shows up as a different URL
+    return entry.url == url && entry.headerBytes > 0;
+}
+
+bool HeaderCache::writeEntry(const Entry& entry) const {
+    std::ostringstream out;
+    out << "url: " << entry.url << "\n"
+        << "etag: " << entry.etag << "\n"
+        << "last-modified: " << entry.lastModified << "\n"
+        << "file-size: " << entry.fileSize << "\n"
+        << "header-bytes: " << entry.headerBytes << "\n"
+        << "header-hash: " << entry.headerHash << "\n"
+        << "stored-at: " << entry.storedAt << "\n";
+    return writeFileAtomically(entryPath(entry.url, ".meta"), out.str());
+}
+
+// Conditional one-byte GET, stopped at the first body byte: 304, or unchanged
+// validators on a server that ignores conditionals, keeps the entry. Only a
+// server that cannot be reached at all keeps it unchecked.
+bool HeaderCache::revalidate(const Entry& entry) const {
+    if (entry.etag.empty() && entry.lastModified.empty())
+        return false;
+
+    CurlHandleLease lease(entry.url);
+    CURL* curl = lease.get();
+
+    struct curl_slist* headers = nullptr;
+    if (!entry.etag.empty())
+        headers = curl_slist_append(headers, ("If-None-Match: " + entry.etag).c_str());
+    if (!entry.lastModified.empty())
+        headers = curl_slist_append(headers, ("If-Modified-Since: " + entry.lastModified).c_str());
+
+    ValidatorResponse response;
+    curl_easy_setopt(curl, CURLOPT_URL, entry.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_RANGE, "0-0");
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, refuseBody);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, captureValidators);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 20L);
+
+    CURLcode res = curl_easy_perform(curl);
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(headers);
+
+    // Refusing the body still leaves a complete answer: the status and headers
+    bool answered = res == CURLE_OK || (res == CURLE_WRITE_ERROR && status != 0);
+    if (!answered) {
+        // Unreachable server: keep serving the cached header rather than failing
+        // the probe. Anything else (a timeout, a broken reply) says nothing about
+        // the file, so the entry goes.
+        return res == CURLE_COULDNT_RESOLVE_HOST || res == CURLE_COULDNT_RESOLVE_PROXY ||
+               res == CURLE_COULDNT_CONNECT;
+    }
+    if (status == 304)
+        return true;
+    if (status == 200 || status == 206) {
+        if (!entry.etag.empty())
+            return response.etag == entry.etag;
+        return !response.lastModified.empty() && response.lastModified == entry.lastModified;
+    }
+    return false;
+}
+
+#endif // __EMSCRIPTEN__
@@ -0,0 +1,84 @@
+#ifndef HEADER_CACHE_H
+#define HEADER_CACHE_H
+
+#include "gguf_reader.h"
+
+#ifndef __EMSCRIPTEN__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Settings for the on-disk GGUF header cache
+struct HeaderCacheOptions {
+    std::string directory;                  // Empty: HeaderCache::defaultDirectory()
+    int64_t maxAgeSeconds = 24 * 3600;      // Entries younger than this are used without any request
+    bool revalidate = true;                 // Older entries: conditional GET (true) or drop (false)
+};
+
+// UrlDataSource wrapper that keeps a copy of every byte the parser consumes,
+// so a completed parse can be written to the HeaderCache. Forward seeks read
+// through the gap instead of jumping, which keeps the copy contiguous.
+class RecordingUrlDataSource : public DataSource {
+public:
+    explicit RecordingUrlDataSource(std::unique_ptr<UrlDataSource> inner);
+
+    bool read(char* buffer, size_t size) override;
+    bool seek(size_t position) override;
+    bool eof() const override;
+    size_t tell() override;
+    size_t readSome(char* buffer, size_t size) override;
+    uint64_t totalSize() const override;
+    void setStats(ProbeStats* probeStats) override { inner->setStats(probeStats); }
+
+    const UrlDataSource& source() const { return *inner; }
+    const std::string& recorded() const { return bytes; }
+
+private:
+    void record(size_t position, const char* data, size_t size);
+
+    std::unique_ptr<UrlDataSource> inner;
+    std::string bytes;
+};
+
+// Persistent cache of raw GGUF header bytes (everything before the tensor
+// data), keyed by a hash of the URL. Hits are memory-mapped and parsed with
+// no network I/O; entries older than maxAgeSeconds are revalidated with a
+// conditional ranged GET (If-None-Match / If-Modified-Since).
+class HeaderCache {
+public:
+    explicit HeaderCache(HeaderCacheOptions options = HeaderCacheOptions());
+
+    // $XDG_CACHE_HOME/model-memory-calc, else ~/.cache/model-memory-calc
+    static std::string defaultDirectory();
+
+    // Source over the cached header for `url`, or nullptr on a miss / stale entry
+    std::unique_ptr<DataSource> lookup(const std::string& url);
+
+    // Stores the first `headerBytes` bytes recorded while parsing `source`
+    bool store(const RecordingUrlDataSource& source, uint64_t headerBytes);
+
+    void remove(const std::string& url);
+
+private:
+    struct Entry {
+        std::string url;
+        std::string etag;
+        std::string lastModified;
+        uint64_t fileSize = 0;
+        uint64_t headerBytes = 0;
+        std::string headerHash;         // Of the .header written with this .meta
+        int64_t storedAt = 0;
+    };
+
+    std::string entryPath(const std::string& url, const char* extension) const;
+    bool readEntry(const std::string& url, Entry& entry) const;
+    bool writeEntry(const Entry& entry) const;
+    bool revalidate(const Entry& entry) const;
+
+    HeaderCacheOptions options;
+};
+
+#endif // __EMSCRIPTEN__
+
+#endif // HEADER_CACHE_H
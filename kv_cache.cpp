@@ -0,0 +1,73 @@
+#include "kv_cache.h"
+
+#include <cctype>
+
+namespace {
+
+// Bytes for `count` elements of `type`, rounded up to whole blocks
+uint64_t rowBytes(GGMLType type, uint64_t count) {
+    const GGMLTypeTraits* traits = ggmlTypeTraits(static_cast<uint32_t>(type));
+    if (!traits)
+        throw std::invalid_argument("Unsupported KV cache type: " + std::to_string(static_cast<uint32_t>(type)));
+    return (count + traits->blockSize - 1) / traits->blockSize * traits->typeSize;
+}
+
+} // namespace
+
+KVCacheEstimate estimateKVCache(const GGUFModelParams& params, uint64_t contextSize,
+                                const KVCacheOptions& options, uint32_t sequences, uint32_t ubatchSize) {
+    KVCacheEstimate estimate;
+    uint64_t fullCells = contextSize * std::max<uint32_t>(sequences, 1);
+
+    // Head widths default to hidden / heads, as in llama.cpp
+    uint64_t headDim = params.attention_heads > 0 ? params.hidden_size / params.attention_heads : 0;
+    uint64_t keyLength = params.key_length > 0 ? params.key_length : headDim;
+    uint64_t valueLength = params.value_length > 0 ? params.value_length : headDim;
+    if (keyLength == 0 || valueLength == 0) {
+        // f16 K and V of hidden_size per token and layer
+        estimate.layerBytes.assign(params.hidden_layers, 4 * params.hidden_size * fullCells);
+        estimate.bytes = 4 * params.hidden_size * params.hidden_layers * fullCells;
+        estimate.fullLayers = params.hidden_layers;
+        estimate.approximate = true;
+        return estimate;
+    }
+
+    estimate.layerBytes.assign(params.hidden_layers, 0);
+    for (uint32_t il = 0; il < params.hidden_layers; ++il) {
+        uint64_t kvHeads = params.layer_kv_heads.empty() ? params.kv_heads : params.layer_kv_heads[il];
+        if (kvHeads == 0)
+            continue;
+
+        bool sliding = !params.layer_sliding.empty() && params.layer_sliding[il];
+        uint64_t cells = fullCells;
+        if (sliding) {
+            uint64_t window = std::min<uint64_t>(contextSize, params.sliding_window);
+            cells = std::min(fullCells, window * std::max<uint32_t>(sequences, 1) + ubatchSize);
+        }
+        (sliding ? estimate.slidingLayers : estimate.fullLayers)++;
+
+        // One K row and one V row per cached token
+        estimate.layerBytes[il] = cells * (rowBytes(options.typeK, keyLength * kvHeads) +
+                                           rowBytes(options.typeV, valueLength * kvHeads));
+        estimate.bytes += estimate.layerBytes[il];
+    }
+    return estimate;
+}
+
+std::optional<GGMLType> parseKVCacheType(std::string_view name) {
+    std::string lower(name);
+    for (char& c : lower)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+    for (uint32_t id = 0; id < static_cast<uint32_t>(GGMLType::COUNT); ++id) {
+        const GGMLTypeTraits* traits = ggmlTypeTraits(id);
+        if (!traits)
+            continue;
+        std::string typeName(traits->name);
+        for (char& c : typeName)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        if (typeName == lower)
+            return static_cast<GGMLType>(id);
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,37 @@
+#ifndef KV_CACHE_H
+#define KV_CACHE_H
+
+#include "gguf_reader.h"
+
+#include <cstdint>
+
+// Storage of the K and V caches; llama.cpp's --cache-type-k / --cache-type-v.
+// F16 is the default; Q8_0 and Q4_0 are the usual quantized choices, and any
+// type with a block layout (see ggmlTypeTraits) is accepted.
+struct KVCacheOptions {
+    GGMLType typeK = GGMLType::F16;
+    GGMLType typeV = GGMLType::F16;
+};
+
+struct KVCacheEstimate {
+    uint64_t bytes = 0;
+    std::vector<uint64_t> layerBytes;   // Per block; the KV of a layer lives with its weights
+    uint32_t fullLayers = 0;        // Layers caching the whole context
+    uint32_t slidingLayers = 0;     // Layers caching at most sliding_window tokens
+    bool approximate = false;       // Head geometry missing: 4 * hidden * layers * context
+};
+
+// KV cache for `sequences` parallel sequences of `contextSize` tokens each,
+// summed per layer from the KV head count, the K/V head widths (key_length /
+// value_length, else hidden / heads), the cache types and each layer's
+// window. Sliding-window layers also keep one micro-batch (`ubatchSize`)
+// beyond the window, as llama.cpp does. Layers without KV heads (recurrent
+// blocks of hybrid models) cost nothing here.
+KVCacheEstimate estimateKVCache(const GGUFModelParams& params, uint64_t contextSize,
+                                const KVCacheOptions& options = KVCacheOptions(),
+                                uint32_t sequences = 1, uint32_t ubatchSize = 0);
+
+// Parses "f16", "q8_0", "q4_0", ... (case-insensitive)
+std::optional<GGMLType> parseKVCacheType(std::string_view name);
+
+#endif // KV_CACHE_H
@@ -1,15 +1,17 @@
 #include "model_file.h"
 
 #include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <unordered_map>
 #include <iostream>
 
 #ifndef __EMSCRIPTEN__
+  #include <filesystem>
   #include <future>
-  #include <chrono>
   #include <thread>
+  #include <mutex>
   #include <curl/curl.h>
 #else
   #include <emscripten.h>
@@ -44,64 +46,43 @@ bool ModelFile::updateDisplayIfReady() {
 
 // ---------- Quantization detection ----------
 QuantizationInfo ModelFileUtils::detectQuantization(const std::string& filename) {
-    std::string s = filename;
-    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return quantizationFromFilename(filename);
+}
 
-    auto pick = [](std::string t, std::string d, int p) {
-        return QuantizationInfo{std::move(t), std::move(d), p};
-    };
+QuantizationInfo ModelFileUtils::detectQuantization(const GGUFModelInfo& info, const std::string& filename) {
+    return quantizationFromHeader(info, filename);
+}
+
+void ModelFileUtils::groupShards(std::vector<ModelFile>& modelFiles) {
+    // Shard sets keyed by model, name prefix and shard count; the first entry seen stands for the set
+    std::unordered_map<std::string, size_t> sets;
+    std::vector<ModelFile> grouped;
+    grouped.reserve(modelFiles.size());
+
+    for (auto& mf : modelFiles) {
+        const std::string& path = mf.downloadUrl.has_value() ? *mf.downloadUrl : mf.filename;
+        auto name = parseSplitName(path);
+        if (!name) {
+            grouped.push_back(std::move(mf));
+            continue;
+        }
 
-    // (Keep your original ordering/labels)
-    if (s.find("iq1_s") != std::string::npos && s.find("ud-") != std::string::npos) return pick("UD-IQ1_S","1-bit UD, ultra compact",1);
-    if (s.find("iq1_m") != std::string::npos && s.find("ud-") != std::string::npos) return pick("UD-IQ1_M","1-bit UD, medium variant",2);
-    if (s.find("iq2_xxs")!=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-IQ2_XXS","2-bit UD, ultra small",3);
-    if (s.find("iq2_m")  !=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-IQ2_M","2-bit UD, balanced",4);
-    if (s.find("iq3_xxs")!=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-IQ3_XXS","3-bit UD, very small",5);
-    if (s.find("q2_k_xl")!=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-Q2_K_XL","2-bit UD K-quant, very compact",6);
-    if (s.find("q3_k_xl")!=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-Q3_K_XL","3-bit UD K-quant, compact",7);
-    if (s.find("q4_k_xl")!=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-Q4_K_XL","4-bit UD K-quant, good quality",8);
-    if (s.find("q5_k_xl")!=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-Q5_K_XL","5-bit UD K-quant, high quality",9);
-    if (s.find("q6_k_xl")!=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-Q6_K_XL","6-bit UD K-quant, very high quality",10);
-    if (s.find("q8_k_xl")!=std::string::npos && s.find("ud-")!=std::string::npos) return pick("UD-Q8_K_XL","8-bit UD K-quant, maximum quality",11);
-
-    if (s.find("q8_k_xl")!=std::string::npos) return pick("Q8_K_XL","8-bit K-quant, maximum quality",12);
-    if (s.find("q6_k_xl")!=std::string::npos) return pick("Q6_K_XL","6-bit K-quant, very high quality",13);
-    if (s.find("q5_k_xl")!=std::string::npos) return pick("Q5_K_XL","5-bit K-quant, high quality",14);
-    if (s.find("q4_k_xl")!=std::string::npos) return pick("Q4_K_XL","4-bit K-quant, good quality",15);
-    if (s.find("q3_k_xl")!=std::string::npos) return pick("Q3_K_XL","3-bit K-quant, compact",16);
-    if (s.find("q2_k_xl")!=std::string::npos) return pick("Q2_K_XL","2-bit K-quant, very compact",17);
-
-    if (s.find("q8_0")   !=std::string::npos) return pick("Q8_0","8-bit quant, excellent quality",18);
-    if (s.find("q6_k")   !=std::string::npos) return pick("Q6_K","6-bit quant, high quality",19);
-    if (s.find("q5_k_m") !=std::string::npos) return pick("Q5_K_M","5-bit quant medium, balanced",20);
-    if (s.find("q5_k_s") !=std::string::npos) return pick("Q5_K_S","5-bit quant small, compact",21);
-    if (s.find("q5_0")   !=std::string::npos) return pick("Q5_0","5-bit quant, legacy",22);
-
-    if (s.find("iq4_nl") !=std::string::npos) return pick("IQ4_NL","4-bit improved, very efficient",23);
-    if (s.find("iq4_xs") !=std::string::npos) return pick("IQ4_XS","4-bit improved, ultra compact",24);
-    if (s.find("q4_k_m") !=std::string::npos) return pick("Q4_K_M","4-bit quant medium, recommended",25);
-    if (s.find("q4_k_l") !=std::string::npos) return pick("Q4_K_L","4-bit quant large, better quality",26);
-    if (s.find("q4_k_s") !=std::string::npos) return pick("Q4_K_S","4-bit quant small, very compact",27);
-    if (s.find("q4_1")   !=std::string::npos) return pick("Q4_1","4-bit quant v1, improved legacy",28);
-    if (s.find("q4_0")   !=std::string::npos) return pick("Q4_0","4-bit quant, legacy",29);
-
-    if (s.find("iq3_xxs")!=std::string::npos) return pick("IQ3_XXS","3-bit improved, maximum compression",30);
-    if (s.find("q3_k_l") !=std::string::npos) return pick("Q3_K_L","3-bit quant large, experimental",31);
-    if (s.find("q3_k_m") !=std::string::npos) return pick("Q3_K_M","3-bit quant medium, very small",32);
-    if (s.find("q3_k_s") !=std::string::npos) return pick("Q3_K_S","3-bit quant small, ultra compact",33);
-
-    if (s.find("iq2_xxs")!=std::string::npos) return pick("IQ2_XXS","2-bit improved, extreme compression",34);
-    if (s.find("iq2_m")  !=std::string::npos) return pick("IQ2_M","2-bit improved, balanced",35);
-    if (s.find("q2_k_l") !=std::string::npos) return pick("Q2_K_L","2-bit quant large, better quality",36);
-    if (s.find("q2_k")   !=std::string::npos) return pick("Q2_K","2-bit quant, extremely small",37);
-
-    if (s.find("iq1_s")  !=std::string::npos) return pick("IQ1_S","1-bit improved, experimental",38);
-    if (s.find("iq1_m")  !=std::string::npos) return pick("IQ1_M","1-bit improved medium, experimental",39);
-
-    if (s.find("f16")    !=std::string::npos) return pick("F16","16-bit float, highest quality",40);
-    if (s.find("f32")    !=std::string::npos) return pick("F32","32-bit float, original precision",41);
-
-    return pick("Unknown","Unknown quantization type",42);
+        std::string key = mf.modelId + '\n' + name->prefix + '\n' + std::to_string(name->count);
+        if (sets.count(key))
+            continue;
+        sets.emplace(key, grouped.size());
+
+        // Point the entry at the first shard, which carries the metadata
+        if (name->index != 1) {
+            if (mf.downloadUrl.has_value())
+                mf.downloadUrl = name->shardPath(1);
+            if (auto fileName = parseSplitName(mf.filename))
+                mf.filename = fileName->shardPath(1);
+        }
+        mf.splitCount = name->count;
+        grouped.push_back(std::move(mf));
+    }
+    modelFiles = std::move(grouped);
 }
 
 void ModelFileUtils::sortByPriority(std::vector<ModelFile>& modelFiles) {
@@ -110,70 +91,268 @@ void ModelFileUtils::sortByPriority(std::vector<ModelFile>& modelFiles) {
 }
 
 // ---------- Memory calculation ----------
-static size_t toMB_decimal(size_t bytes) { return bytes / (1000ull * 1000ull); }
+static uint64_t toMB_decimal(uint64_t bytes) { return bytes / (1000ull * 1000ull); }
 
-MemoryUsage ModelFileUtils::calculateMemoryUsage(const ModelFile& modelFile, int contextSize) {
-    MemoryUsage usage;
+#ifndef __EMSCRIPTEN__
+static std::mutex g_cacheMutex;
+static std::shared_ptr<HeaderCache> g_headerCache;
+static std::shared_ptr<ProfileCache> g_profileCache = std::make_shared<ProfileCache>();
 
-    // Need a URL or a local file path (when compiled with FS)
-    if (!modelFile.downloadUrl.has_value() && modelFile.filename.empty()) {
-        return usage;
+void ModelFileUtils::setHeaderCache(std::shared_ptr<HeaderCache> cache) {
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    g_headerCache = std::move(cache);
+}
+
+void ModelFileUtils::setProfileCache(std::shared_ptr<ProfileCache> cache) {
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    g_profileCache = std::move(cache);
+}
+
+std::shared_ptr<ProfileCache> ModelFileUtils::getProfileCache() {
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    return g_profileCache;
+}
+
+static std::shared_ptr<HeaderCache> currentHeaderCache() {
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    return g_headerCache;
+}
+
+// Profile cache key: a URL as is; a local file with its size and mtime, so a
+// file rewritten in place is parsed again rather than served from the cache
+static std::string profileKey(const std::string& path) {
+    if (path.rfind("http://", 0) == 0 || path.rfind("https://", 0) == 0)
+        return path;
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec)
+        return path;            // The load fails too, and failures are not cached
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return path;
+    return path + '\n' + std::to_string(size) + '\n' + std::to_string(mtime.time_since_epoch().count());
+}
+#endif
+
+#ifndef __EMSCRIPTEN__
+using MultiLoopPtr = std::shared_ptr<CurlMultiLoop>;
+#else
+using MultiLoopPtr = std::nullptr_t;
+#endif
+
+// Parsed header for a path or URL; shared through the profile cache on native builds.
+// `shard` reads a gguf-split shard that need not carry the model parameters.
+// `stats` receives the probe's counters, or source "profile-cache" when no header was read.
+static std::shared_ptr<const GGUFModelInfo> loadModelProfile(const std::string& path,
+                                                             MultiLoopPtr loop = nullptr,
+                                                             bool shard = false,
+                                                             ProbeStats* stats = nullptr) {
+    auto load = [&path, &loop, shard, stats]() {
+        GGUFMetadataReader reader;
+#ifndef __EMSCRIPTEN__
+        reader.setHeaderCache(currentHeaderCache());
+        reader.setMultiLoop(loop);
+#else
+        (void)loop;
+#endif
+        return shard ? reader.readShardInfo(path, false, stats) : reader.readModelInfo(path, false, stats);
+    };
+
+#ifndef __EMSCRIPTEN__
+    if (auto cache = ModelFileUtils::getProfileCache()) {
+        auto profile = cache->getOrLoad(profileKey(path), load);
+        // Served from the cache, or by another caller's in-flight load
+        if (profile && stats && stats->files == 0)
+            stats->source = "profile-cache";
+        return profile;
     }
+#endif
+    auto info = load();
+    if (!info.has_value())
+        return nullptr;
+    return std::make_shared<const GGUFModelInfo>(std::move(*info));
+}
 
+// Whole-model profile: a split model is probed from its first shard, then
+// the remaining shards are read concurrently and merged
+static std::shared_ptr<const GGUFModelInfo> loadModelOrSplit(std::string path, MultiLoopPtr loop = nullptr,
+                                                             ProbeStats* stats = nullptr) {
+    auto started = std::chrono::steady_clock::now();
+    auto name = parseSplitName(path);
+    if (name && name->index != 1)
+        path = name->shardPath(1);
+
+    auto first = loadModelProfile(path, loop, false, stats);
+    auto finish = [stats, started]() {
+        if (stats)
+            stats->wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    };
+    if (!first || first->split_count <= 1) {
+        finish();
+        return first;
+    }
+    if (!name || name->count != first->split_count) {
+        std::cerr << "Split model (" << first->split_count << " shards) without a "
+                  << "<name>-00001-of-NNNNN.gguf name: " << path << std::endl;
+        return nullptr;
+    }
+
+    std::vector<GGUFModelInfo> shards(first->split_count);
+    shards[0] = *first;
+    std::vector<ProbeStats> shardStats(name->count - 1);
+#ifndef __EMSCRIPTEN__
+    std::vector<std::future<std::shared_ptr<const GGUFModelInfo>>> pending;
+    for (uint32_t i = 2; i <= name->count; ++i)
+        pending.push_back(std::async(std::launch::async,
+                                     [shardPath = name->shardPath(i), loop, shardStat = &shardStats[i - 2]]() {
+            return loadModelProfile(shardPath, loop, true, shardStat);
+        }));
+    for (size_t i = 0; i < pending.size(); ++i) {
+        auto shard = pending[i].get();
+        if (!shard)
+            return nullptr;
+        shards[i + 1] = *shard;
+    }
+#else
+    for (uint32_t i = 2; i <= name->count; ++i) {
+        auto shard = loadModelProfile(name->shardPath(i), loop, true, &shardStats[i - 2]);
+        if (!shard)
+            return nullptr;
+        shards[i - 1] = *shard;
+    }
+#endif
+    if (stats)
+        for (const ProbeStats& shardStat : shardStats)
+            stats->merge(shardStat);
+    finish();
+    auto merged = mergeSplitInfos(shards);
+    if (!merged) {
+        std::cerr << "Inconsistent shard set: " << path << std::endl;
+        return nullptr;
+    }
+    return std::make_shared<const GGUFModelInfo>(std::move(*merged));
+}
+
+std::shared_ptr<const GGUFModelInfo> ModelFileUtils::loadModelInfo(const ModelFile& modelFile) {
+    if (!modelFile.downloadUrl.has_value() && modelFile.filename.empty())
+        return nullptr;
     try {
-        size_t fileBytes = 0;
-
-        if (modelFile.downloadUrl.has_value()) {
-            fileBytes = getActualFileSizeFromUrl(modelFile.downloadUrl.value());
-        } else {
-            // Local file (available in MEMFS if you wrote it)
-            std::ifstream f(modelFile.filename, std::ios::binary | std::ios::ate);
-            if (f) fileBytes = static_cast<size_t>(f.tellg());
-        }
+        return loadModelOrSplit(modelFile.downloadUrl.value_or(modelFile.filename));
+    } catch (...) {
+        return nullptr;
+    }
+}
 
-        if (fileBytes == 0) {
-            // Fall back to an estimate from GGUF header if we can’t HEAD the file
-            GGUFMetadataReader reader;
-            auto params = modelFile.downloadUrl.has_value()
-                        ? reader.readModelParams(modelFile.downloadUrl.value(), false)
-                        : reader.readModelParams(modelFile.filename, false);
-            if (params) {
-                usage.modelSizeMB = estimateModelSize(*params, modelFile.quant.type);
-            } else {
-                return usage; // No estimate available
-            }
-        } else {
-            usage.modelSizeMB = toMB_decimal(fileBytes);
-        }
+static MemoryEstimateOptions withContextSize(int contextSize) {
+    MemoryEstimateOptions options;
+    options.contextSize = contextSize;
+    return options;
+}
 
-        // Read GGUF metadata for KV calc
-        GGUFMetadataReader reader;
-        auto params = modelFile.downloadUrl.has_value()
-                    ? reader.readModelParams(modelFile.downloadUrl.value(), false)
-                    : reader.readModelParams(modelFile.filename, false);
+static MemoryUsage computeMemoryUsage(const ModelFile& modelFile, const MemoryEstimateOptions& options,
+                                      MultiLoopPtr loop);
 
-        if (!params.has_value()) {
-            return usage; // cannot compute KV
-        }
+MemoryUsage ModelFileUtils::calculateMemoryUsage(const ModelFile& modelFile, int contextSize) {
+    return computeMemoryUsage(modelFile, withContextSize(contextSize), nullptr);
+}
+
+MemoryUsage ModelFileUtils::calculateMemoryUsage(const ModelFile& modelFile, const MemoryEstimateOptions& options) {
+    return computeMemoryUsage(modelFile, options, nullptr);
+}
+
+#ifdef __EMSCRIPTEN__
+// The browser build has no profile cache; sizes seen by header probes are
+// kept here for getActualFileSizeFromUrl
+static std::unordered_map<std::string, uint64_t>& knownFileSizes() {
+    static std::unordered_map<std::string, uint64_t> sizes;
+    return sizes;
+}
+#endif
 
-        // KV cache ~ 4 * hidden_size * hidden_layers * context_size bytes
-        double kvBytes = 4.0 *
-                         static_cast<double>(params->hidden_size) *
-                         static_cast<double>(params->hidden_layers) *
-                         static_cast<double>(contextSize);
+// Fills the size fields of `usage` from a parsed header; no I/O
+static void estimateFromInfo(const ModelFile& modelFile, const GGUFModelInfo& info,
+                             const MemoryEstimateOptions& options, MemoryUsage& usage) {
+    const GGUFModelParams& params = info.params;
+    usage.headerQuant = ModelFileUtils::detectQuantization(info, modelFile.filename);
+
+    if (info.tensorTable.weight_bytes > 0) {
+        usage.modelSizeMB = toMB_decimal(info.tensorTable.weight_bytes);
+
+        MoEProfile moe = profileMoE(info);
+        usage.expertWeightsMB = toMB_decimal(moe.expertBytes);
+        usage.denseWeightsMB = toMB_decimal(moe.denseBytes);
+        usage.activeWeightsMB = toMB_decimal(moe.activeBytes);
+    } else if (info.file_size > 0) {
+        // Header without a tensor table: the size reported with the header bytes
+        usage.modelSizeMB = toMB_decimal(info.file_size);
+    } else {
+        const std::string& quantType = usage.headerQuant.type != "Unknown" ? usage.headerQuant.type
+                                                                          : modelFile.quant.type;
+        usage.modelSizeMB = ModelFileUtils::estimateModelSize(params, quantType);
+    }
+
+    // KV cache per layer from the attention geometry (see kv_cache.h)
+    uint64_t contextSize = static_cast<uint64_t>(std::max(options.contextSize, 0));
+    KVCacheEstimate kv = estimateKVCache(params, contextSize, options.kvCache,
+                                         options.batch.parallel, options.batch.ubatchSize);
+    usage.kvCacheMB = toMB_decimal(kv.bytes);
+
+    ComputeBufferEstimate buffers = estimateComputeBuffers(params, contextSize, options.batch);
+    usage.computeBufferMB = toMB_decimal(buffers.computeBytes);
+    usage.outputBufferMB = toMB_decimal(buffers.outputBytes);
 
-        usage.kvCacheMB = static_cast<size_t>(kvBytes / 1'000'000.0);
+    // Total (you had +20% in comments but added “just sum”; keep sum as you did)
+    usage.totalRequiredMB = usage.modelSizeMB + usage.kvCacheMB +
+                            usage.computeBufferMB + usage.outputBufferMB;
 
-        // Total (you had +20% in comments but added “just sum”; keep sum as you did)
-        usage.totalRequiredMB = usage.modelSizeMB + usage.kvCacheMB;
+    std::ostringstream oss;
+    oss << ModelFileUtils::formatMemorySize(usage.totalRequiredMB)
+        << " (Model: " << ModelFileUtils::formatMemorySize(usage.modelSizeMB)
+        << " + KV: " << ModelFileUtils::formatMemorySize(usage.kvCacheMB)
+        << " + Compute: " << ModelFileUtils::formatMemorySize(usage.computeBufferMB)
+        << " + Output: " << ModelFileUtils::formatMemorySize(usage.outputBufferMB) << ")";
+    usage.displayString = oss.str();
+    usage.hasEstimate = true;
+    usage.isLoading = false;
+}
 
-        std::ostringstream oss;
-        oss << formatMemorySize(usage.totalRequiredMB)
-            << " (Model: " << formatMemorySize(usage.modelSizeMB)
-            << " + KV: " << formatMemorySize(usage.kvCacheMB) << ")";
-        usage.displayString = oss.str();
-        usage.hasEstimate = true;
-        usage.isLoading = false;
+MemoryUsage ModelFileUtils::calculateMemoryUsage(const ModelFile& modelFile, const GGUFModelInfo& info,
+                                                 const MemoryEstimateOptions& options) {
+    MemoryUsage usage;
+    try {
+        estimateFromInfo(modelFile, info, options, usage);
+    } catch (...) {
+        usage = MemoryUsage();
+    }
+    return usage;
+}
+
+static MemoryUsage computeMemoryUsage(const ModelFile& modelFile, const MemoryEstimateOptions& options,
+                                      MultiLoopPtr loop) {
+    MemoryUsage usage;
+
+    // Need a URL or a local file path (when compiled with FS)
+    if (!modelFile.downloadUrl.has_value() && modelFile.filename.empty()) {
+        return usage;
+    }
+
+    try {
+        const std::string& path = modelFile.downloadUrl.has_value()
+                                ? modelFile.downloadUrl.value()
+                                : modelFile.filename;
+
+        // Single probe per file (per shard of a split model): the ranged GETs that carry
+        // the header also report the file size (Content-Range), so there is no HEAD
+        // and no second parse.
+        auto info = loadModelOrSplit(path, loop, &usage.probe);
+        if (!info) {
+            return usage; // cannot compute KV
+        }
+#ifdef __EMSCRIPTEN__
+        if (modelFile.downloadUrl.has_value() && info->file_size > 0)
+            knownFileSizes()[path] = info->file_size;
+#endif
+        estimateFromInfo(modelFile, *info, options, usage);
         return usage;
     } catch (...) {
         return usage;
@@ -182,20 +361,70 @@ MemoryUsage ModelFileUtils::calculateMemoryUsage(const ModelFile& modelFile, int
 
 #ifndef __EMSCRIPTEN__
 // ---------- Native async helpers ----------
-MemoryUsage ModelFileUtils::calculateMemoryUsageAsync(const ModelFile& modelFile, int contextSize) {
+static ThreadPool& probePool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ModelFileUtils::setMaxConcurrentProbes(size_t maxProbes) {
+    probePool().setMaxThreads(maxProbes);
+}
+
+MemoryUsage ModelFileUtils::calculateMemoryUsageAsync(const ModelFile& modelFile, int contextSize,
+                                                      MemoryUsageCallback onComplete) {
+    return calculateMemoryUsageAsync(modelFile, withContextSize(contextSize), std::move(onComplete));
+}
+
+MemoryUsage ModelFileUtils::calculateMemoryUsageAsync(const ModelFile& modelFile, const MemoryEstimateOptions& options,
+                                                      MemoryUsageCallback onComplete) {
     MemoryUsage usage;
     usage.isLoading = true;
     usage.hasEstimate = false;
 
     auto fut = std::make_shared<std::future<MemoryUsage>>(
-        std::async(std::launch::async, [modelFile, contextSize](){
-            return calculateMemoryUsage(modelFile, contextSize);
+        probePool().submit(modelFile.quant.priority, [modelFile, options, onComplete](){
+            MemoryUsage result = calculateMemoryUsage(modelFile, options);
+            if (onComplete) onComplete(result);
+            return result;
         })
     );
     usage.asyncResult = fut;
     return usage;
 }
 
+void ModelFileUtils::calculateMemoryUsageBatch(std::vector<ModelFile>& modelFiles, int contextSize) {
+    calculateMemoryUsageBatch(modelFiles, withContextSize(contextSize));
+}
+
+void ModelFileUtils::calculateMemoryUsageBatch(std::vector<ModelFile>& modelFiles,
+                                               const MemoryEstimateOptions& options,
+                                               BatchResultCallback onEach) {
+    if (modelFiles.empty()) return;
+
+    // One loop for the whole batch: ranges of every file share connections,
+    // DNS answers and TLS sessions instead of each probe handshaking alone
+    auto loop = NetworkContext::instance().sharedLoop();
+
+    std::vector<std::future<MemoryUsage>> results;
+    results.reserve(modelFiles.size());
+    for (size_t i = 0; i < modelFiles.size(); ++i) {
+        const ModelFile& mf = modelFiles[i];
+        results.push_back(probePool().submit(mf.quant.priority, [mf, options, loop, onEach, i](){
+            MemoryUsage result = computeMemoryUsage(mf, options, loop);
+            if (onEach) onEach(i, result);
+            return result;
+        }));
+    }
+
+    for (size_t i = 0; i < modelFiles.size(); ++i) {
+        try {
+            modelFiles[i].memoryUsage = results[i].get();
+        } catch (...) {
+            modelFiles[i].memoryUsage = MemoryUsage();
+        }
+    }
+}
+
 bool ModelFileUtils::updateAsyncMemoryUsage(MemoryUsage& mu) {
     if (!mu.isLoading || !mu.asyncResult) return false;
     if (mu.asyncResult->wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
@@ -221,8 +450,8 @@ bool ModelFileUtils::updateAllAsyncMemoryUsage(std::vector<ModelFile>& modelFile
 #endif
 
 // ---------- Model size estimate from params + quant ----------
-size_t ModelFileUtils::estimateModelSize(const GGUFModelParams& params,
-                                         const std::string& quantType) {
+uint64_t ModelFileUtils::estimateModelSize(const GGUFModelParams& params,
+                                           const std::string& quantType) {
     // Very rough estimate based on your mapping
     uint64_t approx_params =
         static_cast<uint64_t>(params.hidden_size) *
@@ -248,11 +477,11 @@ size_t ModelFileUtils::estimateModelSize(const GGUFModelParams& params,
     if (auto it = quantBits.find(quantType); it != quantBits.end()) bpp = it->second;
 
     long double bytes = static_cast<long double>(approx_params) * (bpp / 8.0L);
-    return static_cast<size_t>(bytes / 1'000'000.0L); // decimal MB
+    return static_cast<uint64_t>(bytes / 1'000'000.0L); // decimal MB
 }
 
 // ---------- Formatting ----------
-std::string ModelFileUtils::formatMemorySize(size_t mb) {
+std::string ModelFileUtils::formatMemorySize(uint64_t mb) {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(1);
     if (mb >= 1000) oss << (mb / 1000.0) << " GB";
@@ -260,12 +489,12 @@ std::string ModelFileUtils::formatMemorySize(size_t mb) {
     return oss.str();
 }
 
-// ---------- HTTP HEAD: getActualFileSizeFromUrl ----------
+// ---------- Remote size: getActualFileSizeFromUrl ----------
 #ifndef __EMSCRIPTEN__
-static size_t curl_head_size(const std::string& url) {
-    size_t out = 0;
-    CURL* curl = curl_easy_init();
-    if (!curl) return 0;
+static uint64_t curl_head_size(const std::string& url) {
+    uint64_t out = 0;
+    CurlHandleLease lease(url);
+    CURL* curl = lease.get();
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
@@ -274,52 +503,67 @@ static size_t curl_head_size(const std::string& url) {
     if (res == CURLE_OK) {
         curl_off_t len = -1;
         if (curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &len) == CURLE_OK) {
-            if (len > 0) out = static_cast<size_t>(len);
+            if (len > 0) out = static_cast<uint64_t>(len);
         }
     }
-    curl_easy_cleanup(curl);
     return out;
 }
+
+// Size reported with an earlier probe's header ranges, 0 if none
+static uint64_t knownFileSize(const std::string& url) {
+    if (auto cache = ModelFileUtils::getProfileCache())
+        if (auto profile = cache->peek(url))
+            return profile->file_size;
+    return 0;
+}
 #else
-// Async JS: HEAD and read Content-Length (or fall back to GET+arrayBuffer length if needed)
-EM_ASYNC_JS(int, wasm_head_size, (const char* url), {
+static uint64_t knownFileSize(const std::string& url) {
+    auto it = knownFileSizes().find(url);
+    return it != knownFileSizes().end() ? it->second : 0;
+}
+
+#ifdef GGUF_WASM_ASYNC_FETCH
+// Whole-file size without downloading the file: a one-byte range reports it
+// in Content-Range, and the body is aborted so a server that ignores Range
+// cannot stream the model into memory. HEAD is the fallback. Returned as a
+// double (exact up to 2^53) so sizes past 2 GB survive; 0 if unknown.
+EM_ASYNC_JS(double, wasm_remote_size, (const char* url), {
   const u = UTF8ToString(url);
+  const positive = (v) => { const n = Number(v); return Number.isFinite(n) && n > 0 ? n : 0; };
+  const controller = new AbortController();
   try {
-    // Try HEAD first
-    let resp = await fetch(u, { method: 'HEAD' });
-    if (!resp.ok && resp.status !== 405) { // some CDNs block HEAD
-      // try GET but only read headers quickly (we will not stream the body fully)
-      resp = await fetch(u, { method: 'GET' });
-    }
-    if (!resp.ok) return 0;
-    const cl = resp.headers.get('content-length');
-    if (cl) {
-      // Cap to 2^31-1 to fit int, return in bytes
-      let n = Number(cl);
-      if (!Number.isFinite(n) || n < 0) return 0;
-      if (n > 0x7fffffff) n = 0x7fffffff;
-      return n | 0;
-    }
-    // If no content-length, last resort: for GET we can read arrayBuffer length (may download!)
-    if (resp.body && resp.headers.get('accept-ranges') !== 'bytes') {
-      const ab = await resp.arrayBuffer();
-      let n = ab.byteLength;
-      if (n > 0x7fffffff) n = 0x7fffffff;
-      return n | 0;
-    }
-    return 0;
+    const resp = await fetch(u, { headers: { 'Range': 'bytes=0-0' }, signal: controller.signal });
+    const cr = resp.headers.get('content-range');
+    const m = cr ? cr.match(/\/(\d+)\s*$/) : null;
+    let n = 0;
+    if (resp.status === 206 && m) n = positive(m[1]);
+    else if (resp.status === 200) n = positive(resp.headers.get('content-length'));
+    controller.abort();
+    if (n > 0) return n;
   } catch (e) {
-    return 0;
+    controller.abort();
   }
+  try {
+    const head = await fetch(u, { method: 'HEAD' });
+    if (head.ok) return positive(head.headers.get('content-length'));
+  } catch (e) {
+  }
+  return 0;
 });
 #endif
+#endif
 
-size_t ModelFileUtils::getActualFileSizeFromUrl(const std::string& url) {
+uint64_t ModelFileUtils::getActualFileSizeFromUrl(const std::string& url) {
+    if (uint64_t known = knownFileSize(url))
+        return known;
 #ifndef __EMSCRIPTEN__
     return curl_head_size(url);
+#elif defined(GGUF_WASM_ASYNC_FETCH)
+    double n = wasm_remote_size(url.c_str());
+    return n > 0 ? static_cast<uint64_t>(n) : 0;
 #else
-    int n = wasm_head_size(url.c_str());
-    return n > 0 ? static_cast<size_t>(n) : 0;
+    // Without async fetch the size comes with the pushed header ranges (GGUFPushParser::totalSize)
+    return 0;
 #endif
 }
 
@@ -329,13 +573,63 @@ static emscripten::val toJS(const MemoryUsage& u) {
     emscripten::val o = emscripten::val::object();
     o.set("modelSizeMB",     emscripten::val((double)u.modelSizeMB));
     o.set("kvCacheMB",       emscripten::val((double)u.kvCacheMB));
+    o.set("computeBufferMB", emscripten::val((double)u.computeBufferMB));
+    o.set("outputBufferMB",  emscripten::val((double)u.outputBufferMB));
+    o.set("expertWeightsMB", emscripten::val((double)u.expertWeightsMB));
+    o.set("denseWeightsMB",  emscripten::val((double)u.denseWeightsMB));
+    o.set("activeWeightsMB", emscripten::val((double)u.activeWeightsMB));
     o.set("totalRequiredMB", emscripten::val((double)u.totalRequiredMB));
+    o.set("headerQuant",     emscripten::val(u.headerQuant.type));
+    o.set("headerQuantDescription", emscripten::val(u.headerQuant.description));
     o.set("displayString",   emscripten::val(u.displayString));
     o.set("hasEstimate",     emscripten::val(u.hasEstimate));
     o.set("isLoading",       emscripten::val(u.isLoading));
+
+    const ProbeStats& p = u.probe;
+    emscripten::val probe = emscripten::val::object();
+    emscripten::val requestMs = emscripten::val::array();
+    for (size_t i = 0; i < p.requestMs.size(); ++i)
+        requestMs.set(i, emscripten::val(p.requestMs[i]));
+    probe.set("source",            emscripten::val(p.source));
+    probe.set("bytesRequested",    emscripten::val((double)p.bytesRequested));
+    probe.set("bytesReceived",     emscripten::val((double)p.bytesReceived));
+    probe.set("bytesUsed",         emscripten::val((double)p.bytesUsed));
+    probe.set("requests",          emscripten::val(p.requests));
+    probe.set("discardingSeeks",   emscripten::val(p.discardingSeeks));
+    probe.set("timeToFirstByteMs", emscripten::val(p.timeToFirstByteMs));
+    probe.set("requestMs",         requestMs);
+    probe.set("parseCpuMs",        emscripten::val(p.parseCpuMs));
+    probe.set("wallMs",            emscripten::val(p.wallMs));
+    probe.set("keyCount",          emscripten::val((double)p.keyCount));
+    probe.set("keysScanned",       emscripten::val((double)p.keysScanned));
+    probe.set("stoppedEarly",      emscripten::val(p.stoppedEarly));
+    probe.set("stopKey",           emscripten::val(p.stopKey));
+    probe.set("files",             emscripten::val(p.files));
+    o.set("probe", probe);
+    return o;
+}
+
+emscripten::val calcMemoryFromHeader(const GGUFPushParser& parser,
+                                     const std::string& modelId,
+                                     const std::string& filename,
+                                     int contextSize) {
+    if (parser.state() != GGUFPushParser::State::Done)
+        return toJS(MemoryUsage());
+    ModelFile mf;
+    mf.modelId = modelId;
+    mf.filename = filename;
+    mf.quant = ModelFileUtils::detectQuantization(filename);
+    MemoryEstimateOptions options;
+    options.contextSize = contextSize;
+    mf.memoryUsage = ModelFileUtils::calculateMemoryUsage(mf, parser.info(), options);
+    mf.memoryUsage.probe = parser.stats();
+    emscripten::val o = toJS(mf.memoryUsage);
+    // From the Content-Range of the header fetches, so no separate size request
+    o.set("fileSizeBytes", emscripten::val((double)parser.totalSize()));
     return o;
 }
 
+#ifdef GGUF_WASM_ASYNC_FETCH
 emscripten::val calcMemoryFromUrl(const std::string& modelId,
                                   const std::string& filename,
                                   const std::string& url,
@@ -349,6 +643,12 @@ emscripten::val calcMemoryFromUrl(const std::string& modelId,
     return toJS(mf.memoryUsage);
 }
 
+// Bytes as a double: exact up to 2^53, unlike a wasm32 size_t
+double fileSizeFromUrl(const std::string& url) {
+    return static_cast<double>(ModelFileUtils::getActualFileSizeFromUrl(url));
+}
+#endif
+
 emscripten::val calcMemoryFromFile(const std::string& modelId,
                                    const std::string& filename,
                                    const std::string& path,
@@ -363,7 +663,11 @@ emscripten::val calcMemoryFromFile(const std::string& modelId,
 
 
 EMSCRIPTEN_BINDINGS(model_file_bindings) {
-    emscripten::function("calcMemoryFromUrl",  &calcMemoryFromUrl);
-    emscripten::function("calcMemoryFromFile", &calcMemoryFromFile);
+    emscripten::function("calcMemoryFromHeader", &calcMemoryFromHeader);
+#ifdef GGUF_WASM_ASYNC_FETCH
+    emscripten::function("calcMemoryFromUrl",    &calcMemoryFromUrl);
+    emscripten::function("fileSizeFromUrl",      &fileSizeFromUrl);
+#endif
+    emscripten::function("calcMemoryFromFile",   &calcMemoryFromFile);
 }
 #endif
@@ -5,28 +5,50 @@
 #include <vector>
 #include <optional>
 #include <memory>
+#include <functional>
 #include "gguf_reader.h"
+#include "gguf_push_parser.h"
+#include "kv_cache.h"
+#include "compute_buffer.h"
+#include "offload_planner.h"
+#include "moe_profile.h"
+#include "gguf_split.h"
+#include "quantization.h"
+#include "header_cache.h"
+#include "profile_cache.h"
+#include "thread_pool.h"
+#include "curl_multi_loop.h"
+#include "network_context.h"
 
 #ifdef __EMSCRIPTEN__
   #include <emscripten/bind.h>
+#else
+  #include <future>
 #endif
 
 /**
- * @brief Information about quantization type and quality
+ * @brief Runtime settings a memory estimate depends on
  */
-struct QuantizationInfo {
-    std::string type;         ///< Quantization type (e.g., "Q8_0", "Q4_K_M")
-    std::string description;  ///< Human-readable description
-    int priority = 9999;      ///< Priority for default selection (lower = higher priority)
+struct MemoryEstimateOptions {
+    int contextSize = 4096;       ///< Context length in tokens
+    KVCacheOptions kvCache;       ///< K/V cache storage types (default F16)
+    BatchOptions batch;           ///< Batch, micro-batch and parallel sequences (n_parallel multiplies KV)
 };
 
 /**
  * @brief Memory usage estimation for a model
  */
 struct MemoryUsage {
-    size_t modelSizeMB = 0;       ///< Model size in MB (decimal MB: 1e6 bytes)
-    size_t kvCacheMB = 0;         ///< KV cache size in MB (decimal)
-    size_t totalRequiredMB = 0;   ///< Total required memory in MB (decimal)
+    uint64_t modelSizeMB = 0;     ///< Model size in MB (decimal MB: 1e6 bytes)
+    uint64_t kvCacheMB = 0;       ///< KV cache size in MB (decimal)
+    uint64_t computeBufferMB = 0; ///< Compute/scratch buffer for one micro-batch in MB (decimal)
+    uint64_t outputBufferMB = 0;  ///< Logits output buffer in MB (decimal)
+    uint64_t expertWeightsMB = 0; ///< Routed expert weights in MB (decimal; 0 for dense models)
+    uint64_t denseWeightsMB = 0;  ///< Non-expert weights incl. shared experts in MB (decimal)
+    uint64_t activeWeightsMB = 0; ///< Weights read per token in MB (decimal; see MoEProfile)
+    uint64_t totalRequiredMB = 0; ///< Total required memory in MB (decimal)
+    QuantizationInfo headerQuant; ///< Quantization read from the header (empty type until loaded)
+    ProbeStats probe;             ///< Bytes, requests and time of the header probe behind this estimate
     std::string displayString;    ///< Formatted display string
     bool hasEstimate = false;     ///< Whether we have valid estimates
     bool isLoading = false;       ///< Whether memory calculation is in progress
@@ -46,31 +68,92 @@ struct ModelFile {
     QuantizationInfo quant;               ///< Quantization info
     std::optional<std::string> downloadUrl; ///< URL (if any)
     MemoryUsage memoryUsage;              ///< Memory usage estimation
+    uint32_t splitCount = 1;              ///< gguf-split shards; filename/downloadUrl name the first
 
     std::string getDisplayName() const;
     std::string getDisplayNameWithMemory() const;
     bool updateDisplayIfReady();
 };
 
+/**
+ * @brief Called with the finished estimate of an async calculation
+ *        (on the worker thread in native builds)
+ */
+using MemoryUsageCallback = std::function<void(const MemoryUsage&)>;
+
+/**
+ * @brief Called for each file of a batch as soon as its estimate is done,
+ *        with the file's index in the batch (on a probe worker thread)
+ */
+using BatchResultCallback = std::function<void(size_t index, const MemoryUsage&)>;
+
 /**
  * @brief Utility class for model file operations
  */
 class ModelFileUtils {
 public:
     static QuantizationInfo detectQuantization(const std::string& filename);
+
+    /**
+     * @brief Quantization from a parsed header: general.file_type, refined by
+     *        the filename (UD-, _XL), else the tensor type mix
+     */
+    static QuantizationInfo detectQuantization(const GGUFModelInfo& info, const std::string& filename);
     static void sortByPriority(std::vector<ModelFile>& modelFiles);
 
+    /**
+     * @brief Collapse "<name>-00001-of-00005.gguf" shard sets into one entry
+     *        pointing at the first shard (order of first appearance is kept)
+     *
+     * Memory estimates of such an entry probe every shard concurrently and
+     * cover the whole model; shards are also recognized from split.count
+     * when an entry is estimated without grouping.
+     */
+    static void groupShards(std::vector<ModelFile>& modelFiles);
+
     /**
      * @brief Calculate memory usage estimation for a model file
      *        (sync; safe for WASM)
      */
     static MemoryUsage calculateMemoryUsage(const ModelFile& modelFile, int contextSize = 4096);
+    static MemoryUsage calculateMemoryUsage(const ModelFile& modelFile, const MemoryEstimateOptions& options);
+
+    /**
+     * @brief Memory usage from a header parsed elsewhere (e.g. a GGUFPushParser
+     *        fed by the page); no I/O. The probe field is left empty.
+     */
+    static MemoryUsage calculateMemoryUsage(const ModelFile& modelFile, const GGUFModelInfo& info,
+                                            const MemoryEstimateOptions& options);
 
 #ifndef __EMSCRIPTEN__
     /**
      * @brief Start async memory usage calculation (native only by default)
+     *
+     * Runs on a bounded probe pool; files with a lower quant priority (the
+     * default quant after sortByPriority) are probed first. `onComplete`, if
+     * set, is invoked with the result so callers need not poll.
+     */
+    static MemoryUsage calculateMemoryUsageAsync(const ModelFile& modelFile, int contextSize = 4096,
+                                                 MemoryUsageCallback onComplete = nullptr);
+    static MemoryUsage calculateMemoryUsageAsync(const ModelFile& modelFile, const MemoryEstimateOptions& options,
+                                                 MemoryUsageCallback onComplete = nullptr);
+
+    /**
+     * @brief Calculate memory usage for many files at once (native, blocking)
+     *
+     * All probes share one curl multi loop with a shared DNS, TLS session
+     * and connection cache, so files on the same host reuse warm
+     * connections. Results are stored in each file's memoryUsage. Do not
+     * call from an onComplete callback: it waits on the probe pool.
      */
-    static MemoryUsage calculateMemoryUsageAsync(const ModelFile& modelFile, int contextSize = 4096);
+    static void calculateMemoryUsageBatch(std::vector<ModelFile>& modelFiles, int contextSize = 4096);
+    static void calculateMemoryUsageBatch(std::vector<ModelFile>& modelFiles, const MemoryEstimateOptions& options,
+                                          BatchResultCallback onEach = nullptr);
+
+    /**
+     * @brief Limit how many probes run at once (native; default 8)
+     */
+    static void setMaxConcurrentProbes(size_t maxProbes);
 
     /**
      * @brief Update memory usage if async calculation is complete (native)
@@ -81,37 +164,81 @@ public:
      * @brief Update memory usage for all model files (native)
      */
     static bool updateAllAsyncMemoryUsage(std::vector<ModelFile>& modelFiles);
+
+    /**
+     * @brief Use an on-disk GGUF header cache for URL probes (native; nullptr disables)
+     */
+    static void setHeaderCache(std::shared_ptr<HeaderCache> cache);
+
+    /**
+     * @brief Replace the in-process profile cache (native; nullptr disables).
+     *        On by default, so repeat and concurrent probes of a file share one parse.
+     *        Local files are keyed by path, size and mtime; URLs by the URL alone.
+     */
+    static void setProfileCache(std::shared_ptr<ProfileCache> cache);
+    static std::shared_ptr<ProfileCache> getProfileCache();
 #else
     // In WASM we keep the same signatures available but implement them as sync fallbacks.
-    static MemoryUsage calculateMemoryUsageAsync(const ModelFile& modelFile, int contextSize = 4096) {
+    static MemoryUsage calculateMemoryUsageAsync(const ModelFile& modelFile, int contextSize = 4096,
+                                                 MemoryUsageCallback onComplete = nullptr) {
+        MemoryEstimateOptions options;
+        options.contextSize = contextSize;
+        return calculateMemoryUsageAsync(modelFile, options, std::move(onComplete));
+    }
+    static MemoryUsage calculateMemoryUsageAsync(const ModelFile& modelFile, const MemoryEstimateOptions& options,
+                                                 MemoryUsageCallback onComplete = nullptr) {
         // For browsers (no pthreads by default), do it synchronously.
-        MemoryUsage u = calculateMemoryUsage(modelFile, contextSize);
+        MemoryUsage u = calculateMemoryUsage(modelFile, options);
         u.isLoading = false;
+        if (onComplete) onComplete(u);
         return u;
     }
     static bool updateAsyncMemoryUsage(MemoryUsage&) { return false; }
     static bool updateAllAsyncMemoryUsage(std::vector<ModelFile>&) { return false; }
 #endif
 
-    static size_t estimateModelSize(const GGUFModelParams& params, const std::string& quantType);
-    static std::string formatMemorySize(size_t sizeInMB);
+    /**
+     * @brief Parsed header (params and tensor table) of a file or URL, shared
+     *        through the profile cache on native builds; feed it to an
+     *        OffloadPlanner for per-device placement
+     * @return nullptr if the header cannot be read
+     */
+    static std::shared_ptr<const GGUFModelInfo> loadModelInfo(const ModelFile& modelFile);
+
+    static uint64_t estimateModelSize(const GGUFModelParams& params, const std::string& quantType);
+    static std::string formatMemorySize(uint64_t sizeInMB);
 
     /**
-     * @brief Get actual file size from URL using HTTP HEAD
-     * @return File size in bytes, or 0 if unknown
+     * @brief Whole-file size of a URL: the size an earlier header probe saw
+     *        in Content-Range, else HTTP HEAD (native) or a one-byte range
+     *        with the body aborted (GGUF_WASM_ASYNC_FETCH builds)
+     * @return File size in bytes (64-bit on every target), or 0 if unknown
      */
-    static size_t getActualFileSizeFromUrl(const std::string& url);
+    static uint64_t getActualFileSizeFromUrl(const std::string& url);
 
     // The interactive / cache utilities are omitted for WASM (terminal/extern deps).
 };
 
 #ifdef __EMSCRIPTEN__
 // Embind helpers so JS can call directly.
+
+// Estimate from a header the page fetched into a GGUFPushParser (state Done)
+emscripten::val calcMemoryFromHeader(const GGUFPushParser& parser,
+                                     const std::string& modelId,
+                                     const std::string& filename,
+                                     int contextSize);
+
+#ifdef GGUF_WASM_ASYNC_FETCH
+// Fetches the header itself; needs a -sJSPI or -sASYNCIFY build
 emscripten::val calcMemoryFromUrl(const std::string& modelId,
                                   const std::string& filename,
                                   const std::string& url,
                                   int contextSize);
 
+// getActualFileSizeFromUrl in bytes, as a double so sizes past 2 GB survive
+double fileSizeFromUrl(const std::string& url);
+#endif
+
 emscripten::val calcMemoryFromFile(const std::string& modelId,
                                    const std::string& filename,
                                    const std::string& path,
@@ -0,0 +1,95 @@
+#include "moe_profile.h"
+
+namespace {
+
+bool startsWith(std::string_view str, std::string_view prefix) {
+    return str.substr(0, prefix.size()) == prefix;
+}
+
+// "blk.<n>.<rest>" -> rest
+std::string_view blockLocalName(std::string_view name) {
+    if (!startsWith(name, "blk."))
+        return name;
+    size_t dot = name.find('.', 4);
+    return dot == std::string_view::npos ? name : name.substr(dot + 1);
+}
+
+} // namespace
+
+MoETensorRole moeTensorRole(std::string_view name) {
+    std::string_view local = blockLocalName(name);
+    if (!startsWith(local, "ffn_"))
+        return MoETensorRole::Dense;
+
+    // ffn_gate_exps, ffn_up_exps, ffn_down_exps, ffn_gate_up_exps (+ .weight/.bias/.scale)
+    std::string_view base = local.substr(0, local.find('.'));
+    if (base.size() > 5 && base.substr(base.size() - 5) == "_exps")
+        return MoETensorRole::Expert;
+    if (base.size() > 6 && base.substr(base.size() - 6) == "_shexp")
+        return MoETensorRole::SharedExpert;
+
+    // Pre-merge layout: one tensor per expert, "ffn_gate.<e>.weight"
+    for (std::string_view proj : {"ffn_gate.", "ffn_up.", "ffn_down."}) {
+        if (startsWith(local, proj)) {
+            std::string_view rest = local.substr(proj.size());
+            if (!rest.empty() && rest[0] >= '0' && rest[0] <= '9')
+                return MoETensorRole::Expert;
+        }
+    }
+    return MoETensorRole::Dense;
+}
+
+MoEProfile profileMoE(const GGUFModelInfo& info) {
+    const GGUFModelParams& params = info.params;
+    MoEProfile profile;
+    profile.expertCount = params.expert_count;
+    profile.expertUsedCount = params.expert_used_count;
+    profile.sharedExpertCount = params.expert_shared_count;
+    profile.layerExpertBytes.assign(params.hidden_layers, 0);
+
+    uint64_t embeddingBytes = 0;
+    uint32_t expertDim = 0;
+    for (const auto& tensor : info.tensorTable.tensors) {
+        switch (moeTensorRole(tensor.name)) {
+        case MoETensorRole::Expert: {
+            profile.expertBytes += tensor.size_bytes;
+            // Merged experts are [n_embd, n_ff, n_expert] (or [n_ff, n_expert] for biases)
+            if (tensor.n_dims >= 2 && tensor.name.find("_exps.") != std::string::npos)
+                expertDim = std::max(expertDim, static_cast<uint32_t>(tensor.dims[tensor.n_dims - 1]));
+            uint32_t il = 0;
+            std::string_view name = tensor.name;
+            if (startsWith(name, "blk.")) {
+                for (size_t i = 4; i < name.size() && name[i] >= '0' && name[i] <= '9'; ++i)
+                    il = il * 10 + static_cast<uint32_t>(name[i] - '0');
+                if (il < profile.layerExpertBytes.size())
+                    profile.layerExpertBytes[il] += tensor.size_bytes;
+            }
+            break;
+        }
+        case MoETensorRole::SharedExpert:
+            profile.sharedExpertBytes += tensor.size_bytes;
+            profile.denseBytes += tensor.size_bytes;
+            break;
+        case MoETensorRole::Dense:
+            profile.denseBytes += tensor.size_bytes;
+            if (tensor.name == "token_embd.weight")
+                embeddingBytes = tensor.size_bytes;
+            break;
+        }
+    }
+
+    if (profile.expertCount == 0 && profile.isMoE())
+        profile.expertCount = expertDim;
+
+    // Only one row of the embedding table is read per token
+    profile.activeBytes = profile.denseBytes - embeddingBytes;
+    if (profile.isMoE()) {
+        uint64_t used = profile.expertUsedCount;
+        uint64_t count = profile.expertCount;
+        if (count == 0 || used == 0 || used > count)
+            profile.activeBytes += profile.expertBytes;     // Unknown routing: count every expert
+        else
+            profile.activeBytes += profile.expertBytes / count * used;
+    }
+    return profile;
+}
@@ -0,0 +1,38 @@
+#ifndef MOE_PROFILE_H
+#define MOE_PROFILE_H
+
+#include "gguf_reader.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+enum class MoETensorRole {
+    Dense,          // Attention, norms, router, dense FFN, embeddings
+    Expert,         // Routed expert FFN (ffn_*_exps, or old per-expert ffn_*.<e>)
+    SharedExpert,   // Always-active shared expert FFN (ffn_*_shexp)
+};
+
+MoETensorRole moeTensorRole(std::string_view name);
+
+// Weight bytes of a GGUF split by role. For a dense model every byte is
+// dense and active equals dense minus the token embedding table.
+struct MoEProfile {
+    uint32_t expertCount = 0;       // Routed experts per MoE block
+    uint32_t expertUsedCount = 0;   // Routed experts active per token
+    uint32_t sharedExpertCount = 0;
+
+    uint64_t expertBytes = 0;       // All routed expert tensors
+    uint64_t sharedExpertBytes = 0; // Shared expert tensors (also part of denseBytes)
+    uint64_t denseBytes = 0;        // Everything that is not a routed expert
+    uint64_t activeBytes = 0;       // Read per token: dense minus token_embd, plus used/count of the experts
+    std::vector<uint64_t> layerExpertBytes;     // Routed expert bytes per block
+
+    bool isMoE() const { return expertBytes > 0; }
+};
+
+// From the tensor table (readModelInfo). Expert counts come from the header,
+// else from the expert dimension of the merged expert tensors.
+MoEProfile profileMoE(const GGUFModelInfo& info);
+
+#endif // MOE_PROFILE_H
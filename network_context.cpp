@@ -0,0 +1,118 @@
+#include "network_context.h"
+
+#ifndef __EMSCRIPTEN__
+
+#include "curl_multi_loop.h"
+
+#include <cctype>
+#include <stdexcept>
+
+NetworkContext::NetworkContext() {
+    if (curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK)
+        throw std::runtime_error("Failed to initialize libcurl");
+
+    shareHandle = curl_share_init();
+    if (!shareHandle)
+        throw std::runtime_error("Failed to initialize curl share");
+    curl_share_setopt(shareHandle, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(shareHandle, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(shareHandle, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // Not CURL_LOCK_DATA_CONNECT: libcurl does not support one connection cache
+    // used from concurrent threads, and probes run on many
+}
+
+NetworkContext& NetworkContext::instance() {
+    // Intentionally leaked: probe threads may still hold handles during static destruction
+    static NetworkContext* context = new NetworkContext();
+    return *context;
+}
+
+CURL* NetworkContext::acquire(const std::string& url) {
+    CURL* easy = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = idle.find(hostKey(url));
+        if (it != idle.end() && !it->second.empty()) {
+            easy = it->second.back();
+            it->second.pop_back();
+        }
+    }
+    if (!easy) {
+        easy = curl_easy_init();
+        if (!easy)
+            throw std::runtime_error("Failed to initialize curl");
+    }
+    curl_easy_setopt(easy, CURLOPT_SHARE, shareHandle);
+    return easy;
+}
+
+void NetworkContext::release(const std::string& url, CURL* easy) {
+    if (!easy)
+        return;
+    // Options and callbacks of the last borrower must not leak to the next one
+    curl_easy_reset(easy);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<CURL*>& handles = idle[hostKey(url)];
+        if (handles.size() < maxIdlePerHost) {
+            handles.push_back(easy);
+            return;
+        }
+    }
+    curl_easy_cleanup(easy);
+}
+
+std::shared_ptr<CurlMultiLoop> NetworkContext::sharedLoop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loop)
+        loop = std::make_shared<CurlMultiLoop>();
+    return loop;
+}
+
+void NetworkContext::setMaxIdlePerHost(size_t maxIdle) {
+    std::vector<CURL*> surplus;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxIdlePerHost = maxIdle;
+        for (auto& [host, handles] : idle) {
+            while (handles.size() > maxIdlePerHost) {
+                surplus.push_back(handles.back());
+                handles.pop_back();
+            }
+        }
+    }
+    for (CURL* easy : surplus)
+        curl_easy_cleanup(easy);
+}
+
+size_t NetworkContext::idleHandles() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& [host, handles] : idle)
+        count += handles.size();
+    return count;
+}
+
+// "https://Host:443/path" -> "https://host:443"; the path and query do not affect connection reuse
+std::string NetworkContext::hostKey(const std::string& url) {
+    size_t scheme = url.find("://");
+    size_t start = scheme == std::string::npos ? 0 : scheme + 3;
+    size_t end = url.find_first_of("/?#", start);
+    std::string key = url.substr(0, end);
+    for (size_t i = 0; i < key.size(); ++i)
+        key[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(key[i])));
+    return key;
+}
+
+void NetworkContext::lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<NetworkContext*>(userptr)->shareLocks[data].lock();
+}
+
+void NetworkContext::unlockShare(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<NetworkContext*>(userptr)->shareLocks[data].unlock();
+}
+
+#endif // __EMSCRIPTEN__
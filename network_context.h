@@ -0,0 +1,79 @@
+#ifndef NETWORK_CONTEXT_H
+#define NETWORK_CONTEXT_H
+
+#ifndef __EMSCRIPTEN__
+
+#include <curl/curl.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CurlMultiLoop;
+
+// Process-wide libcurl state. curl_global_init runs exactly once, on first
+// use (thread-safe), and is never undone: cleanup while other threads may
+// still be probing is what made per-reader init/cleanup unsafe.
+//
+// Every handle it lends is attached to one share object for DNS answers and
+// TLS sessions. Idle handles are pooled per scheme://host:port and keep their
+// own open connections across curl_easy_reset, so a request to a host that
+// was probed before usually skips DNS, TCP and the full TLS handshake.
+class NetworkContext {
+public:
+    static NetworkContext& instance();
+
+    NetworkContext(const NetworkContext&) = delete;
+    NetworkContext& operator=(const NetworkContext&) = delete;
+
+    // Handle for `url`'s host, with default options plus the shared caches; never nullptr
+    CURL* acquire(const std::string& url);
+    // Returns a handle to the pool (or frees it when the host's pool is full)
+    void release(const std::string& url, CURL* easy);
+
+    CURLSH* share() const { return shareHandle; }
+
+    // Event loop shared by batch probes, created on first use
+    std::shared_ptr<CurlMultiLoop> sharedLoop();
+
+    void setMaxIdlePerHost(size_t maxIdle);
+    size_t idleHandles() const;
+
+private:
+    NetworkContext();
+
+    static std::string hostKey(const std::string& url);
+    static void lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr);
+    static void unlockShare(CURL*, curl_lock_data data, void* userptr);
+
+    CURLSH* shareHandle = nullptr;
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::vector<CURL*>> idle;
+    size_t maxIdlePerHost = 8;
+    std::shared_ptr<CurlMultiLoop> loop;
+};
+
+// Scoped loan of a pooled handle
+class CurlHandleLease {
+public:
+    explicit CurlHandleLease(std::string url)
+        : url(std::move(url)), easy(NetworkContext::instance().acquire(this->url)) {}
+    ~CurlHandleLease() { NetworkContext::instance().release(url, easy); }
+
+    CurlHandleLease(const CurlHandleLease&) = delete;
+    CurlHandleLease& operator=(const CurlHandleLease&) = delete;
+
+    CURL* get() const { return easy; }
+
+private:
+    std::string url;
+    CURL* easy;
+};
+
+#endif // __EMSCRIPTEN__
+
+#endif // NETWORK_CONTEXT_H
@@ -0,0 +1,186 @@
+#include "offload_planner.h"
+#include "moe_profile.h"
+
+namespace {
+
+// "blk.<n>.<...>" -> n
+bool blockIndex(const std::string& name, uint32_t& index) {
+    static constexpr std::string_view PREFIX = "blk.";
+    if (name.compare(0, PREFIX.size(), PREFIX) != 0)
+        return false;
+    size_t pos = PREFIX.size();
+    uint64_t value = 0;
+    size_t digits = 0;
+    while (pos < name.size() && name[pos] >= '0' && name[pos] <= '9' && digits < 10) {
+        value = value * 10 + static_cast<uint64_t>(name[pos] - '0');
+        ++pos;
+        ++digits;
+    }
+    if (digits == 0 || pos >= name.size() || name[pos] != '.' || value > UINT32_MAX)
+        return false;
+    index = static_cast<uint32_t>(value);
+    return true;
+}
+
+} // namespace
+
+bool OffloadPlan::fits() const {
+    for (const auto& device : devices)
+        if (!device.fits())
+            return false;
+    return host.fits();
+}
+
+OffloadPlanner::OffloadPlanner(const GGUFModelInfo& info, uint64_t contextSize,
+                               const KVCacheOptions& kvCache, const BatchOptions& batch) {
+    const GGUFModelParams& params = info.params;
+    layerWeights.assign(params.hidden_layers, 0);
+    layerExperts.assign(params.hidden_layers, 0);
+
+    bool hasOutputWeight = false;
+    uint64_t embeddingBytes = 0;
+    for (const auto& tensor : info.tensorTable.tensors) {
+        uint32_t il;
+        if (blockIndex(tensor.name, il) && il < params.hidden_layers) {
+            bool expert = moeTensorRole(tensor.name) == MoETensorRole::Expert;
+            (expert ? layerExperts : layerWeights)[il] += tensor.size_bytes;
+        } else if (tensor.name.compare(0, 10, "token_embd") == 0) {
+            inputBytes += tensor.size_bytes;
+            if (tensor.name == "token_embd.weight")
+                embeddingBytes = tensor.size_bytes;
+        } else {
+            outputBytes += tensor.size_bytes;
+            hasOutputWeight |= tensor.name == "output.weight";
+        }
+    }
+    // Tied embeddings: llama.cpp loads token_embd a second time for the output layer
+    if (!hasOutputWeight)
+        tiedOutputBytes = embeddingBytes;
+
+    KVCacheEstimate kv = estimateKVCache(params, contextSize, kvCache, batch.parallel, batch.ubatchSize);
+    layerKV = std::move(kv.layerBytes);
+    layerKV.resize(params.hidden_layers, 0);
+
+    ComputeBufferEstimate buffers = estimateComputeBuffers(params, contextSize, batch);
+    computeBytes = buffers.computeBytes;
+    outputBufferBytes = buffers.outputBytes;
+}
+
+uint64_t OffloadPlanner::itemBytes(uint32_t i) const {
+    if (i < blockCount())
+        return layerWeights[i] + layerKV[i] + (i < hostExpertBlocks ? 0 : layerExperts[i]);
+    return outputBytes + tiedOutputBytes;
+}
+
+OffloadPlan OffloadPlanner::plan(uint32_t gpuLayers, const std::vector<OffloadDevice>& devices,
+                                 std::vector<float> tensorSplit) const {
+    const uint32_t n = blockCount();
+    if (devices.empty())
+        gpuLayers = 0;
+    gpuLayers = std::min(gpuLayers, n + 1);
+
+    if (tensorSplit.empty()) {
+        // llama.cpp splits by free memory; without budgets, evenly
+        bool anyBudget = false;
+        for (const auto& device : devices) {
+            tensorSplit.push_back(static_cast<float>(device.budgetBytes));
+            anyBudget |= device.budgetBytes > 0;
+        }
+        if (!anyBudget)
+            std::fill(tensorSplit.begin(), tensorSplit.end(), 1.0f);
+    }
+    if (tensorSplit.size() != devices.size())
+        throw std::invalid_argument("tensorSplit needs one share per device");
+
+    // Cumulative, normalized shares
+    std::vector<double> splits(tensorSplit.size());
+    double total = 0.0;
+    for (size_t d = 0; d < tensorSplit.size(); ++d) {
+        if (tensorSplit[d] < 0.0f)
+            throw std::invalid_argument("tensorSplit shares must not be negative");
+        total += tensorSplit[d];
+        splits[d] = total;
+    }
+    if (gpuLayers > 0 && total <= 0.0)
+        throw std::invalid_argument("tensorSplit has no positive share");
+    for (double& split : splits)
+        split /= total;
+
+    OffloadPlan plan;
+    plan.gpuLayers = gpuLayers;
+    plan.layerSplit.assign(devices.size(), 0);
+    for (const auto& device : devices) {
+        DevicePlacement placement;
+        placement.name = device.name;
+        placement.budgetBytes = device.budgetBytes;
+        plan.devices.push_back(std::move(placement));
+    }
+    plan.host.name = "host";
+    plan.host.outputBytes = inputBytes;
+    plan.host.outputBufferBytes = outputBufferBytes;
+
+    // Item n is the output layer; the last gpuLayers items are offloaded
+    const uint32_t start = n - std::min(gpuLayers, n);
+    for (uint32_t i = 0; i <= n; ++i) {
+        bool offloaded = i >= start && i - start < gpuLayers;
+        DevicePlacement* target = &plan.host;
+        if (offloaded) {
+            double position = static_cast<double>(i - start) / gpuLayers;
+            size_t d = static_cast<size_t>(std::upper_bound(splits.begin(), splits.end(), position) - splits.begin());
+            d = std::min(d, devices.size() - 1);
+            target = &plan.devices[d];
+            ++plan.layerSplit[d];
+        }
+
+        if (i < n) {
+            if (target->layerCount == 0)
+                target->firstLayer = i;
+            ++target->layerCount;
+            target->weightBytes += layerWeights[i];
+            target->kvBytes += layerKV[i];
+            (i < hostExpertBlocks ? plan.host : *target).expertBytes += layerExperts[i];
+        } else {
+            target->hasOutput = true;
+            target->outputBytes += outputBytes + (offloaded ? tiedOutputBytes : 0);
+        }
+    }
+
+    for (auto& device : plan.devices)
+        if (device.layerCount > 0 || device.hasOutput)
+            device.computeBytes = computeBytes;
+    if (plan.host.layerCount > 0 || plan.host.hasOutput)
+        plan.host.computeBytes = computeBytes;
+    return plan;
+}
+
+OffloadPlan OffloadPlanner::planForBudget(const std::vector<OffloadDevice>& devices) const {
+    const uint32_t n = blockCount();
+
+    for (uint32_t gpuLayers = n + 1; gpuLayers > 0; --gpuLayers) {
+        // Fill devices in order with the offloaded items; each device in use
+        // also carries a compute buffer
+        std::vector<float> counts(devices.size(), 0.0f);
+        size_t d = 0;
+        uint64_t used = 0;
+        bool placed = true;
+        for (uint32_t i = n - std::min(gpuLayers, n); i < n + (gpuLayers > n ? 1 : 0); ++i) {
+            uint64_t bytes = itemBytes(i);
+            while (d < devices.size()) {
+                uint64_t overhead = counts[d] == 0.0f ? computeBytes : 0;
+                if (devices[d].budgetBytes > 0 && used + overhead + bytes <= devices[d].budgetBytes)
+                    break;
+                ++d;
+                used = 0;
+            }
+            if (d == devices.size()) {
+                placed = false;
+                break;
+            }
+            used += (counts[d] == 0.0f ? computeBytes : 0) + bytes;
+            counts[d] += 1.0f;
+        }
+        if (placed)
+            return plan(gpuLayers, devices, std::move(counts));
+    }
+    return plan(0, devices);
+}
@@ -0,0 +1,92 @@
+#ifndef OFFLOAD_PLANNER_H
+#define OFFLOAD_PLANNER_H
+
+#include "gguf_reader.h"
+#include "kv_cache.h"
+#include "compute_buffer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One accelerator layers can be placed on
+struct OffloadDevice {
+    std::string name;
+    uint64_t budgetBytes = 0;       // Usable memory; 0: unchecked by plan(), skipped by planForBudget()
+};
+
+// What one device (or host RAM) holds under a plan
+struct DevicePlacement {
+    std::string name;
+    uint64_t budgetBytes = 0;
+    uint32_t firstLayer = 0;        // Blocks [firstLayer, firstLayer + layerCount)
+    uint32_t layerCount = 0;
+    bool hasOutput = false;         // output / output_norm (the n_gpu_layers = block_count + 1 layer)
+    uint64_t weightBytes = 0;       // blk.N.* tensors other than routed experts
+    uint64_t expertBytes = 0;       // Routed expert tensors (see moe_profile.h)
+    uint64_t kvBytes = 0;           // KV cache of those blocks
+    uint64_t outputBytes = 0;       // Embedding and output tensors
+    uint64_t computeBytes = 0;      // Graph scratch, one per backend in use
+    uint64_t outputBufferBytes = 0; // Logits returned to the caller (host only)
+
+    uint64_t totalBytes() const {
+        return weightBytes + expertBytes + kvBytes + outputBytes + computeBytes + outputBufferBytes;
+    }
+    bool fits() const { return budgetBytes == 0 || totalBytes() <= budgetBytes; }
+};
+
+struct OffloadPlan {
+    uint32_t gpuLayers = 0;                 // n_gpu_layers (block_count + 1 includes the output layer)
+    std::vector<uint32_t> layerSplit;       // Offloaded layers per device, usable as --tensor-split
+    std::vector<DevicePlacement> devices;   // In the order given
+    DevicePlacement host;                   // Token embeddings, blocks not offloaded, output buffer
+
+    bool fits() const;
+};
+
+// Places a model's tensors the way llama.cpp does with -ngl / -ts: the last
+// n_gpu_layers blocks are offloaded and spread over the devices in order by
+// the cumulative split, the output layer follows once every block is
+// offloaded, and token embeddings stay in host memory. Each block's KV cache
+// sits with its weights. Pure arithmetic over the header's tensor table.
+class OffloadPlanner {
+public:
+    OffloadPlanner(const GGUFModelInfo& info, uint64_t contextSize,
+                   const KVCacheOptions& kvCache = KVCacheOptions(),
+                   const BatchOptions& batch = BatchOptions());
+
+    // Fixed n_gpu_layers. `tensorSplit` gives each device's share (any
+    // scale); empty splits by budget, or evenly when no budget is set.
+    OffloadPlan plan(uint32_t gpuLayers, const std::vector<OffloadDevice>& devices,
+                     std::vector<float> tensorSplit = {}) const;
+
+    // Largest n_gpu_layers that fits every device budget, filling the
+    // devices in order; the resulting per-device layer counts are the split.
+    OffloadPlan planForBudget(const std::vector<OffloadDevice>& devices) const;
+
+    // Keeps the routed experts of the first `blocks` blocks in host memory
+    // wherever the rest of the block goes (llama.cpp --n-cpu-moe; the
+    // default covers every block, like --cpu-moe). Applies to later plans.
+    void keepExpertsOnHost(uint32_t blocks = UINT32_MAX) { hostExpertBlocks = blocks; }
+
+    uint32_t blockCount() const { return static_cast<uint32_t>(layerWeights.size()); }
+    uint64_t blockWeightBytes(uint32_t il) const { return layerWeights[il] + layerExperts[il]; }
+    uint64_t blockExpertBytes(uint32_t il) const { return layerExperts[il]; }
+    uint64_t blockKVBytes(uint32_t il) const { return layerKV[il]; }
+
+private:
+    // Bytes of offloaded item `i` (a block, or the output layer at index blockCount())
+    uint64_t itemBytes(uint32_t i) const;
+
+    std::vector<uint64_t> layerWeights;     // Without routed experts
+    std::vector<uint64_t> layerExperts;
+    std::vector<uint64_t> layerKV;
+    uint64_t inputBytes = 0;        // token_embd and other input-layer tensors
+    uint64_t outputBytes = 0;       // output, output_norm and anything outside blk.N
+    uint64_t tiedOutputBytes = 0;   // token_embd copy for tied embeddings, once the output layer is offloaded
+    uint64_t computeBytes = 0;
+    uint64_t outputBufferBytes = 0;
+    uint32_t hostExpertBlocks = 0;
+};
+
+#endif // OFFLOAD_PLANNER_H
@@ -0,0 +1,30 @@
+#include "probe_stats.h"
+
+#include <ctime>
+
+void ProbeStats::merge(const ProbeStats& other) {
+    if (source.empty())
+        source = other.source;
+    else if (!other.source.empty() && other.source != source)
+        source = "mixed";
+
+    bytesRequested += other.bytesRequested;
+    bytesReceived += other.bytesReceived;
+    bytesUsed += other.bytesUsed;
+    requests += other.requests;
+    discardingSeeks += other.discardingSeeks;
+    if (timeToFirstByteMs < 0)
+        timeToFirstByteMs = other.timeToFirstByteMs;
+    requestMs.insert(requestMs.end(), other.requestMs.begin(), other.requestMs.end());
+    parseCpuMs += other.parseCpuMs;
+    files += other.files;
+}
+
+double threadCpuMs() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return static_cast<double>(ts.tv_sec) * 1e3 + static_cast<double>(ts.tv_nsec) / 1e6;
+#endif
+    return static_cast<double>(std::clock()) * 1e3 / CLOCKS_PER_SEC;
+}
@@ -0,0 +1,43 @@
+#ifndef PROBE_STATS_H
+#define PROBE_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What one header probe cost and where the parser stopped. Filled in by the
+// data sources (I/O counters) and by GGUFMetadataReader (timing, early
+// stop) when a ProbeStats is passed to a read*() call.
+struct ProbeStats {
+    std::string source;             // "file", "mmap", "url", "header-cache"; "profile-cache" when no header was read
+
+    // I/O
+    uint64_t bytesRequested = 0;    // Asked of the source: range lengths (URL) or read sizes (file)
+    uint64_t bytesReceived = 0;     // Delivered by completed requests / reads
+    uint64_t bytesUsed = 0;         // Offset the parser stopped at: header bytes read or skipped
+    uint32_t requests = 0;          // Range requests (URL) or read calls (file)
+    uint32_t discardingSeeks = 0;   // Seeks outside the buffered bytes, which dropped the buffer
+    double timeToFirstByteMs = -1;  // First request, from its start to its first body byte; -1: unknown
+    std::vector<double> requestMs;  // Duration of each completed request, in completion order
+
+    // Time
+    double parseCpuMs = 0;          // CPU time of the probing thread (includes curl work it drives)
+    double wallMs = 0;              // Whole probe
+
+    // Early stop (of the first file, for split models)
+    uint64_t keyCount = 0;          // Metadata entries in the header
+    uint64_t keysScanned = 0;       // Entries read before the scan ended
+    bool stoppedEarly = false;      // Scan ended once the required keys were found
+    std::string stopKey;            // Key that completed the required set; empty without an early stop
+
+    uint32_t files = 0;             // Headers parsed (each shard of a split model counts)
+
+    // Adds the I/O and CPU of another probe (another shard); the early-stop
+    // fields and wallMs are kept
+    void merge(const ProbeStats& other);
+};
+
+// CPU time consumed by the calling thread, in milliseconds
+double threadCpuMs();
+
+#endif // PROBE_STATS_H
@@ -0,0 +1,112 @@
+#include "profile_cache.h"
+
+#ifndef __EMSCRIPTEN__
+
+ProfileCache::ProfileCache(ProfileCacheOptions options) : options(options) {}
+
+ProfileCache::Profile ProfileCache::getOrLoad(const std::string& key, const Loader& load) {
+    std::promise<Profile> promise;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            if (!expired(*it->second)) {
+                lru.splice(lru.begin(), lru, it->second);
+                return it->second->profile;
+            }
+            lru.erase(it->second);
+            index.erase(it);
+        }
+
+        auto pending = inFlight.find(key);
+        if (pending != inFlight.end()) {
+            std::shared_future<Profile> shared = pending->second;
+            lock.unlock();
+            return shared.get();
+        }
+        inFlight.emplace(key, promise.get_future().share());
+    }
+
+    // This caller leads the load; everyone else waits on the shared future
+    Profile profile;
+    try {
+        if (auto loaded = load())
+            profile = std::make_shared<const GGUFModelInfo>(std::move(*loaded));
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight.erase(key);
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight.erase(key);
+        if (profile)
+            insertLocked(key, profile);
+    }
+    promise.set_value(profile);
+    return profile;
+}
+
+ProfileCache::Profile ProfileCache::peek(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end() || expired(*it->second))
+        return nullptr;
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->profile;
+}
+
+void ProfileCache::setOptions(const ProfileCacheOptions& newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+    evictLocked();
+}
+
+void ProfileCache::erase(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end())
+        return;
+    lru.erase(it->second);
+    index.erase(it);
+}
+
+void ProfileCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    index.clear();
+}
+
+size_t ProfileCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lru.size();
+}
+
+bool ProfileCache::expired(const Entry& entry) const {
+    return options.ttlSeconds > 0 &&
+           Clock::now() - entry.loadedAt > std::chrono::seconds(options.ttlSeconds);
+}
+
+void ProfileCache::insertLocked(const std::string& key, Profile profile) {
+    if (options.capacity == 0)
+        return;
+    auto it = index.find(key);
+    if (it != index.end()) {
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    lru.push_front(Entry{key, std::move(profile), Clock::now()});
+    index[key] = lru.begin();
+    evictLocked();
+}
+
+void ProfileCache::evictLocked() {
+    while (lru.size() > options.capacity) {
+        index.erase(lru.back().key);
+        lru.pop_back();
+    }
+}
+
+#endif // __EMSCRIPTEN__
@@ -0,0 +1,68 @@
+#ifndef PROFILE_CACHE_H
+#define PROFILE_CACHE_H
+
+#include "gguf_reader.h"
+
+#ifndef __EMSCRIPTEN__
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Limits for the in-process profile cache
+struct ProfileCacheOptions {
+    size_t capacity = 256;          // Entries kept; least recently used are evicted first. 0: no caching
+    int64_t ttlSeconds = 0;         // Entries older than this are reloaded; 0: never expire
+};
+
+// Thread-safe LRU of parsed model profiles (params, tensor table, file size)
+// keyed by path or URL. Profiles do not depend on context size, so every
+// estimate for the same file shares one parse. Concurrent requests for a key
+// that is still loading wait on the same in-flight future (single flight).
+class ProfileCache {
+public:
+    using Profile = std::shared_ptr<const GGUFModelInfo>;
+    using Loader = std::function<std::optional<GGUFModelInfo>()>;
+
+    explicit ProfileCache(ProfileCacheOptions options = ProfileCacheOptions());
+
+    // Cached profile for `key`, or the result of `load` run once for all
+    // concurrent callers. Returns nullptr when loading fails; failures are not cached.
+    Profile getOrLoad(const std::string& key, const Loader& load);
+
+    // Cached profile only; never loads
+    Profile peek(const std::string& key);
+
+    void setOptions(const ProfileCacheOptions& options);
+    void erase(const std::string& key);
+    void clear();
+    size_t size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string key;
+        Profile profile;
+        Clock::time_point loadedAt;
+    };
+
+    bool expired(const Entry& entry) const;
+    void insertLocked(const std::string& key, Profile profile);
+    void evictLocked();
+
+    ProfileCacheOptions options;
+    mutable std::mutex mutex;
+    std::list<Entry> lru;       // Front: most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::unordered_map<std::string, std::shared_future<Profile>> inFlight;
+};
+
+#endif // __EMSCRIPTEN__
+
+#endif // PROFILE_CACHE_H
@@ -0,0 +1,162 @@
+// Persistent GGUF header cache for the browser, the page-side counterpart of
+// the native HeaderCache (header_cache.h). The header bytes a finished probe
+// parsed are kept in IndexedDB with the validator of the response they came
+// from (ETag, else Last-Modified, else the file size), so a later visit
+// replays them into a GGUFPushParser without any request. Callers check
+// entries in the background with isCurrent(), a one-byte range request.
+//
+// Two object stores: "entries" holds the small per-URL records (validator,
+// sizes, last use) that pruning scans, and "headers" the bytes, which are
+// only read on a hit. The least recently used entries go once the bytes
+// exceed the budget.
+const GGUFHeaderStore = (() => {
+  const DB_NAME = 'gguf-header-cache';
+  const DB_VERSION = 1;
+  const DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+  function request(req) {
+    return new Promise((resolve, reject) => {
+      req.onsuccess = () => resolve(req.result);
+      req.onerror = () => reject(req.error);
+    });
+  }
+
+  function completion(tx) {
+    return new Promise((resolve, reject) => {
+      tx.oncomplete = () => resolve();
+      tx.onerror = tx.onabort = () => reject(tx.error);
+    });
+  }
+
+  // What identifies the bytes of a response: ETag, else Last-Modified, else
+  // the whole-file size (weak, but all some servers give); '' if none
+  function validatorOf(headers, total) {
+    return headers.get('etag') || headers.get('last-modified') || (total ? `size:${total}` : '');
+  }
+
+  class Store {
+    constructor({ budgetBytes = DEFAULT_BUDGET } = {}) {
+      this.budgetBytes = budgetBytes;
+      this.db = null;
+    }
+
+    // Resolves to null where IndexedDB is missing or blocked (private modes),
+    // which turns every method into a no-op
+    open() {
+      if (!this.db) {
+        if (typeof indexedDB === 'undefined') return Promise.resolve(null);
+        const req = indexedDB.open(DB_NAME, DB_VERSION);
+        req.onupgradeneeded = () => {
+          req.result.createObjectStore('entries', { keyPath: 'url' });
+          req.result.createObjectStore('headers');
+        };
+        this.db = request(req).catch(() => null);
+      }
+      return this.db;
+    }
+
+    // { url, validator, total, size, lastUsed, bytes } for `url`, or null
+    async lookup(url) {
+      const db = await this.open();
+      if (!db) return null;
+      try {
+        const tx = db.transaction(['entries', 'headers'], 'readwrite');
+        const done = completion(tx);
+        const entries = tx.objectStore('entries');
+        const entry = await request(entries.get(url));
+        const bytes = entry ? await request(tx.objectStore('headers').get(url)) : undefined;
+        if (entry && bytes) {
+          entry.lastUsed = Date.now();
+          entries.put(entry);
+        } else if (entry) {
+          entries.delete(url);
+        }
+        await done;
+        return entry && bytes ? { ...entry, bytes } : null;
+      } catch (e) {
+        return null;
+      }
+    }
+
+    // Keeps `bytes` (a header prefix starting at offset 0) for `url`. Without
+    // a validator the entry could never be checked, so it is not stored.
+    async store(url, validator, total, bytes) {
+      if (!validator || !bytes.length || bytes.length > this.budgetBytes) return false;
+      const db = await this.open();
+      if (!db) return false;
+      try {
+        const tx = db.transaction(['entries', 'headers'], 'readwrite');
+        const done = completion(tx);
+        tx.objectStore('headers').put(bytes, url);
+        tx.objectStore('entries').put({ url, validator, total, size: bytes.length, lastUsed: Date.now() });
+        await done;
+        await this.prune();
+        return true;
+      } catch (e) {
+        return false;
+      }
+    }
+
+    async evict(url) {
+      const db = await this.open();
+      if (!db) return;
+      try {
+        const tx = db.transaction(['entries', 'headers'], 'readwrite');
+        const done = completion(tx);
+        tx.objectStore('entries').delete(url);
+        tx.objectStore('headers').delete(url);
+        await done;
+      } catch (e) {
+        // Nothing to undo; a stale entry fails revalidation next time
+      }
+    }
+
+    async clear() {
+      const db = await this.open();
+      if (!db) return;
+      const tx = db.transaction(['entries', 'headers'], 'readwrite');
+      const done = completion(tx);
+      tx.objectStore('entries').clear();
+      tx.objectStore('headers').clear();
+      await done;
+    }
+
+    // Drops least recently used entries until the bytes fit the budget
+    async prune() {
+      const db = await this.open();
+      if (!db) return;
+      const tx = db.transaction(['entries', 'headers'], 'readwrite');
+      const done = completion(tx);
+      const entries = await request(tx.objectStore('entries').getAll());
+      let used = entries.reduce((sum, e) => sum + e.size, 0);
+      entries.sort((a, b) => a.lastUsed - b.lastUsed);
+      for (const e of entries) {
+        if (used <= this.budgetBytes) break;
+        tx.objectStore('entries').delete(e.url);
+        tx.objectStore('headers').delete(e.url);
+        used -= e.size;
+      }
+      await done;
+    }
+  }
+
+  // Whether `url` still serves the bytes behind `entry`: one ranged GET past
+  // the HTTP cache, body aborted. Errors other than an HTTP status (offline,
+  // CORS) count as current, so the cached estimate stays usable offline.
+  async function isCurrent(url, entry) {
+    const controller = new AbortController();
+    try {
+      const res = await fetch(url, { headers: { Range: 'bytes=0-0' }, cache: 'no-store', signal: controller.signal });
+      if (!res.ok) return false;
+      const m = (res.headers.get('content-range') || '').match(/\/(\d+)\s*$/);
+      const total = m ? Number(m[1]) : (res.status === 200 ? Number(res.headers.get('content-length')) || 0 : 0);
+      return validatorOf(res.headers, total) === entry.validator;
+    } catch (e) {
+      return true;
+    } finally {
+      controller.abort();
+    }
+  }
+
+  return { Store, validatorOf, isCurrent };
+})();
@@ -0,0 +1,291 @@
+#include "quantization.h"
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Labels in priority order: the first rule whose pattern occurs in the
+// (lowercased) name wins, exactly as a sequence of find() calls would
+struct QuantRule {
+    const char* pattern;
+    bool ud;                        // Also requires "ud-"
+    const char* type;
+    const char* description;
+    int priority;
+};
+
+const QuantRule RULES[] = {
+    {"iq1_s",   true,  "UD-IQ1_S",   "1-bit UD, ultra compact",               1},
+    {"iq1_m",   true,  "UD-IQ1_M",   "1-bit UD, medium variant",              2},
+    {"iq2_xxs", true,  "UD-IQ2_XXS", "2-bit UD, ultra small",                 3},
+    {"iq2_m",   true,  "UD-IQ2_M",   "2-bit UD, balanced",                    4},
+    {"iq3_xxs", true,  "UD-IQ3_XXS", "3-bit UD, very small",                  5},
+    {"q2_k_xl", true,  "UD-Q2_K_XL", "2-bit UD K-quant, very compact",        6},
+    {"q3_k_xl", true,  "UD-Q3_K_XL", "3-bit UD K-quant, compact",             7},
+    {"q4_k_xl", true,  "UD-Q4_K_XL", "4-bit UD K-quant, good quality",        8},
+    {"q5_k_xl", true,  "UD-Q5_K_XL", "5-bit UD K-quant, high quality",        9},
+    {"q6_k_xl", true,  "UD-Q6_K_XL", "6-bit UD K-quant, very high quality",   10},
+    {"q8_k_xl", true,  "UD-Q8_K_XL", "8-bit UD K-quant, maximum quality",     11},
+
+    {"q8_k_xl", false, "Q8_K_XL",    "8-bit K-quant, maximum quality",        12},
+    {"q6_k_xl", false, "Q6_K_XL",    "6-bit K-quant, very high quality",      13},
+    {"q5_k_xl", false, "Q5_K_XL",    "5-bit K-quant, high quality",           14},
+    {"q4_k_xl", false, "Q4_K_XL",    "4-bit K-quant, good quality",           15},
+    {"q3_k_xl", false, "Q3_K_XL",    "3-bit K-quant, compact",                16},
+    {"q2_k_xl", false, "Q2_K_XL",    "2-bit K-quant, very compact",           17},
+
+    {"q8_0",    false, "Q8_0",       "8-bit quant, excellent quality",        18},
+    {"q6_k",    false, "Q6_K",       "6-bit quant, high quality",             19},
+    {"q5_k_m",  false, "Q5_K_M",     "5-bit quant medium, balanced",          20},
+    {"q5_k_s",  false, "Q5_K_S",     "5-bit quant small, compact",            21},
+    {"q5_0",    false, "Q5_0",       "5-bit quant, legacy",                   22},
+
+    {"iq4_nl",  false, "IQ4_NL",     "4-bit improved, very efficient",        23},
+    {"iq4_xs",  false, "IQ4_XS",     "4-bit improved, ultra compact",         24},
+    {"q4_k_m",  false, "Q4_K_M",     "4-bit quant medium, recommended",       25},
+    {"q4_k_l",  false, "Q4_K_L",     "4-bit quant large, better quality",     26},
+    {"q4_k_s",  false, "Q4_K_S",     "4-bit quant small, very compact",       27},
+    {"q4_1",    false, "Q4_1",       "4-bit quant v1, improved legacy",       28},
+    {"q4_0",    false, "Q4_0",       "4-bit quant, legacy",                   29},
+
+    {"iq3_xxs", false, "IQ3_XXS",    "3-bit improved, maximum compression",   30},
+    {"q3_k_l",  false, "Q3_K_L",     "3-bit quant large, experimental",       31},
+    {"q3_k_m",  false, "Q3_K_M",     "3-bit quant medium, very small",        32},
+    {"q3_k_s",  false, "Q3_K_S",     "3-bit quant small, ultra compact",      33},
+
+    {"iq2_xxs", false, "IQ2_XXS",    "2-bit improved, extreme compression",   34},
+    {"iq2_m",   false, "IQ2_M",      "2-bit improved, balanced",              35},
+    {"q2_k_l",  false, "Q2_K_L",     "2-bit quant large, better quality",     36},
+    {"q2_k",    false, "Q2_K",       "2-bit quant, extremely small",          37},
+
+    {"iq1_s",   false, "IQ1_S",      "1-bit improved, experimental",          38},
+    {"iq1_m",   false, "IQ1_M",      "1-bit improved medium, experimental",   39},
+
+    {"f16",     false, "F16",        "16-bit float, highest quality",         40},
+    {"f32",     false, "F32",        "32-bit float, original precision",      41},
+};
+
+constexpr int UNKNOWN_PRIORITY = 42;
+
+// Aho-Corasick automaton over the distinct rule patterns plus "ud-". The
+// alphabet is folded to the characters the patterns use (case-insensitive),
+// so the transition table stays a few kilobytes.
+class QuantMatcher {
+public:
+    QuantMatcher() {
+        classes.fill(0);
+        for (const QuantRule& rule : RULES)
+            rulePatterns.push_back(patternId(rule.pattern));
+        udPattern = patternId("ud-");
+        if (patterns.size() > 64)
+            throw std::logic_error("Too many quantization patterns");
+
+        for (const std::string& pattern : patterns)
+            for (char c : pattern)
+                if (classes[static_cast<unsigned char>(c)] == 0)
+                    classes[static_cast<unsigned char>(c)] = ++classCount;
+        ++classCount;       // Class 0: any other character
+        for (int c = 'A'; c <= 'Z'; ++c)
+            classes[c] = classes[c - 'A' + 'a'];
+
+        build();
+    }
+
+    // Bit i set when pattern i occurs in `text`
+    uint64_t scan(std::string_view text) const {
+        uint64_t found = 0;
+        uint32_t state = 0;
+        for (char c : text) {
+            state = delta[state * classCount + classes[static_cast<unsigned char>(c)]];
+            found |= output[state];
+        }
+        return found;
+    }
+
+    const QuantRule* match(std::string_view filename) const {
+        uint64_t found = scan(filename);
+        bool ud = found & (uint64_t{1} << udPattern);
+        for (size_t r = 0; r < std::size(RULES); ++r) {
+            if ((found & (uint64_t{1} << rulePatterns[r])) && (!RULES[r].ud || ud))
+                return &RULES[r];
+        }
+        return nullptr;
+    }
+
+private:
+    uint32_t patternId(std::string_view pattern) {
+        for (size_t i = 0; i < patterns.size(); ++i)
+            if (patterns[i] == pattern)
+                return static_cast<uint32_t>(i);
+        patterns.emplace_back(pattern);
+        return static_cast<uint32_t>(patterns.size() - 1);
+    }
+
+    void build() {
+        // Trie with goto edges; 0 marks a missing edge (the root is never a target)
+        delta.assign(classCount, 0);
+        output.assign(1, 0);
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            uint32_t state = 0;
+            for (char c : patterns[i]) {
+                uint32_t& next = delta[state * classCount + classes[static_cast<unsigned char>(c)]];
+                if (next == 0) {
+                    next = static_cast<uint32_t>(output.size());
+                    output.push_back(0);
+                    delta.resize(delta.size() + classCount, 0);
+                }
+                state = delta[state * classCount + classes[static_cast<unsigned char>(c)]];
+            }
+            output[state] |= uint64_t{1} << i;
+        }
+
+        // Breadth-first: fill missing edges from the failure state, inherit its outputs
+        std::vector<uint32_t> fail(output.size(), 0);
+        std::vector<uint32_t> queue;
+        for (uint32_t cls = 0; cls < classCount; ++cls)
+            if (uint32_t next = delta[cls])
+                queue.push_back(next);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            uint32_t state = queue[head];
+            output[state] |= output[fail[state]];
+            for (uint32_t cls = 0; cls < classCount; ++cls) {
+                uint32_t& next = delta[state * classCount + cls];
+                uint32_t fallback = delta[fail[state] * classCount + cls];
+                if (next != 0) {
+                    fail[next] = fallback;
+                    queue.push_back(next);
+                } else {
+                    next = fallback;
+                }
+            }
+        }
+    }
+
+    std::vector<std::string> patterns;
+    std::vector<uint32_t> rulePatterns;
+    uint32_t udPattern = 0;
+    std::array<uint8_t, 256> classes;
+    uint32_t classCount = 0;
+    std::vector<uint32_t> delta;        // state * classCount + class -> state
+    std::vector<uint64_t> output;       // Patterns ending at each state
+};
+
+const QuantMatcher& matcher() {
+    static const QuantMatcher instance;
+    return instance;
+}
+
+QuantizationInfo toInfo(const QuantRule& rule) {
+    return QuantizationInfo{rule.type, rule.description, rule.priority};
+}
+
+const QuantRule* ruleForType(std::string_view type) {
+    for (const QuantRule& rule : RULES)
+        if (type == rule.type)
+            return &rule;
+    return nullptr;
+}
+
+bool endsWith(std::string_view s, std::string_view suffix) {
+    return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()) == suffix;
+}
+
+// Whether the filename label names a variant of the header's quant: the
+// same label with a "UD-" prefix, or an _XL / _L mix (Q4_K_XL for Q4_K_M,
+// Q8_K_XL for Q8_0) with the same bit width, which general.file_type has no
+// id for
+bool refines(std::string_view nameType, std::string_view headerType) {
+    if (nameType.substr(0, 3) == "UD-")
+        nameType.remove_prefix(3);
+    if (nameType == headerType)
+        return true;
+    if (!endsWith(nameType, "_XL") && !endsWith(nameType, "_L"))
+        return false;
+    return nameType.substr(0, nameType.find('_')) == headerType.substr(0, headerType.find('_'));
+}
+
+} // namespace
+
+QuantizationInfo quantizationFromFilename(std::string_view filename) {
+    if (const QuantRule* rule = matcher().match(filename))
+        return toInfo(*rule);
+    return QuantizationInfo{"Unknown", "Unknown quantization type", UNKNOWN_PRIORITY};
+}
+
+const char* fileTypeLabel(uint32_t fileType) {
+    // Indexed by llama_ftype; nullptr for removed ids
+    static const char* const labels[] = {
+        "F32", "F16", "Q4_0", "Q4_1", nullptr, nullptr, nullptr, "Q8_0", "Q5_0", "Q5_1",    // 0-9
+        "Q2_K", "Q3_K_S", "Q3_K_M", "Q3_K_L", "Q4_K_S", "Q4_K_M", "Q5_K_S", "Q5_K_M",       // 10-17
+        "Q6_K", "IQ2_XXS", "IQ2_XS", "Q2_K_S", "IQ3_XS", "IQ3_XXS", "IQ1_S", "IQ4_NL",      // 18-25
+        "IQ3_S", "IQ3_M", "IQ2_S", "IQ2_M", "IQ4_XS", "IQ1_M", "BF16", nullptr, nullptr,    // 26-34
+        nullptr, "TQ1_0", "TQ2_0", "MXFP4_MOE",                                             // 35-38
+    };
+    if (fileType >= std::size(labels))
+        return nullptr;
+    return labels[fileType];
+}
+
+std::vector<GGMLTypeShare> tensorTypeHistogram(const GGUFTensorTable& table) {
+    std::vector<GGMLTypeShare> shares;
+    uint64_t total = 0;
+    for (const auto& tensor : table.tensors) {
+        auto it = std::find_if(shares.begin(), shares.end(),
+                               [&](const GGMLTypeShare& share) { return share.type == tensor.type; });
+        if (it == shares.end()) {
+            shares.push_back(GGMLTypeShare{tensor.type, 0, 0.0});
+            it = shares.end() - 1;
+        }
+        it->bytes += tensor.size_bytes;
+        total += tensor.size_bytes;
+    }
+    for (auto& share : shares)
+        share.fraction = total > 0 ? static_cast<double>(share.bytes) / static_cast<double>(total) : 0.0;
+    std::sort(shares.begin(), shares.end(),
+              [](const GGMLTypeShare& a, const GGMLTypeShare& b) { return a.bytes > b.bytes; });
+    return shares;
+}
+
+QuantizationInfo quantizationFromHeader(const GGUFModelInfo& info, std::string_view filename) {
+    QuantizationInfo fromName = quantizationFromFilename(filename);
+
+    if (info.params.file_type) {
+        if (const char* label = fileTypeLabel(*info.params.file_type)) {
+            // The name may carry a variant of the same family the header cannot express
+            if (fromName.priority != UNKNOWN_PRIORITY && refines(fromName.type, label))
+                return fromName;
+            if (const QuantRule* rule = ruleForType(label))
+                return toInfo(*rule);
+            return QuantizationInfo{label, "From general.file_type", UNKNOWN_PRIORITY};
+        }
+    }
+
+    // No usable file_type: the bulk of the quantized weights decides
+    auto shares = tensorTypeHistogram(info.tensorTable);
+    auto quantized = std::find_if(shares.begin(), shares.end(), [](const GGMLTypeShare& share) {
+        return share.type != static_cast<uint32_t>(GGMLType::F32);
+    });
+    if (quantized == shares.end())
+        quantized = shares.begin();
+    if (quantized == shares.end())
+        return fromName;
+
+    const GGMLTypeTraits* traits = ggmlTypeTraits(quantized->type);
+    std::string type = traits ? traits->name : "ggml type " + std::to_string(quantized->type);
+    if (fromName.priority != UNKNOWN_PRIORITY && fromName.type.find(type) != std::string::npos)
+        return fromName;
+
+    std::ostringstream description;
+    description << "Mixed:" << std::fixed << std::setprecision(0);
+    for (size_t i = 0; i < shares.size() && i < 3; ++i) {
+        const GGMLTypeTraits* share = ggmlTypeTraits(shares[i].type);
+        description << (i ? ", " : " ") << shares[i].fraction * 100.0 << "% "
+                    << (share ? share->name : "?");
+    }
+    const QuantRule* rule = ruleForType(type);
+    return QuantizationInfo{type, description.str(), rule ? rule->priority : UNKNOWN_PRIORITY};
+}
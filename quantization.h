@@ -0,0 +1,45 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include "gguf_reader.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Information about quantization type and quality
+ */
+struct QuantizationInfo {
+    std::string type;         ///< Quantization type (e.g., "Q8_0", "Q4_K_M")
+    std::string description;  ///< Human-readable description
+    int priority = 9999;      ///< Priority for default selection (lower = higher priority)
+};
+
+// Quant label from a file name: every known label is found in one
+// case-insensitive pass (an Aho-Corasick automaton compiled on first use),
+// then the lowest-priority label present wins; "UD-" variants need "ud-"
+// anywhere in the name. "Unknown" when nothing matches.
+QuantizationInfo quantizationFromFilename(std::string_view filename);
+
+// Share of tensor bytes per ggml type, largest first
+struct GGMLTypeShare {
+    uint32_t type = 0;              // ggml type id (see GGMLType)
+    uint64_t bytes = 0;
+    double fraction = 0.0;
+};
+
+std::vector<GGMLTypeShare> tensorTypeHistogram(const GGUFTensorTable& table);
+
+// Quant label from a parsed header. general.file_type names the quant; the
+// filename may refine it to a variant of the same family (UD-, _XL, _L),
+// which the header cannot express. Without a known file_type the label is
+// the type holding most bytes among the quantized tensors, and the
+// description lists the mix.
+QuantizationInfo quantizationFromHeader(const GGUFModelInfo& info, std::string_view filename);
+
+// "Q4_K_M" for llama_ftype 15, ...; nullptr for unknown or removed ids
+const char* fileTypeLabel(uint32_t fileType);
+
+#endif // QUANTIZATION_H
@@ -0,0 +1,91 @@
+// CurlMultiLoop shutdown: stop() and stop(easy) racing from several threads
+// against transfers held open by a slow server. Every call must return only
+// once the loop is done with the handles, so each caller frees its handle
+// straight away (run under ASan to catch a loop thread still using one).
+
+#include "bench_support.h"
+#include "curl_multi_loop.h"
+#include "test_support.h"
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+size_t discard(char*, size_t size, size_t count, void*) {
+    return size * count;
+}
+
+CURL* slowTransfer(const std::string& url) {
+    CURL* easy = curl_easy_init();
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, discard);
+    return easy;
+}
+
+bool ready(const std::future<CURLcode>& future) {
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // namespace
+
+int main() {
+    TempDir dir("multi-loop-test");
+    SyntheticSpec spec;
+    spec.keys = 10;
+    spec.vocab = 1000;
+    spec.tensors = 3 + 9 * 4;
+    const std::string path = dir.path("model.gguf");
+    writeSyntheticGGUF(path, spec);
+    RangeServer server(path, 0, 64 * 1024);     // Whole-file GETs that outlast the test
+
+    // One loop per round; each round races 3 stop() against 3 stop(easy)
+    for (int round = 0; round < 20; ++round) {
+        CurlMultiLoop loop;
+        constexpr int TRANSFERS = 3;
+        std::vector<CURL*> handles;
+        std::vector<std::future<CURLcode>> results;
+        for (int i = 0; i < TRANSFERS; ++i) {
+            handles.push_back(slowTransfer(server.url()));
+            results.push_back(loop.start(handles.back()));
+        }
+        // Give some rounds time to connect, so both the queued and running paths race
+        if (round % 2)
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::vector<std::thread> callers;
+        std::vector<int> unfinished(2 * TRANSFERS, 0);
+        for (int i = 0; i < TRANSFERS; ++i) {
+            callers.emplace_back([&, i]() {
+                loop.stop();
+                for (const auto& result : results)
+                    unfinished[i] += !ready(result);
+            });
+            callers.emplace_back([&, i]() {
+                loop.stop(handles[i]);
+                unfinished[TRANSFERS + i] = !ready(results[i]);
+                curl_easy_cleanup(handles[i]);      // The loop must be done with it
+            });
+        }
+        for (std::thread& caller : callers)
+            caller.join();
+
+        for (int count : unfinished)
+            CHECK_EQ(count, 0);
+        for (auto& result : results)
+            CHECK_EQ(result.get(), CURLE_ABORTED_BY_CALLBACK);
+
+        // Stopped for good: starts fail at once, stop() again returns at once
+        CURL* late = slowTransfer(server.url());
+        std::future<CURLcode> refused = loop.start(late);
+        CHECK(ready(refused));
+        CHECK_EQ(refused.get(), CURLE_ABORTED_BY_CALLBACK);
+        loop.stop(late);
+        loop.stop();
+        curl_easy_cleanup(late);
+    }
+
+    return testResult("curl_multi_loop_test");
+}
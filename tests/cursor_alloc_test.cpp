@@ -0,0 +1,87 @@
+// The cursor parse makes no per-field heap allocation: probing a header with
+// 40x the keys and vocabulary must allocate exactly as often as probing a
+// small one, for the streaming file source (buffered cursor), the mmap
+// source and a memory buffer (both parsed in place). What remains is a fixed
+// cost per probe (result, schema state, the file source's read buffer).
+
+#include "bench_support.h"
+#include "test_support.h"
+
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+namespace {
+
+// Allocations of one steady-state probe (after a warm-up probe)
+uint64_t probeAllocations(const std::function<bool()>& probe) {
+    CHECK(probe());
+    resetAllocationCounters();
+    bool ok = probe();
+    uint64_t count = allocationCount();
+    CHECK(ok);
+    return count;
+}
+
+struct Case {
+    const char* source;
+    std::function<bool(const std::string& path)> probe;
+};
+
+} // namespace
+
+int main() {
+    TempDir dir("cursor-alloc-test");
+
+    SyntheticSpec small;
+    small.keys = 50;
+    small.vocab = 1000;
+    small.tensors = 40;
+    SyntheticSpec large = small;
+    large.keys = 2000;
+    large.vocab = 40000;
+    const std::string smallPath = dir.path("small.gguf");
+    const std::string largePath = dir.path("large.gguf");
+    writeSyntheticGGUF(smallPath, small);
+    writeSyntheticGGUF(largePath, large);
+
+    GGUFMetadataReader reader;
+    std::vector<Case> cases = {
+        {"file", [&](const std::string& path) {
+             FileDataSource source(path);
+             auto params = reader.readModelParams(source);
+             return params && params->hidden_size == 4096 && params->attention_heads == 32;
+         }},
+#ifdef GGUF_HAVE_MMAP
+        {"mmap", [&](const std::string& path) {
+             MmapDataSource source(path);
+             auto params = reader.readModelParams(source);
+             return params && params->hidden_size == 4096 && params->attention_heads == 32;
+         }},
+#endif
+    };
+
+    // The buffer source is filled outside the measured probe
+    BufferDataSource smallBuffer, largeBuffer;
+    for (auto [path, buffer] : {std::pair{smallPath, &smallBuffer}, std::pair{largePath, &largeBuffer}}) {
+        std::ifstream in(path, std::ios::binary);
+        std::string prefix(4 * 1024 * 1024, '\0');
+        in.read(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+        buffer->append(prefix.data(), static_cast<size_t>(in.gcount()));
+    }
+    cases.push_back({"buffer", [&](const std::string& path) {
+        BufferDataSource& source = path == smallPath ? smallBuffer : largeBuffer;
+        source.seek(0);
+        auto params = reader.readModelParams(source);
+        return params && params->hidden_size == 4096 && params->attention_heads == 32;
+    }});
+
+    for (const Case& c : cases) {
+        uint64_t smallAllocs = probeAllocations([&]() { return c.probe(smallPath); });
+        uint64_t largeAllocs = probeAllocations([&]() { return c.probe(largePath); });
+        std::cout << c.source << ": " << smallAllocs << " allocations (small header), "
+                  << largeAllocs << " (large header)" << std::endl;
+        CHECK_EQ(largeAllocs, smallAllocs);
+    }
+    return testResult("cursor_alloc_test");
+}
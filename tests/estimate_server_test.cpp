@@ -0,0 +1,280 @@
+// EstimateServer end to end, over TCP and a Unix socket, with a synthetic
+// model behind bench_support's range-serving stand-in: routes, status codes,
+// JSON POST bodies (including malformed ones), keep-alive, and that a
+// repeat estimate is answered from the warm profile cache without touching
+// the model server again.
+
+#include "bench_support.h"
+#include "estimate_server.h"
+#include "test_support.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <thread>
+
+namespace {
+
+struct HttpResponse {
+    int status = 0;
+    std::string head;
+    std::string body;
+};
+
+// One connection to the server; requests are sent as raw text
+class Client {
+public:
+    explicit Client(const std::string& address) {
+        if (address.rfind("unix:", 0) == 0) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::strncpy(addr.sun_path, address.c_str() + 5, sizeof addr.sun_path - 1);
+            fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            connected = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0;
+        } else {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(std::stoi(address.substr(address.rfind(':') + 1))));
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            connected = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0;
+        }
+    }
+    ~Client() { ::close(fd); }
+
+    HttpResponse send(const std::string& request) {
+        HttpResponse response;
+        if (!connected || ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != ssize_t(request.size()))
+            return response;
+        size_t headEnd;
+        while ((headEnd = pending.find("\r\n\r\n")) == std::string::npos)
+            if (!fill())
+                return response;
+        response.head = pending.substr(0, headEnd);
+        pending.erase(0, headEnd + 4);
+        response.status = std::atoi(response.head.c_str() + response.head.find(' ') + 1);
+        size_t length = 0;
+        size_t at = response.head.find("Content-Length: ");
+        if (at != std::string::npos)
+            length = std::strtoull(response.head.c_str() + at + 16, nullptr, 10);
+        if (request.rfind("HEAD ", 0) == 0)
+            length = 0;
+        while (pending.size() < length)
+            if (!fill())
+                return response;
+        response.body = pending.substr(0, length);
+        pending.erase(0, length);
+        return response;
+    }
+
+    HttpResponse get(const std::string& target) {
+        return send("GET " + target + " HTTP/1.1\r\nHost: test\r\n\r\n");
+    }
+
+    HttpResponse post(const std::string& target, const std::string& json) {
+        return send("POST " + target + " HTTP/1.1\r\nHost: test\r\nContent-Type: application/json\r\n"
+                    "Content-Length: " + std::to_string(json.size()) + "\r\n\r\n" + json);
+    }
+
+private:
+    bool fill() {
+        char buffer[4096];
+        ssize_t n = ::recv(fd, buffer, sizeof buffer, 0);
+        if (n <= 0)
+            return false;
+        pending.append(buffer, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd = -1;
+    bool connected = false;
+    std::string pending;
+};
+
+bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+// The estimate fields of a /estimate body: everything before the probe stats
+std::string estimatePart(const std::string& body) {
+    return body.substr(0, body.find(",\"probe\""));
+}
+
+class RunningServer {
+public:
+    explicit RunningServer(const std::string& listen) : server(options(listen)) {
+        server.start();
+        thread = std::thread([this]() { server.run(); });
+    }
+    ~RunningServer() {
+        server.stop();
+        thread.join();
+    }
+    std::string address() const { return server.address(); }
+
+private:
+    static EstimateServerOptions options(const std::string& listen) {
+        EstimateServerOptions options;
+        options.listen = listen;
+        options.idleTimeoutSeconds = 5;
+        return options;
+    }
+
+    EstimateServer server;
+    std::thread thread;
+};
+
+} // namespace
+
+int main() {
+    TempDir dir("estimate-server-test");
+    SyntheticSpec spec;
+    spec.keys = 20;
+    spec.vocab = 2000;
+    spec.tensors = 3 + 9 * 4;
+    const std::string modelPath = dir.path("model.Q4_K_M.gguf");
+    writeSyntheticGGUF(modelPath, spec);
+    RangeServer models(modelPath);
+    const std::string url = models.url();
+
+    RunningServer tcp("127.0.0.1:0");
+    CHECK(tcp.address().rfind("127.0.0.1:", 0) == 0 && tcp.address() != "127.0.0.1:0");
+    Client client(tcp.address());
+
+    // Health, stats, unknown routes, methods
+    HttpResponse health = client.get("/health");
+    CHECK_EQ(health.status, 200);
+    CHECK_EQ(health.body, std::string("{\"ok\":true}\n"));
+    CHECK(contains(health.head, "Server-Timing: estimate;dur="));
+    CHECK(contains(health.head, "Connection: keep-alive"));
+
+    HttpResponse head = client.send("HEAD /health HTTP/1.1\r\nHost: test\r\n\r\n");
+    CHECK_EQ(head.status, 200);
+    CHECK(head.body.empty());
+
+    HttpResponse missing = client.get("/nope");
+    CHECK_EQ(missing.status, 404);
+    CHECK(contains(missing.body, "\"ok\":false"));
+
+    CHECK_EQ(client.send("PUT /estimate HTTP/1.1\r\nHost: test\r\nContent-Length: 0\r\n\r\n").status, 405);
+    CHECK_EQ(client.post("/health", "{}").status, 405);
+
+    // Parameter errors are 400s with a JSON error
+    HttpResponse noModel = client.get("/estimate");
+    CHECK_EQ(noModel.status, 400);
+    CHECK(contains(noModel.body, "model is required"));
+    CHECK_EQ(client.get("/estimate?model=" + url + "&c=abc").status, 400);
+    CHECK_EQ(client.get("/estimate?model=" + url + "&ctk=q9_9").status, 400);
+    CHECK_EQ(client.get("/estimate?model=" + url + "&fa=maybe").status, 400);
+    CHECK_EQ(client.get("/plan?model=" + url).status, 400);
+
+    // A header that cannot be read is a 422
+    HttpResponse unreadable = client.get("/estimate?model=" + dir.path("absent.gguf"));
+    CHECK_EQ(unreadable.status, 422);
+    CHECK(contains(unreadable.body, "\"ok\":false"));
+
+    // One real estimate, then the same from the warm profile cache
+    models.resetCounters();
+    HttpResponse first = client.get("/estimate?model=" + url + "&c=8192");
+    CHECK_EQ(first.status, 200);
+    CHECK(contains(first.body, "\"ok\":true"));
+    CHECK(contains(first.body, "\"quant\":\"Q4_K_M\""));
+    CHECK(contains(first.body, "\"kv_cache_mb\":"));
+    uint64_t probeRequests = models.requests;
+    CHECK(probeRequests > 0);
+
+    HttpResponse repeat = client.get("/estimate?model=" + url + "&c=8192");
+    CHECK_EQ(repeat.status, 200);
+    CHECK_EQ(estimatePart(repeat.body), estimatePart(first.body));
+    CHECK_EQ(models.requests.load(), probeRequests);
+
+    // Another context size changes the KV cache but needs no new probe either
+    HttpResponse longer = client.get("/estimate?model=" + url + "&c=32768");
+    CHECK_EQ(longer.status, 200);
+    CHECK(estimatePart(longer.body) != estimatePart(first.body));
+    CHECK_EQ(models.requests.load(), probeRequests);
+
+    // POST with a JSON body answers like the query string
+    HttpResponse posted = client.post("/estimate", "{\"model\": \"" + url + "\", \"c\": 8192, \"fa\": false}");
+    CHECK_EQ(posted.status, 200);
+    CHECK_EQ(estimatePart(posted.body), estimatePart(first.body));
+    HttpResponse escaped = client.post("/estimate", "{\"model\":\"" + url + "\",\"c\":\"8\\u0031\\u00392\"}");
+    CHECK_EQ(escaped.status, 200);
+    CHECK_EQ(estimatePart(escaped.body), estimatePart(first.body));
+
+    // Malformed JSON and unsupported values are rejected with 400, and the connection stays usable
+    const char* const malformed[] = {
+        "",
+        "{",
+        "{\"model\": ",
+        "{\"model\": \"x\",}",
+        "{\"model\" \"x\"}",
+        "{\"model\": \"unterminated}",
+        "{\"model\": {\"nested\": true}}",
+        "{\"model\": \"x\"} trailing",
+        "[\"model\"]",
+        "{\"c\": 8192, \"model\": \"\\ud800\"}",
+        "{\"devices\": [null]}",
+    };
+    for (const char* body : malformed) {
+        HttpResponse rejected = client.post("/estimate", body);
+        if (rejected.status != 400)
+            std::cerr << "body: " << body << std::endl;
+        CHECK_EQ(rejected.status, 400);
+        CHECK(contains(rejected.body, "\"ok\":false"));
+    }
+    CHECK(contains(client.post("/estimate", "{").body, "invalid JSON body"));
+    CHECK_EQ(client.get("/health").status, 200);
+
+    // Placement: budgets as a list, fixed ngl with a split, and from a JSON body
+    HttpResponse plan = client.get("/plan?model=" + url + "&devices=24000");
+    CHECK_EQ(plan.status, 200);
+    CHECK(contains(plan.body, "\"block_count\":4"));
+    CHECK(contains(plan.body, "\"gpu_layers\":5"));
+    CHECK(contains(plan.body, "\"fits\":true"));
+    HttpResponse split = client.get("/plan?model=" + url + "&devices=a:24000,b:24000&ngl=4&ts=3,1");
+    CHECK_EQ(split.status, 200);
+    CHECK(contains(split.body, "\"tensor_split\":[3,1]"));
+    HttpResponse postedPlan = client.post("/plan", "{\"model\":\"" + url + "\",\"devices\":[\"a:24000\",\"b:24000\"],"
+                                                   "\"ngl\":4,\"ts\":[3,1]}");
+    CHECK_EQ(postedPlan.status, 200);
+    CHECK_EQ(postedPlan.body, split.body);
+    HttpResponse tight = client.get("/plan?model=" + url + "&devices=10");
+    CHECK_EQ(tight.status, 200);
+    CHECK(contains(tight.body, "\"gpu_layers\":0"));
+
+    // Stats count what this connection asked
+    HttpResponse stats = client.get("/stats");
+    CHECK_EQ(stats.status, 200);
+    CHECK(contains(stats.body, "\"requests\":"));
+    CHECK(contains(stats.body, "\"cached_profiles\":"));
+    CHECK(!contains(stats.body, "\"requests\":0,"));
+
+    // Connection: close is honoured
+    HttpResponse closing = client.send("GET /health HTTP/1.1\r\nHost: test\r\nConnection: close\r\n\r\n");
+    CHECK(contains(closing.head, "Connection: close"));
+    CHECK_EQ(client.get("/health").status, 0);
+
+    // Request heads past the limit get a 431
+    Client big(tcp.address());
+    CHECK_EQ(big.send("GET /health HTTP/1.1\r\nX-Filler: " + std::string(20000, 'x') + "\r\n\r\n").status, 431);
+
+    // The same service on a Unix socket
+    {
+        RunningServer unixServer("unix:" + dir.path("mmc.sock"));
+        CHECK_EQ(unixServer.address(), "unix:" + dir.path("mmc.sock"));
+        Client local(unixServer.address());
+        CHECK_EQ(local.get("/health").status, 200);
+        HttpResponse estimate = local.get("/estimate?model=" + url + "&c=8192");
+        CHECK_EQ(estimate.status, 200);
+        CHECK_EQ(estimatePart(estimate.body), estimatePart(first.body));
+        CHECK_EQ(local.post("/estimate", "{\"model\":").status, 400);
+    }
+    CHECK(!std::filesystem::exists(dir.path("mmc.sock")));
+
+    return testResult("estimate_server_test");
+}
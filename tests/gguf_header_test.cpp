@@ -0,0 +1,195 @@
+// Hand-built GGUF headers through GGUFMetadataReader: the model parameters
+// come out the same whichever order the keys are in (the Optional attention
+// keys before or after the Required ones), the tensor-info table computes
+// exact byte sizes, and a table whose sizes or offsets would wrap 64-bit
+// arithmetic is rejected rather than reported with a wrapped size.
+
+#include "gguf_reader.h"
+#include "test_support.h"
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t GGUF_UINT32 = 4;
+constexpr uint32_t GGUF_STRING = 8;
+constexpr uint32_t TYPE_F32 = 0;
+constexpr uint32_t TYPE_Q4_K = 12;
+constexpr uint64_t U64_MAX = std::numeric_limits<uint64_t>::max();
+
+struct Tensor {
+    std::string name;
+    std::vector<uint64_t> dims;
+    uint32_t type;
+    uint64_t offset;
+};
+
+// GGUF v3 header: llama keys in the given order, then the tensor-info table
+class HeaderBuilder {
+public:
+    HeaderBuilder& key(const std::string& name, uint32_t value) {
+        keys.emplace_back(name, [this, value]() { u32(GGUF_UINT32); u32(value); });
+        return *this;
+    }
+    HeaderBuilder& key(const std::string& name, const std::string& value) {
+        keys.emplace_back(name, [this, value]() { u32(GGUF_STRING); str(value); });
+        return *this;
+    }
+    HeaderBuilder& llama() {
+        return key("general.architecture", std::string("llama"))
+            .key("llama.block_count", 2)
+            .key("llama.context_length", 4096)
+            .key("llama.embedding_length", 4096)
+            .key("llama.attention.head_count", 32)
+            .key("llama.attention.head_count_kv", 8);
+    }
+    HeaderBuilder& tensor(Tensor t) {
+        tensors.push_back(std::move(t));
+        return *this;
+    }
+
+    void write(const std::string& path) {
+        bytes.clear();
+        u32(0x46554747);    // "GGUF"
+        u32(3);
+        u64(tensors.size());
+        u64(keys.size());
+        for (auto& [name, value] : keys) {
+            str(name);
+            value();
+        }
+        for (const Tensor& t : tensors) {
+            str(t.name);
+            u32(static_cast<uint32_t>(t.dims.size()));
+            for (uint64_t d : t.dims)
+                u64(d);
+            u32(t.type);
+            u64(t.offset);
+        }
+        bytes.resize((bytes.size() + 31) / 32 * 32, '\0');
+        std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+private:
+    void u32(uint32_t v) { bytes.append(reinterpret_cast<const char*>(&v), sizeof v); }
+    void u64(uint64_t v) { bytes.append(reinterpret_cast<const char*>(&v), sizeof v); }
+    void str(const std::string& s) { u64(s.size()); bytes += s; }
+
+    std::vector<std::pair<std::string, std::function<void()>>> keys;
+    std::vector<Tensor> tensors;
+    std::string bytes;
+};
+
+// Required keys of modelParamsSchema, and the Optional ones the KV estimate reads
+HeaderBuilder& coreKeys(HeaderBuilder& header) {
+    return header.key("llama.block_count", 2)
+        .key("llama.embedding_length", 4096)
+        .key("llama.attention.head_count", 32);
+}
+
+HeaderBuilder& attentionKeys(HeaderBuilder& header) {
+    return header.key("llama.attention.head_count_kv", 8)
+        .key("llama.attention.key_length", 192)
+        .key("llama.attention.value_length", 128)
+        .key("llama.attention.sliding_window", 1024);
+}
+
+std::optional<GGUFModelParams> readParams(HeaderBuilder& header, const std::string& path) {
+    header.write(path);
+    GGUFMetadataReader reader;
+    return reader.readModelParams(path);
+}
+
+std::optional<GGUFModelInfo> readInfo(HeaderBuilder& header, const std::string& path) {
+    header.write(path);
+    GGUFMetadataReader reader;
+    return reader.readModelInfo(path);
+}
+
+} // namespace
+
+int main() {
+    TempDir dir("gguf-header-test");
+    const std::string path = dir.path("model.gguf");
+
+    // ---- Key order: the attention keys before and after the Required ones ----
+    for (bool attentionFirst : {true, false}) {
+        HeaderBuilder header;
+        header.key("general.architecture", std::string("llama"));
+        if (attentionFirst)
+            coreKeys(attentionKeys(header));
+        else
+            attentionKeys(coreKeys(header));
+        header.key("tokenizer.ggml.model", std::string("gpt2"));
+
+        auto params = readParams(header, path);
+        CHECK(params.has_value());
+        if (params) {
+            CHECK_EQ(params->hidden_layers, uint32_t(2));
+            CHECK_EQ(params->attention_heads, uint32_t(32));
+            CHECK_EQ(params->kv_heads, uint32_t(8));
+            CHECK_EQ(params->key_length, uint32_t(192));
+            CHECK_EQ(params->value_length, uint32_t(128));
+            CHECK_EQ(params->sliding_window, uint32_t(1024));
+        }
+    }
+
+    // No head_count_kv: optional, one KV head per query head
+    {
+        HeaderBuilder header;
+        header.key("general.architecture", std::string("llama"));
+        coreKeys(header).key("tokenizer.ggml.model", std::string("gpt2"));
+        auto params = readParams(header, path);
+        CHECK(params.has_value());
+        if (params)
+            CHECK_EQ(params->kv_heads, uint32_t(32));
+    }
+
+    // ---- Tensor sizes ----
+    {
+        HeaderBuilder header;
+        header.llama()
+            .tensor({"blk.0.attn_q.weight", {4096, 4096}, TYPE_Q4_K, 0})
+            .tensor({"blk.0.attn_norm.weight", {4096}, TYPE_F32, 4096 / 256 * 144 * 4096});
+        auto info = readInfo(header, path);
+        CHECK(info.has_value());
+        if (info) {
+            CHECK_EQ(info->tensorTable.tensors.size(), size_t(2));
+            CHECK_EQ(info->tensorTable.tensors[0].size_bytes, uint64_t(4096 / 256 * 144 * 4096));
+            CHECK_EQ(info->tensorTable.tensors[1].size_bytes, uint64_t(4096 * 4));
+            CHECK_EQ(info->tensorTable.weight_bytes, uint64_t(4096 / 256 * 144 * 4096 + 4096 * 4));
+        }
+    }
+
+    // ---- Wrapping arithmetic is rejected ----
+    struct Overflow {
+        const char* what;
+        std::vector<Tensor> tensors;
+    };
+    const Overflow overflows[] = {
+        {"rows",        {{"t", {256, 1ull << 32, 1ull << 32}, TYPE_F32, 0}}},
+        {"row bytes",   {{"t", {1ull << 40, 1ull << 30}, TYPE_F32, 0}}},
+        {"Q4_K bytes",  {{"t", {1ull << 62, 1ull << 8}, TYPE_Q4_K, 0}}},
+        {"offset",      {{"t", {32}, TYPE_F32, U64_MAX - 16}}},
+        {"padding",     {{"t", {(U64_MAX - 3) / 4}, TYPE_F32, 0}}},
+        {"weight sum",  {{"a", {1ull << 61}, TYPE_F32, 0}, {"b", {1ull << 61}, TYPE_F32, 0}}},
+        {"data end",    {{"t", {8}, TYPE_F32, U64_MAX - 63}}},
+    };
+    for (const Overflow& overflow : overflows) {
+        HeaderBuilder header;
+        header.llama();
+        for (const Tensor& t : overflow.tensors)
+            header.tensor(t);
+        if (readInfo(header, path).has_value()) {
+            ++testFailures();
+            std::cerr << "tensor table with wrapping " << overflow.what << " was accepted\n";
+        }
+    }
+
+    return testResult("gguf_header_test");
+}
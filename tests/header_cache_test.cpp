@@ -0,0 +1,126 @@
+// HeaderCache against bench_support's range-serving stand-in: a probe stores
+// the header, a repeat is served with no request, a .header that does not
+// belong to its .meta is evicted, concurrent stores leave no temporaries,
+// and revalidation keeps or drops entries by what the server answered,
+// including a server that ignores Range.
+
+#include "bench_support.h"
+#include "header_cache.h"
+#include "test_support.h"
+
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+size_t filesIn(const std::string& dir, const std::string& extension) {
+    size_t n = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(dir))
+        n += entry.path().extension() == extension;
+    return n;
+}
+
+std::string onlyFile(const std::string& dir, const std::string& extension) {
+    for (const auto& entry : std::filesystem::directory_iterator(dir))
+        if (entry.path().extension() == extension)
+            return entry.path().string();
+    return "";
+}
+
+std::shared_ptr<HeaderCache> cacheIn(const std::string& dir, int64_t maxAgeSeconds) {
+    HeaderCacheOptions options;
+    options.directory = dir;
+    options.maxAgeSeconds = maxAgeSeconds;
+    return std::make_shared<HeaderCache>(options);
+}
+
+bool probe(const std::string& url, const std::shared_ptr<HeaderCache>& cache) {
+    GGUFMetadataReader reader;
+    reader.setHeaderCache(cache);
+    auto info = reader.readModelInfo(url);
+    return info && info->params.hidden_layers == 4;
+}
+
+} // namespace
+
+int main() {
+    TempDir dir("header-cache-test");
+    SyntheticSpec spec;
+    spec.keys = 20;
+    spec.vocab = 2000;
+    spec.tensors = 3 + 9 * 4;
+    const std::string modelPath = dir.path("model.gguf");
+    const uint64_t modelSize = writeSyntheticGGUF(modelPath, spec);
+    RangeServer server(modelPath);
+    const std::string url = server.url();
+
+    // Store, then hit with no request at all
+    const std::string cacheDir = dir.path("cache");
+    auto cache = cacheIn(cacheDir, 3600);
+    CHECK(probe(url, cache));
+    CHECK_EQ(filesIn(cacheDir, ".header"), size_t(1));
+    CHECK_EQ(filesIn(cacheDir, ".meta"), size_t(1));
+    server.resetCounters();
+    CHECK(probe(url, cache));
+    CHECK_EQ(server.requests.load(), uint64_t(0));
+    auto hit = cache->lookup(url);
+    CHECK(hit != nullptr);
+    if (hit)
+        CHECK_EQ(hit->totalSize(), modelSize);
+    hit.reset();
+
+    // A .header of the right size but other bytes is not this .meta's: evicted
+    {
+        std::fstream header(onlyFile(cacheDir, ".header"), std::ios::in | std::ios::out | std::ios::binary);
+        header.seekp(100);
+        header.put('\x7f');
+    }
+    CHECK(cache->lookup(url) == nullptr);
+    CHECK_EQ(filesIn(cacheDir, ".meta"), size_t(0));
+    CHECK_EQ(filesIn(cacheDir, ".header"), size_t(0));
+
+    // Concurrent probes of one URL: one consistent entry, no temporaries left behind
+    {
+        std::vector<std::thread> probes;
+        int ok[8] = {};
+        for (int i = 0; i < 8; ++i)
+            probes.emplace_back([&, i]() { ok[i] = probe(url, cache); });
+        for (std::thread& t : probes)
+            t.join();
+        for (int result : ok)
+            CHECK(result);
+    }
+    CHECK_EQ(filesIn(cacheDir, ".tmp"), size_t(0));
+    CHECK(cache->lookup(url) != nullptr);
+
+    // Always-stale cache: every lookup revalidates
+    auto stale = cacheIn(cacheDir, -1);
+    server.resetCounters();
+    CHECK(stale->lookup(url) != nullptr);
+    CHECK_EQ(server.requests.load(), uint64_t(1));
+
+    // A server that ignores Range answers 200 with the whole file; the
+    // revalidation stops at the headers and the unchanged ETag keeps the entry
+    server.honourRange = false;
+    server.resetCounters();
+    CHECK(stale->lookup(url) != nullptr);
+    CHECK(server.bytesSent.load() < modelSize / 4);
+
+    // Changed file: evicted
+    server.version = 1;
+    CHECK(stale->lookup(url) == nullptr);
+    CHECK_EQ(filesIn(cacheDir, ".meta"), size_t(0));
+    server.honourRange = true;
+
+    // Unreachable server: the stale entry is kept rather than failing the probe
+    std::string goneUrl;
+    {
+        RangeServer gone(modelPath);
+        goneUrl = gone.url();
+        CHECK(probe(goneUrl, cache));
+    }
+    CHECK(stale->lookup(goneUrl) != nullptr);
+
+    return testResult("header_cache_test");
+}
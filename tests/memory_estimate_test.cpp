@@ -0,0 +1,162 @@
+// estimateKVCache and estimateComputeBuffers against byte counts worked out
+// by hand for a llama-style geometry (4096 hidden, 32 heads of 128):
+// grouped-query attention, K and V heads of different widths, quantized
+// cache types (rounded up to whole blocks), sliding-window layers with
+// parallel sequences and the extra micro-batch, layers without KV, and the
+// approximation without heads; then the compute and output buffers with and
+// without flash attention, batch clamping and the missing-size fallbacks.
+
+#include "compute_buffer.h"
+#include "kv_cache.h"
+#include "test_support.h"
+
+namespace {
+
+constexpr uint64_t HIDDEN = 4096;
+constexpr uint32_t HEADS = 32;
+constexpr uint32_t LAYERS = 4;
+
+GGUFModelParams llama(uint32_t kvHeads) {
+    GGUFModelParams params;
+    params.hidden_size = HIDDEN;
+    params.attention_heads = HEADS;
+    params.hidden_layers = LAYERS;
+    params.kv_heads = kvHeads;
+    return params;
+}
+
+void checkKV(const KVCacheEstimate& estimate, uint64_t layerBytes, uint32_t fullLayers) {
+    CHECK_EQ(estimate.bytes, layerBytes * LAYERS);
+    CHECK_EQ(estimate.layerBytes.size(), size_t(LAYERS));
+    for (uint64_t bytes : estimate.layerBytes)
+        CHECK_EQ(bytes, layerBytes);
+    CHECK_EQ(estimate.fullLayers, fullLayers);
+    CHECK_EQ(estimate.slidingLayers, uint32_t(0));
+    CHECK(!estimate.approximate);
+}
+
+} // namespace
+
+int main() {
+    // ---- Head counts ----
+    // GQA: 8 KV heads x 128 = 1024 f16 per K row and per V row, 4 KiB per token
+    checkKV(estimateKVCache(llama(8), 4096), 4096ull * (2048 + 2048), LAYERS);
+    // MHA: 32 KV heads, four times that
+    checkKV(estimateKVCache(llama(32), 4096), 4096ull * (8192 + 8192), LAYERS);
+
+    // ---- key_length != value_length ----
+    // K: 192 x 8 = 1536 f16 = 3072 B; V: 128 x 8 = 1024 f16 = 2048 B
+    {
+        GGUFModelParams params = llama(8);
+        params.key_length = 192;
+        params.value_length = 128;
+        checkKV(estimateKVCache(params, 1000), 1000ull * (3072 + 2048), LAYERS);
+    }
+
+    // ---- Quantized cache types ----
+    // K q8_0: 1024 / 32 blocks x 34 B = 1088 B; V q4_0: 32 blocks x 18 B = 576 B
+    {
+        KVCacheOptions options;
+        options.typeK = GGMLType::Q8_0;
+        options.typeV = GGMLType::Q4_0;
+        checkKV(estimateKVCache(llama(8), 4096, options), 4096ull * (1088 + 576), LAYERS);
+    }
+    // A row that is not a whole number of blocks: 40 values of q8_0 take 2 blocks
+    {
+        GGUFModelParams params = llama(1);
+        params.key_length = 40;
+        params.value_length = 40;
+        KVCacheOptions options;
+        options.typeK = GGMLType::Q8_0;
+        options.typeV = GGMLType::Q8_0;
+        checkKV(estimateKVCache(params, 10, options), 10ull * (68 + 68), LAYERS);
+    }
+    CHECK(parseKVCacheType("Q8_0") == GGMLType::Q8_0);
+    CHECK(parseKVCacheType("f16") == GGMLType::F16);
+    CHECK(!parseKVCacheType("q9_9").has_value());
+
+    // ---- Sliding-window layers ----
+    // Three windowed layers and one global, 2 sequences of 8192, ubatch 512:
+    // global 16384 cells, windowed min(16384, 1024 x 2 + 512) = 2560 cells
+    {
+        GGUFModelParams params = llama(8);
+        params.sliding_window = 1024;
+        params.layer_sliding = {true, true, true, false};
+        auto estimate = estimateKVCache(params, 8192, KVCacheOptions(), 2, 512);
+        CHECK_EQ(estimate.layerBytes[0], 2560ull * 4096);
+        CHECK_EQ(estimate.layerBytes[3], 16384ull * 4096);
+        CHECK_EQ(estimate.bytes, 3 * 2560ull * 4096 + 16384ull * 4096);
+        CHECK_EQ(estimate.slidingLayers, uint32_t(3));
+        CHECK_EQ(estimate.fullLayers, uint32_t(1));
+
+        // A window wider than the context caches the context only
+        params.sliding_window = 16384;
+        estimate = estimateKVCache(params, 1024, KVCacheOptions(), 1, 512);
+        CHECK_EQ(estimate.bytes, 4 * 1024ull * 4096);
+    }
+
+    // ---- Layers without KV (recurrent blocks of a hybrid) ----
+    {
+        GGUFModelParams params = llama(8);
+        params.layer_kv_heads = {8, 0, 8, 0};
+        auto estimate = estimateKVCache(params, 4096);
+        CHECK_EQ(estimate.bytes, 2 * 4096ull * 4096);
+        CHECK_EQ(estimate.layerBytes[1], uint64_t(0));
+        CHECK_EQ(estimate.fullLayers, uint32_t(2));
+    }
+
+    // ---- No head geometry: f16 K and V of hidden_size ----
+    {
+        GGUFModelParams params = llama(8);
+        params.attention_heads = 0;
+        auto estimate = estimateKVCache(params, 4096);
+        CHECK(estimate.approximate);
+        CHECK_EQ(estimate.bytes, 4 * HIDDEN * LAYERS * 4096);
+    }
+
+    // ---- Compute and output buffers ----
+    // Per ubatch token: 3 x 4096 hidden + max(32 heads x 4096 context, 2 x 14336 ffn)
+    // + 32000 logits = 175360 f32; output: 32000 f32 for the one sequence
+    GGUFModelParams params = llama(8);
+    params.feed_forward_length = 14336;
+    params.vocab_size = 32000;
+    {
+        auto estimate = estimateComputeBuffers(params, 4096);
+        CHECK_EQ(estimate.computeBytes, 512ull * 175360 * 4);
+        CHECK_EQ(estimate.outputBytes, 32000ull * 4);
+        CHECK(!estimate.approximate);
+    }
+    // Flash attention: no score matrix, the FFN is the wider sub-layer
+    {
+        BatchOptions options;
+        options.flashAttention = true;
+        auto estimate = estimateComputeBuffers(params, 4096, options);
+        CHECK_EQ(estimate.computeBytes, 512ull * (12288 + 28672 + 32000) * 4);
+    }
+    // The ubatch is clamped to the batch; one logit row per sequence
+    {
+        BatchOptions options;
+        options.batchSize = 256;
+        options.parallel = 4;
+        auto estimate = estimateComputeBuffers(params, 4096, options);
+        CHECK_EQ(estimate.computeBytes, 256ull * 175360 * 4);
+        CHECK_EQ(estimate.outputBytes, 4 * 32000ull * 4);
+    }
+    // More outputs than batch tokens keep one row per token
+    {
+        BatchOptions options;
+        options.outputs = 10000;
+        CHECK_EQ(estimateComputeBuffers(params, 4096, options).outputBytes, 2048 * 32000ull * 4);
+    }
+    // No feed_forward_length (4 x hidden) and no vocab size (no logit terms)
+    {
+        BatchOptions options;
+        options.flashAttention = true;
+        auto estimate = estimateComputeBuffers(llama(8), 4096, options);
+        CHECK(estimate.approximate);
+        CHECK_EQ(estimate.computeBytes, 512ull * (12288 + 2 * 16384) * 4);
+        CHECK_EQ(estimate.outputBytes, uint64_t(0));
+    }
+
+    return testResult("memory_estimate_test");
+}
@@ -0,0 +1,137 @@
+// OffloadPlanner over a synthetic header (bench_support's writer: 4096
+// hidden, Q4_K matrices, F32 norms): per-block sizes against the known
+// tensor layout, -ngl / -ts placement, the output layer, budget search, and
+// conservation of bytes across devices and host for every n_gpu_layers.
+
+#include "bench_support.h"
+#include "offload_planner.h"
+#include "test_support.h"
+
+#include <numeric>
+
+namespace {
+
+constexpr uint64_t HIDDEN = 4096;
+constexpr uint64_t MATRIX = HIDDEN * HIDDEN / 256 * 144;   // Q4_K: 144 bytes per 256 weights
+constexpr uint64_t NORM = HIDDEN * 4;                       // F32
+constexpr uint64_t BLOCK = 7 * MATRIX + 2 * NORM;           // attn q/k/v/output, ffn gate/up/down, 2 norms
+constexpr uint32_t BLOCKS = 4;
+
+uint64_t placedWeights(const OffloadPlan& plan) {
+    uint64_t total = plan.host.weightBytes + plan.host.expertBytes + plan.host.outputBytes;
+    for (const auto& device : plan.devices)
+        total += device.weightBytes + device.expertBytes + device.outputBytes;
+    return total;
+}
+
+uint64_t placedKV(const OffloadPlan& plan) {
+    uint64_t total = plan.host.kvBytes;
+    for (const auto& device : plan.devices)
+        total += device.kvBytes;
+    return total;
+}
+
+} // namespace
+
+int main() {
+    TempDir dir("planner-test");
+    SyntheticSpec spec;
+    spec.keys = 10;
+    spec.vocab = 1000;
+    spec.tensors = 3 + 9 * BLOCKS;      // token_embd, the blocks, output_norm, output
+    const std::string path = dir.path("model.gguf");
+    writeSyntheticGGUF(path, spec);
+
+    GGUFMetadataReader reader;
+    auto info = reader.readModelInfo(path);
+    CHECK(info.has_value());
+    if (!info)
+        return testResult("offload_planner_test");
+
+    const uint64_t context = 4096;
+    OffloadPlanner planner(*info, context);
+    CHECK_EQ(planner.blockCount(), BLOCKS);
+    uint64_t kvTotal = 0;
+    for (uint32_t il = 0; il < BLOCKS; ++il) {
+        CHECK_EQ(planner.blockWeightBytes(il), BLOCK);
+        CHECK_EQ(planner.blockExpertBytes(il), uint64_t(0));
+        // F16 K and V: 8 KV heads of 128 per token
+        CHECK_EQ(planner.blockKVBytes(il), uint64_t(2 * context * 8 * 128 * 2));
+        kvTotal += planner.blockKVBytes(il);
+    }
+
+    OffloadDevice gpu0{"gpu0", 0};
+    OffloadDevice gpu1{"gpu1", 0};
+
+    // ngl 0: everything on the host
+    OffloadPlan none = planner.plan(0, {gpu0});
+    CHECK_EQ(none.gpuLayers, 0u);
+    CHECK_EQ(none.devices.size(), size_t(1));
+    CHECK_EQ(none.devices[0].layerCount, 0u);
+    CHECK_EQ(none.host.layerCount, BLOCKS);
+    CHECK_EQ(none.host.weightBytes, BLOCKS * BLOCK);
+
+    // ngl 2: the last two blocks with their KV; the output layer stays home
+    OffloadPlan two = planner.plan(2, {gpu0});
+    CHECK_EQ(two.devices[0].firstLayer, BLOCKS - 2);
+    CHECK_EQ(two.devices[0].layerCount, 2u);
+    CHECK_EQ(two.devices[0].weightBytes, 2 * BLOCK);
+    CHECK_EQ(two.devices[0].kvBytes, planner.blockKVBytes(2) + planner.blockKVBytes(3));
+    CHECK(!two.devices[0].hasOutput);
+    CHECK(two.host.hasOutput);
+    CHECK_EQ(two.host.layerCount, BLOCKS - 2);
+
+    // ngl = block_count + 1 also offloads output / output_norm; embeddings stay on the host
+    OffloadPlan all = planner.plan(BLOCKS + 1, {gpu0});
+    CHECK(all.devices[0].hasOutput);
+    CHECK_EQ(all.devices[0].outputBytes, MATRIX + NORM);
+    CHECK_EQ(all.host.layerCount, 0u);
+    CHECK_EQ(all.host.outputBytes, HIDDEN * spec.vocab / 256 * 144);    // token_embd
+
+    // -ts 3,1 over four blocks
+    OffloadPlan split = planner.plan(BLOCKS, {gpu0, gpu1}, {3, 1});
+    CHECK_EQ(split.layerSplit.size(), size_t(2));
+    if (split.layerSplit.size() == 2) {
+        CHECK_EQ(split.layerSplit[0], 3u);
+        CHECK_EQ(split.layerSplit[1], 1u);
+    }
+    CHECK_EQ(split.devices[0].firstLayer, 0u);
+    CHECK_EQ(split.devices[1].firstLayer, 3u);
+    CHECK_EQ(split.devices[1].weightBytes, BLOCK);
+
+    // No split and no budgets: even
+    OffloadPlan even = planner.plan(BLOCKS, {gpu0, gpu1});
+    CHECK_EQ(even.devices[0].layerCount, 2u);
+    CHECK_EQ(even.devices[1].layerCount, 2u);
+
+    // Every tensor and every block's KV is placed exactly once, whatever ngl
+    for (uint32_t ngl = 0; ngl <= BLOCKS + 1; ++ngl) {
+        OffloadPlan plan = planner.plan(ngl, {gpu0, gpu1}, {1, 1});
+        CHECK_EQ(placedWeights(plan), info->tensorTable.weight_bytes);
+        CHECK_EQ(placedKV(plan), kvTotal);
+        CHECK_EQ(std::accumulate(plan.layerSplit.begin(), plan.layerSplit.end(), 0u), ngl);   // The output layer counts, as in -ts
+    }
+
+    // Budget search: the exact total of a two-block plan fits two blocks, a byte less only one
+    uint64_t twoBlocks = two.devices[0].totalBytes();
+    OffloadPlan fitted = planner.planForBudget({OffloadDevice{"gpu0", twoBlocks}});
+    CHECK_EQ(fitted.gpuLayers, 2u);
+    CHECK(fitted.fits());
+    OffloadPlan tight = planner.planForBudget({OffloadDevice{"gpu0", twoBlocks - 1}});
+    CHECK_EQ(tight.gpuLayers, 1u);
+    CHECK(tight.fits());
+    OffloadPlan tiny = planner.planForBudget({OffloadDevice{"gpu0", 1}});
+    CHECK_EQ(tiny.gpuLayers, 0u);
+
+    // Two devices fill in order
+    OffloadPlan filled = planner.planForBudget({OffloadDevice{"gpu0", twoBlocks}, OffloadDevice{"gpu1", twoBlocks}});
+    CHECK_EQ(filled.gpuLayers, BLOCKS);
+    CHECK(filled.fits());
+
+    // A plan over budget says so
+    OffloadPlan over = planner.plan(BLOCKS, {OffloadDevice{"gpu0", twoBlocks}});
+    CHECK(!over.fits());
+    CHECK(!over.devices[0].fits());
+
+    return testResult("offload_planner_test");
+}
@@ -0,0 +1,47 @@
+// The default profile cache and local files: a repeat probe of an unchanged
+// file is served from the cache, and a file rewritten in place (same path)
+// is parsed again.
+
+#include "bench_support.h"
+#include "model_file.h"
+#include "test_support.h"
+
+#include <chrono>
+
+namespace {
+
+uint32_t layersOf(const std::string& path) {
+    ModelFile file;
+    file.filename = path;
+    auto info = ModelFileUtils::loadModelInfo(file);
+    return info ? info->params.hidden_layers : 0;
+}
+
+} // namespace
+
+int main() {
+    TempDir dir("profile-cache-test");
+    const std::string path = dir.path("model.gguf");
+    SyntheticSpec spec;
+    spec.keys = 10;
+    spec.vocab = 1000;
+    spec.tensors = 3 + 9 * 4;
+    writeSyntheticGGUF(path, spec);
+
+    auto cache = ModelFileUtils::getProfileCache();
+    CHECK(cache != nullptr);
+    CHECK_EQ(layersOf(path), uint32_t(4));
+    CHECK_EQ(cache->size(), size_t(1));
+    CHECK_EQ(layersOf(path), uint32_t(4));
+    CHECK_EQ(cache->size(), size_t(1));     // Served from the cache
+
+    // Rewritten in place; mtime moved on explicitly so a coarse clock cannot hide it
+    auto written = std::filesystem::last_write_time(path);
+    spec.tensors = 3 + 9 * 6;
+    writeSyntheticGGUF(path, spec);
+    std::filesystem::last_write_time(path, written + std::chrono::seconds(2));
+    CHECK_EQ(layersOf(path), uint32_t(6));
+    CHECK_EQ(layersOf(path), uint32_t(6));
+
+    return testResult("profile_cache_test");
+}
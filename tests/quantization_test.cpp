@@ -0,0 +1,195 @@
+// Quant labels from filenames (the Aho-Corasick matcher) and from parsed
+// headers. Table-driven: overlapping labels, case folding, the UD- variants
+// and the general.file_type / tensor-mix fallbacks; then a differential
+// check of the matcher against a plain find() over the rules in priority
+// order, on random names built from pattern fragments.
+
+#include "quantization.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <cctype>
+#include <random>
+
+namespace {
+
+struct NameCase {
+    const char* filename;
+    const char* type;
+};
+
+const NameCase NAME_CASES[] = {
+    // Longer labels over the shorter ones they contain or overlap
+    {"model.Q4_K_M.gguf",                   "Q4_K_M"},
+    {"model.Q4_K_S.gguf",                   "Q4_K_S"},
+    {"model.Q4_K_L.gguf",                   "Q4_K_L"},
+    {"model.Q4_K.gguf",                     "Unknown"},     // No bare Q4_K label
+    {"model.Q2_K.gguf",                     "Q2_K"},
+    {"model.Q2_K_L.gguf",                   "Q2_K_L"},
+    {"model.IQ4_XS.gguf",                   "IQ4_XS"},
+    {"model.IQ4_NL.gguf",                   "IQ4_NL"},
+    {"model.IQ2_XXS.gguf",                  "IQ2_XXS"},
+    {"model.IQ3_XXS.gguf",                  "IQ3_XXS"},
+    {"model.Q5_K_M.gguf",                   "Q5_K_M"},
+    {"model.Q5_0.gguf",                     "Q5_0"},
+    {"model.Q8_0.gguf",                     "Q8_0"},
+    {"model.F16.gguf",                      "F16"},
+    {"model-f32.gguf",                      "F32"},
+    // Partial matches that fall back through failure links
+    {"model.q4_k_q4_k_m.gguf",              "Q4_K_M"},
+    {"model.q4_k_xq4_k_s.gguf",             "Q4_K_S"},
+    {"model.iiq4_nl.gguf",                  "IQ4_NL"},
+    {"model.q8_k_x.gguf",                   "Unknown"},
+    // Case-insensitive
+    {"MODEL.q4_k_m.GGUF",                   "Q4_K_M"},
+    {"Model.Iq4_Xs.gguf",                   "IQ4_XS"},
+    // _XL mixes, with and without the UD- prefix anywhere in the name
+    {"model-Q4_K_XL.gguf",                  "Q4_K_XL"},
+    {"model-UD-Q4_K_XL.gguf",               "UD-Q4_K_XL"},
+    {"ud-model.q3_k_xl.gguf",               "UD-Q3_K_XL"},
+    {"Qwen3-30B-A3B-Instruct-2507-UD-Q4_K_XL.gguf", "UD-Q4_K_XL"},
+    {"model-UD-IQ1_S.gguf",                 "UD-IQ1_S"},
+    {"model-IQ1_S.gguf",                    "IQ1_S"},
+    // Several labels: the lower priority value wins, wherever it occurs
+    {"model-Q4_K_M-Q8_0.gguf",              "Q8_0"},
+    {"model-Q4_K_M-f16-embed.gguf",         "Q4_K_M"},
+    {"model-IQ4_NL-IQ4_XS.gguf",            "IQ4_NL"},
+    // Nothing known
+    {"model.gguf",                          "Unknown"},
+    {"",                                    "Unknown"},
+};
+
+GGUFModelInfo headerWithFileType(uint32_t fileType) {
+    GGUFModelInfo info;
+    info.params.file_type = fileType;
+    return info;
+}
+
+GGUFModelInfo headerWithTensors(std::initializer_list<std::pair<GGMLType, uint64_t>> tensors) {
+    GGUFModelInfo info;
+    for (const auto& [type, bytes] : tensors) {
+        GGUFTensorInfo tensor;
+        tensor.type = static_cast<uint32_t>(type);
+        tensor.size_bytes = bytes;
+        info.tensorTable.tensors.push_back(tensor);
+    }
+    return info;
+}
+
+struct HeaderCase {
+    const char* what;
+    GGUFModelInfo info;
+    const char* filename;
+    const char* type;
+};
+
+// The rules in priority order, as (pattern, needs "ud-", label): the spec the
+// matcher must reproduce
+struct OracleRule {
+    const char* pattern;
+    bool ud;
+    const char* type;
+};
+
+const OracleRule ORACLE[] = {
+    {"iq1_s", true, "UD-IQ1_S"},     {"iq1_m", true, "UD-IQ1_M"},     {"iq2_xxs", true, "UD-IQ2_XXS"},
+    {"iq2_m", true, "UD-IQ2_M"},     {"iq3_xxs", true, "UD-IQ3_XXS"}, {"q2_k_xl", true, "UD-Q2_K_XL"},
+    {"q3_k_xl", true, "UD-Q3_K_XL"}, {"q4_k_xl", true, "UD-Q4_K_XL"}, {"q5_k_xl", true, "UD-Q5_K_XL"},
+    {"q6_k_xl", true, "UD-Q6_K_XL"}, {"q8_k_xl", true, "UD-Q8_K_XL"},
+    {"q8_k_xl", false, "Q8_K_XL"},   {"q6_k_xl", false, "Q6_K_XL"},   {"q5_k_xl", false, "Q5_K_XL"},
+    {"q4_k_xl", false, "Q4_K_XL"},   {"q3_k_xl", false, "Q3_K_XL"},   {"q2_k_xl", false, "Q2_K_XL"},
+    {"q8_0", false, "Q8_0"},         {"q6_k", false, "Q6_K"},         {"q5_k_m", false, "Q5_K_M"},
+    {"q5_k_s", false, "Q5_K_S"},     {"q5_0", false, "Q5_0"},         {"iq4_nl", false, "IQ4_NL"},
+    {"iq4_xs", false, "IQ4_XS"},     {"q4_k_m", false, "Q4_K_M"},     {"q4_k_l", false, "Q4_K_L"},
+    {"q4_k_s", false, "Q4_K_S"},     {"q4_1", false, "Q4_1"},         {"q4_0", false, "Q4_0"},
+    {"iq3_xxs", false, "IQ3_XXS"},   {"q3_k_l", false, "Q3_K_L"},     {"q3_k_m", false, "Q3_K_M"},
+    {"q3_k_s", false, "Q3_K_S"},     {"iq2_xxs", false, "IQ2_XXS"},   {"iq2_m", false, "IQ2_M"},
+    {"q2_k_l", false, "Q2_K_L"},     {"q2_k", false, "Q2_K"},         {"iq1_s", false, "IQ1_S"},
+    {"iq1_m", false, "IQ1_M"},       {"f16", false, "F16"},           {"f32", false, "F32"},
+};
+
+std::string oracle(std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    bool ud = name.find("ud-") != std::string::npos;
+    for (const OracleRule& rule : ORACLE)
+        if ((!rule.ud || ud) && name.find(rule.pattern) != std::string::npos)
+            return rule.type;
+    return "Unknown";
+}
+
+} // namespace
+
+int main() {
+    for (const NameCase& c : NAME_CASES) {
+        std::string type = quantizationFromFilename(c.filename).type;
+        if (type != c.type)
+            std::cerr << "filename \"" << c.filename << "\"" << std::endl;
+        CHECK_EQ(type, std::string(c.type));
+        CHECK_EQ(oracle(c.filename), std::string(c.type));
+    }
+
+    // Priorities follow the rule order; Unknown sorts last
+    CHECK(quantizationFromFilename("a.Q8_0.gguf").priority < quantizationFromFilename("a.Q4_K_M.gguf").priority);
+    CHECK(quantizationFromFilename("a.F32.gguf").priority < quantizationFromFilename("a.gguf").priority);
+
+    const HeaderCase HEADER_CASES[] = {
+        // general.file_type wins over a different label in the name
+        {"file_type over name",        headerWithFileType(15), "model.Q8_0.gguf",       "Q4_K_M"},
+        {"file_type, no label",        headerWithFileType(7),  "model.gguf",            "Q8_0"},
+        {"IQ4_XS is not IQ4_NL",       headerWithFileType(30), "model.IQ4_NL.gguf",     "IQ4_XS"},
+        // ...unless the name is a variant of the same quant the header cannot express
+        {"UD- variant refines",        headerWithFileType(15), "model-UD-Q4_K_XL.gguf", "UD-Q4_K_XL"},
+        {"_XL refines Q8_0",           headerWithFileType(7),  "model-Q8_K_XL.gguf",    "Q8_K_XL"},
+        {"_L refines Q4_K_M",          headerWithFileType(15), "model.Q4_K_L.gguf",     "Q4_K_L"},
+        {"other bit width is no variant", headerWithFileType(15), "model-Q5_K_XL.gguf", "Q4_K_M"},
+        // A file_type with no rule keeps the header's label
+        {"file_type without a rule",   headerWithFileType(20), "model.gguf",            "IQ2_XS"},
+        // Unknown or removed file_type: the tensor mix decides, names of that family win
+        {"removed file_type, name",    headerWithFileType(4),  "model.Q4_K_M.gguf",     "Q4_K_M"},
+        {"tensor mix",
+         headerWithTensors({{GGMLType::F32, 900}, {GGMLType::Q4_K, 800}, {GGMLType::Q6_K, 200}}),
+         "model.gguf", "Q4_K"},
+        {"tensor mix, name of that family",
+         headerWithTensors({{GGMLType::Q4_K, 800}, {GGMLType::Q6_K, 200}}),
+         "model.Q4_K_M.gguf", "Q4_K_M"},
+        {"tensor mix, other name",
+         headerWithTensors({{GGMLType::Q6_K, 800}, {GGMLType::Q4_K, 200}}),
+         "model.Q4_K_M.gguf", "Q6_K"},
+        {"only F32 tensors",           headerWithTensors({{GGMLType::F32, 100}}), "model.gguf", "F32"},
+        // Nothing in the header: the filename is all there is
+        {"empty header",               GGUFModelInfo(),        "model.IQ4_NL.gguf",     "IQ4_NL"},
+        {"empty header, no label",     GGUFModelInfo(),        "model.gguf",            "Unknown"},
+    };
+    for (const HeaderCase& c : HEADER_CASES) {
+        QuantizationInfo info = quantizationFromHeader(c.info, c.filename);
+        if (info.type != c.type)
+            std::cerr << "header case: " << c.what << std::endl;
+        CHECK_EQ(info.type, std::string(c.type));
+    }
+    QuantizationInfo mixed = quantizationFromHeader(
+        headerWithTensors({{GGMLType::Q4_K, 750}, {GGMLType::Q6_K, 250}}), "model.gguf");
+    CHECK_EQ(mixed.description, std::string("Mixed: 75% Q4_K, 25% Q6_K"));
+
+    // Random names from overlapping fragments: the automaton must agree with find()
+    const char* const fragments[] = {
+        "q", "iq", "ud-", "UD-", "_", "k", "K", "_k", "_m", "_s", "_l", "_xl", "_x", "xs", "xxs", "nl",
+        "1", "2", "3", "4", "5", "6", "8", "0", "f1", "f16", "f3", "2", "-", ".", "gguf", "q4_k", "iq4_",
+    };
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<size_t> pick(0, std::size(fragments) - 1);
+    std::uniform_int_distribution<int> length(1, 12);
+    int mismatches = 0;
+    for (int i = 0; i < 20000; ++i) {
+        std::string name;
+        for (int n = length(rng); n > 0; --n)
+            name += fragments[pick(rng)];
+        std::string expected = oracle(name);
+        std::string actual = quantizationFromFilename(name).type;
+        if (actual != expected && ++mismatches <= 5)
+            std::cerr << "\"" << name << "\": matcher " << actual << ", find() " << expected << std::endl;
+    }
+    CHECK_EQ(mismatches, 0);
+
+    return testResult("quantization_test");
+}
@@ -0,0 +1,72 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+// Minimal checks for the test executables: a failed CHECK prints where and
+// why, and testResult() turns the failure count into the exit code ctest reads.
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            ++testFailures();                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n";  \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                      \
+    do {                                                                                \
+        const auto& checkActual = (actual);                                             \
+        const auto& checkExpected = (expected);                                         \
+        if (!(checkActual == checkExpected)) {                                          \
+            ++testFailures();                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", " #expected \
+                      << ") failed: " << checkActual << " != " << checkExpected << "\n"; \
+        }                                                                               \
+    } while (0)
+
+inline int testResult(const char* name) {
+    if (testFailures() == 0) {
+        std::cout << name << ": all checks passed" << std::endl;
+        return 0;
+    }
+    std::cerr << name << ": " << testFailures() << " check(s) failed" << std::endl;
+    return 1;
+}
+
+// Directory under the system temp dir, removed with everything in it
+class TempDir {
+public:
+    explicit TempDir(const std::string& prefix) {
+        std::string pattern = (std::filesystem::temp_directory_path() / (prefix + "-XXXXXX")).string();
+        if (!::mkdtemp(pattern.data()))
+            throw std::runtime_error("Cannot create a temp directory from " + pattern);
+        root = pattern;
+    }
+    ~TempDir() {
+        std::error_code ignored;
+        std::filesystem::remove_all(root, ignored);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    std::string path(const std::string& name) const { return (root / name).string(); }
+    const std::filesystem::path& dir() const { return root; }
+
+private:
+    std::filesystem::path root;
+};
+
+#endif // TEST_SUPPORT_H
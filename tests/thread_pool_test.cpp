@@ -0,0 +1,86 @@
+// ThreadPool worker accounting: a burst of tasks that can only finish
+// together (a rendezvous) must get one worker each up to the limit, also
+// when idle workers are already around, and after the limit is lowered
+// (workers retire and are joined) and raised again.
+
+#include "test_support.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Tasks that wait for each other; each reports whether all of them met
+class Rendezvous {
+public:
+    explicit Rendezvous(size_t parties) : parties(parties) {}
+
+    bool arrive() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (++arrived == parties)
+            met.notify_all();
+        return met.wait_for(lock, std::chrono::seconds(5), [this]() { return arrived >= parties; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable met;
+    size_t parties;
+    size_t arrived = 0;
+};
+
+bool burstMeets(ThreadPool& pool, size_t parties) {
+    Rendezvous rendezvous(parties);
+    std::vector<std::future<bool>> results;
+    for (size_t i = 0; i < parties; ++i)
+        results.push_back(pool.submit(0, [&rendezvous]() { return rendezvous.arrive(); }));
+    bool all = true;
+    for (auto& result : results)
+        all = result.get() && all;
+    return all;
+}
+
+void settle() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+} // namespace
+
+int main() {
+    ThreadPool pool(4);
+
+    // From cold
+    CHECK(burstMeets(pool, 4));
+
+    // With idle workers: they take part of the burst, new ones the rest
+    for (int round = 0; round < 5; ++round) {
+        pool.setMaxThreads(8);
+        pool.submit(0, []() {}).get();
+        settle();
+        CHECK(burstMeets(pool, 8));
+    }
+
+    // Lowered: the extra workers retire; one still runs everything in order
+    pool.setMaxThreads(1);
+    settle();
+    std::vector<int> order;
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < 16; ++i)
+        done.push_back(pool.submit(0, [&order, i]() { order.push_back(i); }));
+    for (auto& d : done)
+        d.get();
+    CHECK_EQ(order.size(), size_t(16));
+    for (size_t i = 0; i < order.size(); ++i)
+        CHECK_EQ(order[i], int(i));
+
+    // Raised again: a burst gets its workers back
+    pool.setMaxThreads(6);
+    CHECK(burstMeets(pool, 6));
+
+    return testResult("thread_pool_test");
+}
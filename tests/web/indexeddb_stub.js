@@ -0,0 +1,78 @@
+// In-memory IndexedDB with the slice of the API header_store.js uses:
+// open / upgrade, transactions that complete once their requests settle,
+// and get / put / delete / clear / getAll on object stores. Values are
+// structured-cloned as in a browser.
+const databases = {};
+
+function request(run) {
+  const req = { onsuccess: null, onerror: null, result: undefined, error: null };
+  req.run = () => {
+    try {
+      req.result = run();
+      setTimeout(() => req.onsuccess && req.onsuccess());
+    } catch (e) {
+      req.error = e;
+      setTimeout(() => req.onerror && req.onerror());
+    }
+  };
+  return req;
+}
+
+class Transaction {
+  constructor(db) {
+    this.db = db;
+    this.pending = 0;
+    this.done = false;
+    this.oncomplete = this.onerror = this.onabort = null;
+    setTimeout(() => this.settle(), 5);
+  }
+
+  settle() {
+    if (this.pending === 0 && !this.done) {
+      this.done = true;
+      if (this.oncomplete) this.oncomplete();
+    }
+  }
+
+  objectStore(name) {
+    if (this.done) throw new Error('TransactionInactiveError');
+    const store = this.db.stores[name];
+    const queue = (run) => {
+      const req = request(run);
+      this.pending++;
+      setTimeout(() => {
+        req.run();
+        this.pending--;
+        setTimeout(() => this.settle(), 2);
+      });
+      return req;
+    };
+    const clone = (v) => (v === undefined ? v : structuredClone(v));
+    return {
+      get: (key) => queue(() => clone(store.map.get(key))),
+      put: (value, key) => queue(() => { store.map.set(store.keyPath ? value[store.keyPath] : key, clone(value)); }),
+      delete: (key) => queue(() => { store.map.delete(key); }),
+      clear: () => queue(() => store.map.clear()),
+      getAll: () => queue(() => [...store.map.values()].map(clone)),
+    };
+  }
+}
+
+globalThis.indexedDB = {
+  open(name) {
+    const req = request(() => databases[name]);
+    setTimeout(() => {
+      if (!databases[name]) {
+        databases[name] = {
+          stores: {},
+          createObjectStore(store, { keyPath } = {}) { this.stores[store] = { map: new Map(), keyPath }; },
+          transaction() { return new Transaction(this); },
+        };
+        req.result = databases[name];
+        if (req.onupgradeneeded) req.onupgradeneeded();
+      }
+      req.run();
+    });
+    return req;
+  },
+};
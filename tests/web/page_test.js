@@ -0,0 +1,173 @@
+// public/index.html in Node, against a gguf_reader.js / .wasm built from
+// this tree: the page script runs as is (DOM and IndexedDB stubbed) and
+// probes a synthetic model over a local range server. Each visit is a fresh
+// page sharing one IndexedDB, so a second visit must be served from it
+// without a request.
+//
+//   node page_test.js [module dir]      (default: public/)
+//
+// ctest runs it on the module the build makes with emcc (CMakeLists.txt).
+
+const assert = require('assert');
+const fs = require('fs');
+const http = require('http');
+const path = require('path');
+const vm = require('vm');
+
+const PUBLIC = path.join(__dirname, '..', '..', 'public');
+const MODULE_DIR = path.resolve(process.argv[2] || PUBLIC);
+
+// ---- Synthetic GGUF: llama keys behind a vocab big enough for several fetches ----
+// An F32 output matrix takes the file past 4 GiB, where 32-bit sizes would wrap.
+const HIDDEN = 4096;
+const LAYERS = 2;
+const VOCAB = 60000;
+const OUTPUT_ROWS = 270000;
+
+function syntheticHeader() {
+  const parts = [];
+  const u32 = (v) => { const b = Buffer.alloc(4); b.writeUInt32LE(v); parts.push(b); };
+  const u64 = (v) => { const b = Buffer.alloc(8); b.writeBigUInt64LE(BigInt(v)); parts.push(b); };
+  const str = (s) => { u64(Buffer.byteLength(s)); parts.push(Buffer.from(s)); };
+  const keyU32 = (k, v) => { str(k); u32(4); u32(v); };
+
+  u32(0x46554747);                            // "GGUF"
+  u32(3);
+  u64(2);                                     // Tensors
+  u64(7);                                     // Keys
+  str('general.architecture'); u32(8); str('llama');
+  str('tokenizer.ggml.tokens'); u32(9); u32(8); u64(VOCAB);
+  for (let i = 0; i < VOCAB; i++) str(`token-${i}`);
+  keyU32('llama.block_count', LAYERS);
+  keyU32('llama.context_length', 4096);
+  keyU32('llama.embedding_length', HIDDEN);
+  keyU32('llama.attention.head_count', 32);
+  keyU32('llama.attention.head_count_kv', 8);
+
+  const embedBytes = HIDDEN * VOCAB * 4;
+  const outputBytes = HIDDEN * OUTPUT_ROWS * 4;
+  str('token_embd.weight'); u32(2); u64(HIDDEN); u64(VOCAB); u32(0); u64(0);             // F32
+  str('output.weight'); u32(2); u64(HIDDEN); u64(OUTPUT_ROWS); u32(0); u64(embedBytes);
+  const header = Buffer.concat(parts);
+  const padded = Buffer.alloc(Math.ceil(header.length / 32) * 32);
+  header.copy(padded);
+  return { header: padded, weights: embedBytes + outputBytes, total: padded.length + embedBytes + outputBytes };
+}
+
+// ---- Range server: the header, then zeros up to `total` ----
+function rangeServer({ header, total }) {
+  const server = http.createServer((req, res) => {
+    server.requests++;
+    const m = /^bytes=(\d+)-(\d*)$/.exec(req.headers.range || '');
+    if (!m) {
+      res.writeHead(200, { 'Content-Length': total, ETag: server.etag });
+      return res.end();           // Headers only: no test reads a whole model
+    }
+    const first = Number(m[1]);
+    const last = Math.min(m[2] ? Number(m[2]) : total - 1, total - 1);
+    const body = Buffer.alloc(last - first + 1);
+    if (first < header.length) header.copy(body, 0, first, Math.min(header.length, last + 1));
+    server.bytesSent += body.length;
+    res.writeHead(206, {
+      'Content-Length': body.length,
+      'Content-Range': `bytes ${first}-${last}/${total}`,
+      'Accept-Ranges': 'bytes',
+      ETag: server.etag,
+    });
+    res.end(body);
+  });
+  server.requests = 0;
+  server.bytesSent = 0;
+  server.etag = '"v1"';
+  return new Promise((resolve) => server.listen(0, '127.0.0.1', () => resolve(server)));
+}
+
+// ---- A page visit: a new global scope running its scripts in order, then the inline one ----
+require('./indexeddb_stub.js');
+const html = fs.readFileSync(path.join(PUBLIC, 'index.html'), 'utf8');
+const wasmBinary = fs.readFileSync(path.join(MODULE_DIR, 'gguf_reader.wasm'));
+
+function visitPage() {
+  const elements = {};
+  const document = {
+    getElementById: (id) => elements[id] || (elements[id] = {
+      textContent: '', innerHTML: '', value: '', checked: false, files: null,
+      addEventListener() {}, appendChild() {},
+    }),
+    createElement: () => ({ textContent: '' }),
+  };
+  const context = vm.createContext({
+    document, indexedDB, fetch, performance, console, URL, TextDecoder, AbortController,
+    structuredClone, setTimeout, clearTimeout,
+  });
+  for (const [, src] of html.matchAll(/<script src="([^"]+)"><\/script>/g)) {
+    const dir = src === 'gguf_reader.js' ? MODULE_DIR : PUBLIC;
+    vm.runInContext(fs.readFileSync(path.join(dir, src), 'utf8'), context, { filename: src });
+  }
+  // No script URL to find the .wasm from in Node: hand it over
+  const createModule = context.createGGUF;
+  context.createGGUF = (arg = {}) => createModule({ wasmBinary, ...arg });
+
+  const inline = html.match(/<script>([\s\S]*)<\/script>/)[1];
+  vm.runInContext(inline, context, { filename: 'index.html' });
+  return vm.runInContext('({ estimate, estimateUrl, headerStore, modulePromise, GGUFHeaderStore })', context);
+}
+
+async function main() {
+  const model = syntheticHeader();
+  const server = await rangeServer(model);
+  const url = `http://127.0.0.1:${server.address().port}/model.gguf`;
+  const page = visitPage();
+
+  // The C++ core itself: the page refuses a module without the push parser
+  const Module = await page.modulePromise;
+  assert.ok(!Module.usingFallback, 'module is a JavaScript stand-in');
+  assert.strictEqual(typeof Module.GGUFPushParser, 'function');
+  assert.strictEqual(typeof Module.calcMemoryFromHeader, 'function');
+
+  // First visit: the header over the network
+  const first = await page.estimateUrl(url, 'model.gguf', 4096);
+  assert.ok(first.hasEstimate, 'estimate from the URL');
+  assert.ok(server.requests > 1, 'header read in several ranges');
+  assert.ok(first.probe.bytesUsed > 256 * 1024 && first.probe.bytesUsed <= model.header.length);
+  assert.ok(first.kvCacheMB > 0);
+
+  // Over 4 GiB: the size from Content-Range and the MB figures stay exact
+  assert.ok(model.total > 2 ** 32);
+  assert.strictEqual(first.fileSizeBytes, model.total);
+  assert.ok(first.modelSizeMB >= Math.floor(model.weights / 1e6), `modelSizeMB ${first.modelSizeMB}`);
+  assert.ok(first.modelSizeMB <= Math.floor(model.total / 1e6), `modelSizeMB ${first.modelSizeMB}`);
+  assert.ok(first.totalRequiredMB > 4295);
+
+  // A local file through the same parser
+  const local = await page.estimate('model.gguf', async (start, length) => ({
+    bytes: new Uint8Array(model.header.subarray(start, start + length)),
+    total: model.total,
+  }), 4096);
+  assert.ok(local.hasEstimate, 'estimate from a local file');
+  assert.strictEqual(local.modelSizeMB, first.modelSizeMB);
+
+  // Second visit: the header comes from IndexedDB, with no request at all
+  const again = visitPage();
+  const requestsBefore = server.requests;
+  const cached = await again.estimateUrl(url, 'model.gguf', 4096);
+  assert.strictEqual(server.requests, requestsBefore, 'no ranged request on the second visit');
+  assert.ok(cached.hasEstimate && cached.fromCache, 'estimate from the stored header');
+  assert.strictEqual(cached.modelSizeMB, first.modelSizeMB);
+  assert.strictEqual(cached.kvCacheMB, first.kvCacheMB);
+  assert.strictEqual(cached.fileSizeBytes, model.total);
+
+  // The background check is one request; a new ETag means the stored header is stale
+  assert.strictEqual(await again.GGUFHeaderStore.isCurrent(url, cached.fromCache), true);
+  assert.strictEqual(server.requests, requestsBefore + 1);
+  server.etag = '"v2"';
+  assert.strictEqual(await again.GGUFHeaderStore.isCurrent(url, cached.fromCache), false);
+
+  server.close();
+  console.log('page_test: all checks passed');
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(1);
+});
@@ -0,0 +1,97 @@
+#include "thread_pool.h"
+
+#ifndef __EMSCRIPTEN__
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t maxThreads) : limit(std::max<size_t>(1, maxThreads)) {}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        // Queued tasks are dropped; their futures report broken_promise
+        tasks = decltype(tasks)();
+    }
+    wake.notify_all();
+    for (auto& t : threads)
+        if (t.joinable())
+            t.join();
+    joinRetired();
+}
+
+size_t ThreadPool::defaultConcurrency() {
+    // Probes are network-bound; a handful in flight saturates a mirror without flooding it
+    return 8;
+}
+
+void ThreadPool::setMaxThreads(size_t maxThreads) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        limit = std::max<size_t>(1, maxThreads);
+    }
+    wake.notify_all();
+}
+
+size_t ThreadPool::maxThreads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return limit;
+}
+
+void ThreadPool::enqueue(int priority, std::function<void()> run) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(Task{priority, nextSequence++, std::move(run)});
+        // One worker per queued task nobody is waiting to take. A new worker
+        // counts as idle from here, so a burst of submits before it gets
+        // scheduled does not all land on it.
+        while (tasks.size() > idle && running < limit) {
+            ++running;
+            ++idle;
+            threads.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+    wake.notify_one();
+    joinRetired();
+}
+
+void ThreadPool::joinRetired() {
+    std::vector<std::thread> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.swap(retired);
+    }
+    // Each has already let go of the mutex on its way out
+    for (auto& t : done)
+        t.join();
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || !tasks.empty() || running > limit; });
+        --idle;
+        if (stopping)
+            return;
+        if (running > limit) {
+            // Hand this thread's handle to the next submit to join; the
+            // destructor joins what is still in threads
+            --running;
+            auto self = std::find_if(threads.begin(), threads.end(), [](const std::thread& t) {
+                return t.get_id() == std::this_thread::get_id();
+            });
+            retired.push_back(std::move(*self));
+            threads.erase(self);
+            return;
+        }
+
+        std::function<void()> run = std::move(const_cast<Task&>(tasks.top()).run);
+        tasks.pop();
+        lock.unlock();
+        run();
+        lock.lock();
+        ++idle;
+    }
+}
+
+#endif // __EMSCRIPTEN__
@@ -0,0 +1,75 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#ifndef __EMSCRIPTEN__
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Bounded thread pool for probe work. Workers are started lazily up to
+// maxThreads and pull from one shared queue ordered by priority (lower value
+// runs first, matching QuantizationInfo::priority), FIFO within a priority.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t maxThreads = defaultConcurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static size_t defaultConcurrency();
+
+    // Raising the limit takes effect on the next submit; lowering it retires
+    // idle workers as they finish their current task.
+    void setMaxThreads(size_t maxThreads);
+    size_t maxThreads() const;
+
+    template <typename F>
+    auto submit(int priority, F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> future = task->get_future();
+        enqueue(priority, [task]() { (*task)(); });
+        return future;
+    }
+
+private:
+    struct Task {
+        int priority;
+        uint64_t sequence;
+        std::function<void()> run;
+    };
+    struct LaterFirst {
+        bool operator()(const Task& a, const Task& b) const {
+            if (a.priority != b.priority) return a.priority > b.priority;
+            return a.sequence > b.sequence;
+        }
+    };
+
+    void enqueue(int priority, std::function<void()> run);
+    void joinRetired();
+    void workerLoop();
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::priority_queue<Task, std::vector<Task>, LaterFirst> tasks;
+    std::vector<std::thread> threads;
+    std::vector<std::thread> retired;   // Exited over the limit, not joined yet
+    size_t limit;
+    size_t running = 0;         // Live workers
+    size_t idle = 0;            // Live workers not running a task
+    uint64_t nextSequence = 0;
+    bool stopping = false;
+};
+
+#endif // __EMSCRIPTEN__
+
+#endif // THREAD_POOL_H